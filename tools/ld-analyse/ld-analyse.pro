@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -45,12 +45,15 @@ SOURCES += \
     ../ld-chroma-decoder/transformpal.cpp \
     ../ld-chroma-decoder/transformpal2d.cpp \
     ../ld-chroma-decoder/transformpal3d.cpp \
+    ../ld-chroma-decoder/transformpal3dcache.cpp \
     ../ld-chroma-decoder/framecanvas.cpp \
     ../ld-chroma-decoder/opticalflow.cpp \
     ../ld-chroma-decoder/sourcefield.cpp \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/sourcevideo.cpp \
     ../library/tbc/vbidecoder.cpp \
+    ../library/tbc/sidecarcache.cpp \
+    ../library/tbc/vbiframeindex.cpp \
     ../library/tbc/filters.cpp \
     ../library/tbc/logging.cpp
 
@@ -75,6 +78,7 @@ HEADERS += \
     ../ld-chroma-decoder/transformpal.h \
     ../ld-chroma-decoder/transformpal2d.h \
     ../ld-chroma-decoder/transformpal3d.h \
+    ../ld-chroma-decoder/transformpal3dcache.h \
     ../ld-chroma-decoder/framecanvas.h \
     ../ld-chroma-decoder/yiqbuffer.h \
     ../ld-chroma-decoder/opticalflow.h \
@@ -83,6 +87,8 @@ HEADERS += \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/sourcevideo.h \
     ../library/tbc/vbidecoder.h \
+    ../library/tbc/sidecarcache.h \
+    ../library/tbc/vbiframeindex.h \
     ../library/tbc/filters.h \
     ../library/tbc/logging.h
 
@@ -51,6 +51,12 @@ MainWindow::MainWindow(QString inputFilenameParam, QWidget *parent) :
     // Set the initial frame number
     currentFrameNumber = 1;
 
+    // Set up the timer used to replace preview images with full-quality frames
+    showingPreview = false;
+    fullQualityTimer.setSingleShot(true);
+    fullQualityTimer.setInterval(250);
+    connect(&fullQualityTimer, &QTimer::timeout, this, &MainWindow::fullQualityTimerHandler);
+
     // Connect to the scan line changed signal from the oscilloscope dialogue
     connect(oscilloscopeDialog, &OscilloscopeDialog::scanLineChanged, this, &MainWindow::scanLineChangedSignalHandler);
     lastScopeLine = 1;
@@ -268,9 +274,12 @@ void MainWindow::updateGuiUnloaded()
 
 // Frame display methods ----------------------------------------------------------------------------------------------
 
-// Method to display a sequential frame
-void MainWindow::showFrame()
+// Method to display a sequential frame (preview = true to show a fast,
+// low-resolution preview of the frame)
+void MainWindow::showFrame(bool preview)
 {
+    showingPreview = preview;
+
     // Show the field numbers
     fieldNumberStatus.setText(" -  Fields: " + QString::number(tbcSource.getFirstFieldNumber(currentFrameNumber)) + "/" +
                               QString::number(tbcSource.getSecondFieldNumber(currentFrameNumber)));
@@ -299,7 +308,7 @@ void MainWindow::showFrame()
     updateFrameViewer();
 
     // If the scope window is open, update it too (using the last scope line selected by the user)
-    if (oscilloscopeDialog->isVisible()) {
+    if (oscilloscopeDialog->isVisible() && !preview) {
         // Show the oscilloscope dialogue for the selected scan-line
         updateOscilloscopeDialogue(lastScopeLine, lastScopeDot);
     }
@@ -317,7 +326,9 @@ void MainWindow::showFrame()
 // Redraw the frame viewer (for example, when scaleFactor has been changed)
 void MainWindow::updateFrameViewer()
 {
-    QImage frameImage = tbcSource.getFrameImage(currentFrameNumber);
+    QImage frameImage;
+    if (showingPreview) frameImage = tbcSource.getFramePreviewImage(currentFrameNumber);
+    else frameImage = tbcSource.getFrameImage(currentFrameNumber);
 
     if (ui->mouseModePushButton->isChecked()) {
         // Create a painter object
@@ -605,10 +616,24 @@ void MainWindow::on_frameHorizontalSlider_valueChanged(int value)
     // otherwisew we just ignore this
     if (ui->frameNumberSpinBox->isEnabled()) {
         ui->frameNumberSpinBox->setValue(currentFrameNumber);
-        showFrame();
+
+        if (ui->frameHorizontalSlider->isSliderDown()) {
+            // The user is scrubbing; show a preview, and the full frame once the slider stops
+            showFrame(true);
+            fullQualityTimer.start();
+        } else {
+            fullQualityTimer.stop();
+            showFrame();
+        }
     }
 }
 
+// Frame slider has been released
+void MainWindow::on_frameHorizontalSlider_sliderReleased()
+{
+    fullQualityTimerHandler();
+}
+
 // Source/Chroma select button clicked
 void MainWindow::on_videoPushButton_clicked()
 {
@@ -823,6 +848,13 @@ void MainWindow::palConfigurationChangedSignalHandler()
     updateFrameViewer();
 }
 
+// Replace a preview image with the full-quality frame
+void MainWindow::fullQualityTimerHandler()
+{
+    fullQualityTimer.stop();
+    if (showingPreview && tbcSource.getIsSourceLoaded()) showFrame();
+}
+
 // TbcSource class signal handlers ------------------------------------------------------------------------------------
 
 // Signal handler for busyLoading signal from TbcSource class
@@ -33,6 +33,7 @@
 #include <QMessageBox>
 #include <QLabel>
 #include <QMouseEvent>
+#include <QTimer>
 
 #include "oscilloscopedialog.h"
 #include "aboutdialog.h"
@@ -85,6 +86,7 @@ private slots:
     void on_startFramePushButton_clicked();
     void on_frameNumberSpinBox_editingFinished();
     void on_frameHorizontalSlider_valueChanged(int value);
+    void on_frameHorizontalSlider_sliderReleased();
     void on_videoPushButton_clicked();
     void on_dropoutsPushButton_clicked();
     void on_fieldOrderPushButton_clicked();
@@ -98,6 +100,7 @@ private slots:
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
     void palConfigurationChangedSignalHandler();
+    void fullQualityTimerHandler();
 
     // Tbc Source signal handlers
     void on_busyLoading(QString infoMessage);
@@ -129,12 +132,17 @@ private:
     QPalette buttonPalette;
     QString lastFilename;
 
+    // Preview images are shown while scrubbing with the frame slider, until
+    // the slider is released or stops moving
+    bool showingPreview;
+    QTimer fullQualityTimer;
+
     // Update GUI methods
     void updateGuiLoaded();
     void updateGuiUnloaded();
 
     // Frame display methods
-    void showFrame();
+    void showFrame(bool preview = false);
     void updateFrameViewer();
     void hideFrame();
 
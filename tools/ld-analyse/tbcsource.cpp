@@ -24,8 +24,28 @@
 
 #include "tbcsource.h"
 
+#include "sidecarcache.h"
 #include "sourcefield.h"
 
+// Number of frames to decode ahead of the current frame, in the direction of navigation
+static const qint32 DECODE_AHEAD_FRAMES = 4;
+
+// Maximum number of rendered frames to keep in the cache
+static const qint32 FRAME_CACHE_SIZE = 24;
+
+// Maximum number of fields to keep dropout line indexes for
+static const qint32 DROPOUT_INDEX_CACHE_SIZE = 8;
+
+// Horizontal subsampling of preview images
+static const qint32 PREVIEW_SAMPLE_STEP = 2;
+
+// Number of data points in the graphs
+static const qint32 GRAPH_DATA_POINTS = 2000;
+
+// Sidecar summary cache file identification
+static const quint32 SUMMARY_CACHE_MAGIC = 0x4C445355; // "LDSU"
+static const quint32 SUMMARY_CACHE_VERSION = 2;
+
 TbcSource::TbcSource(QObject *parent) : QObject(parent)
 {
     // Default frame image options
@@ -35,12 +55,26 @@ TbcSource::TbcSource(QObject *parent) : QObject(parent)
     reverseFoOn = false;
     sourceReady = false;
     fieldsPerGraphDataPoint = 0;
-    frameCacheFrameNumber = -1;
 
     // Set the PALcolour configuration to default
     palColourConfiguration = palColour.getConfiguration();
     palColourConfiguration.chromaFilter = PalColour::transform2DFilter;
-    decoderConfigurationChanged = false;
+
+    // Set up the frame cache and the decode-ahead workers (leaving a thread
+    // free for the GUI)
+    frameCache.setMaxCost(FRAME_CACHE_SIZE);
+    dropoutIndexCache.setMaxCost(DROPOUT_INDEX_CACHE_SIZE);
+    cacheGeneration = 0;
+    decoderGeneration = 0;
+    lastRequestedFrameNumber = -1;
+    decodeAheadDirection = 1;
+    decodeAheadPool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, DECODE_AHEAD_FRAMES));
+}
+
+TbcSource::~TbcSource()
+{
+    stopDecodeAhead();
+    qDeleteAll(idleWorkerDecoders);
 }
 
 // Public methods -----------------------------------------------------------------------------------------------------
@@ -55,7 +89,13 @@ void TbcSource::loadSource(QString sourceFilename)
     reverseFoOn = false;
     sourceReady = false;
     fieldsPerGraphDataPoint = 0;
-    frameCacheFrameNumber = -1;
+
+    // Discard any frames and dropout indexes from the previous source
+    stopDecodeAhead();
+    dropoutIndexCache.clear();
+    lastRequestedFrameNumber = -1;
+    decodeAheadDirection = 1;
+    decoderGeneration++;
 
     // Set the current file name
     QFileInfo inFileInfo(sourceFilename);
@@ -72,6 +112,7 @@ void TbcSource::loadSource(QString sourceFilename)
 // Method to unload a TBC source file
 void TbcSource::unloadSource()
 {
+    stopDecodeAhead();
     sourceVideo.close();
     sourceReady = false;
 }
@@ -93,14 +134,14 @@ QString TbcSource::getCurrentSourceFilename()
 // Method to set the highlight dropouts mode (true = dropouts highlighted)
 void TbcSource::setHighlightDropouts(bool _state)
 {
-    frameCacheFrameNumber = -1;
+    invalidateFrameCache();
     dropoutsOn = _state;
 }
 
 // Method to set the chroma decoder mode (true = on)
 void TbcSource::setChromaDecoder(bool _state)
 {
-    frameCacheFrameNumber = -1;
+    invalidateFrameCache();
     chromaOn = _state;
 
     // Turn off LPF if chroma is selected
@@ -110,7 +151,7 @@ void TbcSource::setChromaDecoder(bool _state)
 // Method to set the LPF mode (true = on)
 void TbcSource::setLpfMode(bool _state)
 {
-    frameCacheFrameNumber = -1;
+    invalidateFrameCache();
     lpfOn = _state;
 
     // Turn off chroma if LPF is selected
@@ -120,7 +161,7 @@ void TbcSource::setLpfMode(bool _state)
 // Method to set the field order (true = reversed, false = normal)
 void TbcSource::setFieldOrder(bool _state)
 {
-    frameCacheFrameNumber = -1;
+    invalidateFrameCache();
     reverseFoOn = _state;
 
     if (reverseFoOn) ldDecodeMetaData.setIsFirstFieldFirst(false);
@@ -156,70 +197,89 @@ QImage TbcSource::getFrameImage(qint32 frameNumber)
 {
     if (!sourceReady) return QImage();
 
-    // Check cached QImage
-    if (frameCacheFrameNumber == frameNumber && !decoderConfigurationChanged) return frameCache;
-    else {
-        frameCacheFrameNumber = frameNumber;
-        decoderConfigurationChanged = false;
-    }
+    QImage frameImage;
+    {
+        QMutexLocker locker(&cacheMutex);
 
-    // Get the required field numbers
-    qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
-    qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
+        // If the frame is being decoded ahead, wait for it rather than decoding it again
+        while (pendingFrames.contains(frameNumber)) frameRendered.wait(&cacheMutex);
 
-    // Make sure we have a valid response from the frame determination
-    if (firstFieldNumber == -1 || secondFieldNumber == -1) {
-        qCritical() << "Could not determine field numbers!";
+        // Check for a cached QImage
+        QImage *cachedImage = frameCache.object(frameNumber);
+        if (cachedImage != nullptr) frameImage = *cachedImage;
+    }
 
-        // Jump back one frame
-        if (frameNumber != 1) {
-            frameNumber--;
+    if (frameImage.isNull()) {
+        frameImage = renderFrameImage(makeFrameRequest(frameNumber), palColour, ntscColour);
 
-            firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
-            secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
-        }
-        qDebug() << "TbcSource::getFrameImage(): Jumping back one frame due to error";
+        QMutexLocker locker(&cacheMutex);
+        frameCache.insert(frameNumber, new QImage(frameImage));
     }
 
-    // Get a QImage for the frame
-    QImage frameImage = generateQImage(firstFieldNumber, secondFieldNumber);
+    // Start decoding the frames the user is likely to look at next
+    startDecodeAhead(frameNumber);
 
-    // Get the field metadata
-    LdDecodeMetaData::Field firstField = ldDecodeMetaData.getField(firstFieldNumber);
-    LdDecodeMetaData::Field secondField = ldDecodeMetaData.getField(secondFieldNumber);
+    return frameImage;
+}
 
-    // Highlight dropouts
-    if (dropoutsOn) {
-        // Create a painter object
-        QPainter imagePainter;
-        imagePainter.begin(&frameImage);
+// Method to get a low-resolution QImage from a frame number, for use while
+// the user is scrubbing through the source. This only reads the first field,
+// uses every other sample, and shows luma only (with the chroma removed by
+// averaging over one subcarrier cycle) in place of chroma decoding or
+// filtering. If the full frame image is already cached, that is returned.
+QImage TbcSource::getFramePreviewImage(qint32 frameNumber)
+{
+    if (!sourceReady) return QImage();
 
-        // Draw the drop out data for the first field
-        imagePainter.setPen(Qt::red);
-        for (qint32 dropOutIndex = 0; dropOutIndex < firstField.dropOuts.startx.size(); dropOutIndex++) {
-            qint32 startx = firstField.dropOuts.startx[dropOutIndex];
-            qint32 endx = firstField.dropOuts.endx[dropOutIndex];
-            qint32 fieldLine = firstField.dropOuts.fieldLine[dropOutIndex];
+    {
+        QMutexLocker locker(&cacheMutex);
+        QImage *cachedImage = frameCache.object(frameNumber);
+        if (cachedImage != nullptr) return *cachedImage;
+    }
 
-            imagePainter.drawLine(startx, ((fieldLine - 1) * 2), endx, ((fieldLine - 1) * 2));
-        }
+    qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
+    if (firstFieldNumber == -1) return getFrameImage(frameNumber);
 
-        // Draw the drop out data for the second field
-        imagePainter.setPen(Qt::blue);
-        for (qint32 dropOutIndex = 0; dropOutIndex < secondField.dropOuts.startx.size(); dropOutIndex++) {
-            qint32 startx = secondField.dropOuts.startx[dropOutIndex];
-            qint32 endx = secondField.dropOuts.endx[dropOutIndex];
-            qint32 fieldLine = secondField.dropOuts.fieldLine[dropOutIndex];
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    const qint32 fieldWidth = videoParameters.fieldWidth;
+    const qint32 previewWidth = fieldWidth / PREVIEW_SAMPLE_STEP;
+
+    SourceVideo::Data fieldData = getVideoField(firstFieldNumber);
+    const quint16 *fieldPointer = fieldData.constData();
+
+    // Fixed-point scale from the black-white range to 0-255 (for luma)
+    const bool showLuma = chromaOn || lpfOn;
+    const qint32 blackLevel = videoParameters.black16bIre;
+    const qint32 whiteLevel = qMax(videoParameters.white16bIre, blackLevel + 1);
+    const qint32 lumaScale = (255 << 16) / (whiteLevel - blackLevel);
+
+    QImage previewImage(previewWidth, videoParameters.fieldHeight, QImage::Format_RGB888);
+    for (qint32 y = 0; y < videoParameters.fieldHeight; y++) {
+        const quint16 *fieldLine = fieldPointer + (y * fieldWidth);
+        uchar *imageLine = previewImage.scanLine(y);
+
+        for (qint32 x = 0; x < previewWidth; x++) {
+            qint32 sourceX = x * PREVIEW_SAMPLE_STEP;
+            qint32 pixelValue;
+
+            if (showLuma) {
+                // The samples are at 4fSC, so four consecutive samples cover one subcarrier cycle
+                sourceX = qMin(sourceX, fieldWidth - 4);
+                qint32 luma = (fieldLine[sourceX] + fieldLine[sourceX + 1] + fieldLine[sourceX + 2] + fieldLine[sourceX + 3]) / 4;
+                pixelValue = qBound(0, ((luma - blackLevel) * lumaScale) >> 16, 255);
+            } else {
+                // Take just the MSB of the input data
+                pixelValue = fieldLine[sourceX] >> 8;
+            }
 
-            imagePainter.drawLine(startx, ((fieldLine - 1) * 2) + 1, endx, ((fieldLine - 1) * 2) + 1);
+            imageLine[(x * 3) + 0] = static_cast<uchar>(pixelValue); // R
+            imageLine[(x * 3) + 1] = static_cast<uchar>(pixelValue); // G
+            imageLine[(x * 3) + 2] = static_cast<uchar>(pixelValue); // B
         }
-
-        // End the painter object
-        imagePainter.end();
     }
 
-    frameCache = frameImage;
-    return frameImage;
+    // Scale the image up to the size of a frame, so it can be displayed in its place
+    return previewImage.scaled(fieldWidth, (videoParameters.fieldHeight * 2) - 1, Qt::IgnoreAspectRatio, Qt::FastTransformation);
 }
 
 // Method to get the number of available frames
@@ -355,28 +415,24 @@ TbcSource::ScanLineData TbcSource::getScanLineData(qint32 frameNumber, qint32 sc
     scanLineData.activeVideoEnd = videoParameters.activeVideoEnd;
     scanLineData.isSourcePal = videoParameters.isSourcePal;
 
-    // Get the field video and dropout data
-    SourceVideo::Data fieldData;
-    LdDecodeMetaData::DropOuts dropouts;
-    if (isFieldTop) {
-        fieldData = sourceVideo.getVideoField(firstFieldNumber);
-        dropouts = ldDecodeMetaData.getFieldDropOuts(firstFieldNumber);
-    } else {
-        fieldData = sourceVideo.getVideoField(secondFieldNumber);
-        dropouts = ldDecodeMetaData.getFieldDropOuts(secondFieldNumber);
-    }
+    // Get the video data for just the required field line (frame data is numbered 0-624 or 0-524)
+    qint32 fieldNumber = isFieldTop ? firstFieldNumber : secondFieldNumber;
+    SourceVideo::Data lineData = getVideoField(fieldNumber, fieldLine, fieldLine);
 
     scanLineData.data.resize(videoParameters.fieldWidth);
-    scanLineData.isDropout.resize(videoParameters.fieldWidth);
     for (qint32 xPosition = 0; xPosition < videoParameters.fieldWidth; xPosition++) {
-        // Get the 16-bit YC value for the current pixel (frame data is numbered 0-624 or 0-524)
-        scanLineData.data[xPosition] = fieldData[((fieldLine - 1) * videoParameters.fieldWidth) + xPosition];
+        // Get the 16-bit YC value for the current pixel
+        scanLineData.data[xPosition] = lineData[xPosition];
+    }
 
-        scanLineData.isDropout[xPosition] = false;
-        for (qint32 doCount = 0; doCount < dropouts.startx.size(); doCount++) {
-            if (dropouts.fieldLine[doCount] == fieldLine) {
-                if (xPosition >= dropouts.startx[doCount] && xPosition <= dropouts.endx[doCount]) scanLineData.isDropout[xPosition] = true;
-            }
+    // Mark the dropouts on the field line
+    scanLineData.isDropout.fill(false, videoParameters.fieldWidth);
+    const DropoutLineIndex &dropoutIndex = getDropoutLineIndex(fieldNumber, videoParameters.fieldHeight);
+    if (fieldLine >= 1 && fieldLine <= videoParameters.fieldHeight) {
+        for (qint32 doCount = dropoutIndex.lineStart[fieldLine]; doCount < dropoutIndex.lineStart[fieldLine + 1]; doCount++) {
+            qint32 startx = qMax(dropoutIndex.dropOuts.startx[doCount], 0);
+            qint32 endx = qMin(dropoutIndex.dropOuts.endx[doCount], videoParameters.fieldWidth - 1);
+            for (qint32 xPosition = startx; xPosition <= endx; xPosition++) scanLineData.isDropout[xPosition] = true;
         }
     }
 
@@ -456,9 +512,12 @@ void TbcSource::setPalColourConfiguration(const PalColour::Configuration &_palCo
     palColourConfiguration = _palColourConfiguration;
 
     // Configure the chroma decoder
-    palColour.updateConfiguration(ldDecodeMetaData.getVideoParameters(), palColourConfiguration);
+    QMutexLocker locker(&decoderConfigurationMutex);
+    palColour.updateConfiguration(ldDecodeMetaData.getVideoParameters(), getForegroundPalColourConfiguration());
+    locker.unlock();
 
-    decoderConfigurationChanged = true;
+    decoderGeneration++;
+    invalidateFrameCache();
 }
 
 const PalColour::Configuration &TbcSource::getPalColourConfiguration()
@@ -466,6 +525,16 @@ const PalColour::Configuration &TbcSource::getPalColourConfiguration()
     return palColourConfiguration;
 }
 
+// Return the configuration for the foreground PALcolour decoder. The frame
+// being displayed is decoded using all the available threads to minimise
+// latency; the decode-ahead workers use one thread each.
+PalColour::Configuration TbcSource::getForegroundPalColourConfiguration()
+{
+    PalColour::Configuration configuration = palColourConfiguration;
+    configuration.intraFrameThreads = QThread::idealThreadCount();
+    return configuration;
+}
+
 // Return the frame number of the start of the next chapter
 qint32 TbcSource::startOfNextChapter(qint32 currentFrameNumber)
 {
@@ -513,21 +582,105 @@ qint32 TbcSource::startOfChapter(qint32 currentFrameNumber)
 
 // Private methods ----------------------------------------------------------------------------------------------------
 
+// Method to capture the field numbers, metadata and options needed to render a frame
+TbcSource::FrameRequest TbcSource::makeFrameRequest(qint32 frameNumber)
+{
+    FrameRequest request;
+    request.frameNumber = frameNumber;
+
+    // Get the required field numbers
+    request.firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
+    request.secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
+
+    // Make sure we have a valid response from the frame determination
+    if (request.firstFieldNumber == -1 || request.secondFieldNumber == -1) {
+        qCritical() << "Could not determine field numbers!";
+
+        // Jump back one frame
+        if (frameNumber != 1) {
+            request.firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber - 1);
+            request.secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber - 1);
+        }
+        qDebug() << "TbcSource::makeFrameRequest(): Jumping back one frame due to error";
+    }
+
+    // Get the field metadata
+    request.firstField = ldDecodeMetaData.getField(request.firstFieldNumber);
+    request.secondField = ldDecodeMetaData.getField(request.secondFieldNumber);
+    request.videoParameters = ldDecodeMetaData.getVideoParameters();
+    request.palColourConfiguration = palColourConfiguration;
+
+    // Get the frame image options
+    request.chromaOn = chromaOn;
+    request.lpfOn = lpfOn;
+    request.dropoutsOn = dropoutsOn;
+
+    QMutexLocker locker(&cacheMutex);
+    request.cacheGeneration = cacheGeneration;
+    request.decoderGeneration = decoderGeneration;
+
+    return request;
+}
+
+// Method to render the QImage for a frame, including the dropout highlighting.
+// This may be called from a decode-ahead worker, so it must only use the
+// request, the decoders it is given and getVideoField().
+QImage TbcSource::renderFrameImage(const FrameRequest &request, PalColour &palColourDecoder, Comb &ntscColourDecoder)
+{
+    // Get a QImage for the frame
+    QImage frameImage = generateQImage(request, palColourDecoder, ntscColourDecoder);
+
+    // Highlight dropouts
+    if (request.dropoutsOn) {
+        // Create a painter object
+        QPainter imagePainter;
+        imagePainter.begin(&frameImage);
+
+        // Draw the drop out data for the first field
+        imagePainter.setPen(Qt::red);
+        for (qint32 dropOutIndex = 0; dropOutIndex < request.firstField.dropOuts.startx.size(); dropOutIndex++) {
+            qint32 startx = request.firstField.dropOuts.startx[dropOutIndex];
+            qint32 endx = request.firstField.dropOuts.endx[dropOutIndex];
+            qint32 fieldLine = request.firstField.dropOuts.fieldLine[dropOutIndex];
+
+            imagePainter.drawLine(startx, ((fieldLine - 1) * 2), endx, ((fieldLine - 1) * 2));
+        }
+
+        // Draw the drop out data for the second field
+        imagePainter.setPen(Qt::blue);
+        for (qint32 dropOutIndex = 0; dropOutIndex < request.secondField.dropOuts.startx.size(); dropOutIndex++) {
+            qint32 startx = request.secondField.dropOuts.startx[dropOutIndex];
+            qint32 endx = request.secondField.dropOuts.endx[dropOutIndex];
+            qint32 fieldLine = request.secondField.dropOuts.fieldLine[dropOutIndex];
+
+            imagePainter.drawLine(startx, ((fieldLine - 1) * 2) + 1, endx, ((fieldLine - 1) * 2) + 1);
+        }
+
+        // End the painter object
+        imagePainter.end();
+    }
+
+    return frameImage;
+}
+
 // Method to create a QImage for a source video frame
-QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumber)
+QImage TbcSource::generateQImage(const FrameRequest &request, PalColour &palColourDecoder, Comb &ntscColourDecoder)
 {
+    const qint32 firstFieldNumber = request.firstFieldNumber;
+    const qint32 secondFieldNumber = request.secondFieldNumber;
+
     // Get the metadata for the video parameters
-    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    const LdDecodeMetaData::VideoParameters &videoParameters = request.videoParameters;
 
     // Calculate the frame height
     qint32 frameHeight = (videoParameters.fieldHeight * 2) - 1;
 
     // Show debug information
-    if (chromaOn) {
+    if (request.chromaOn) {
         qDebug().nospace() << "TbcSource::generateQImage(): Generating a chroma image from field pair " << firstFieldNumber <<
                     "/" << secondFieldNumber << " (" << videoParameters.fieldWidth << "x" <<
                     frameHeight << ")";
-    } else if (lpfOn) {
+    } else if (request.lpfOn) {
         qDebug().nospace() << "TbcSource::generateQImage(): Generating a LPF image from field pair " << firstFieldNumber <<
                     "/" << secondFieldNumber << " (" << videoParameters.fieldWidth << "x" <<
                     frameHeight << ")";
@@ -544,25 +697,25 @@ QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumb
     QByteArray firstLineData;
     QByteArray secondLineData;
 
-    if (chromaOn) {
+    if (request.chromaOn) {
         // Chroma decode the current frame and display
 
         // Get the two fields and their metadata and contain in the chroma-decoder's
         // source field class
         SourceField firstField, secondField;
-        firstField.field = ldDecodeMetaData.getField(firstFieldNumber);
-        secondField.field = ldDecodeMetaData.getField(secondFieldNumber);
-        firstField.data = sourceVideo.getVideoField(firstFieldNumber);
-        secondField.data = sourceVideo.getVideoField(secondFieldNumber);
+        firstField.field = request.firstField;
+        secondField.field = request.secondField;
+        firstField.data = getVideoField(firstFieldNumber);
+        secondField.data = getVideoField(secondFieldNumber);
 
         // Decode colour for the current frame, to RGB 16-16-16 interlaced output
         RGBFrame rgbFrame;
         if (videoParameters.isSourcePal) {
             // PAL source
-            rgbFrame = palColour.decodeFrame(firstField, secondField);
+            rgbFrame = palColourDecoder.decodeFrame(firstField, secondField);
         } else {
             // NTSC source
-            rgbFrame = ntscColour.decodeFrame(firstField, secondField);
+            rgbFrame = ntscColourDecoder.decodeFrame(firstField, secondField);
         }
 
         // Get a pointer to the RGB data
@@ -573,22 +726,23 @@ QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumb
 
         // Copy the RGB16-16-16 data into the RGB888 QImage
         for (qint32 y = videoParameters.firstActiveFrameLine; y < videoParameters.lastActiveFrameLine; y++) {
+            uchar *imageLine = frameImage.scanLine(y);
             for (qint32 x = videoParameters.activeVideoStart; x < videoParameters.activeVideoEnd; x++) {
                 qint32 pixelOffset = ((y * videoParameters.fieldWidth) + x) * 3;
 
                 // Take just the MSB of the input data
                 qint32 xpp = x * 3;
-                *(frameImage.scanLine(y) + xpp + 0) = static_cast<uchar>(rgbPointer[pixelOffset + 0] / 256); // R
-                *(frameImage.scanLine(y) + xpp + 1) = static_cast<uchar>(rgbPointer[pixelOffset + 1] / 256); // G
-                *(frameImage.scanLine(y) + xpp + 2) = static_cast<uchar>(rgbPointer[pixelOffset + 2] / 256); // B
+                imageLine[xpp + 0] = static_cast<uchar>(rgbPointer[pixelOffset + 0] / 256); // R
+                imageLine[xpp + 1] = static_cast<uchar>(rgbPointer[pixelOffset + 1] / 256); // G
+                imageLine[xpp + 2] = static_cast<uchar>(rgbPointer[pixelOffset + 2] / 256); // B
             }
         }
-    } else if (lpfOn) {
+    } else if (request.lpfOn) {
         // Display the current frame as LPF only
 
         // Get the field data
-        SourceVideo::Data firstField = sourceVideo.getVideoField(firstFieldNumber);
-        SourceVideo::Data secondField = sourceVideo.getVideoField(secondFieldNumber);
+        SourceVideo::Data firstField = getVideoField(firstFieldNumber);
+        SourceVideo::Data secondField = getVideoField(secondFieldNumber);
 
         // Generate pointers to the 16-bit greyscale data.
         // Since we're taking a non-const pointer here, this will detach from
@@ -613,6 +767,7 @@ QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumb
 
         // Copy the raw 16-bit grayscale data into the RGB888 QImage
         for (qint32 y = 0; y < frameHeight; y++) {
+            uchar *imageLine = frameImage.scanLine(y);
             for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
                 qint32 pixelOffset = (videoParameters.fieldWidth * (y / 2)) + x;
                 qreal pixelValue32;
@@ -635,17 +790,17 @@ QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumb
                 uchar pixelValue = static_cast<uchar>(pixelValue32 / 256);
 
                 qint32 xpp = x * 3;
-                *(frameImage.scanLine(y) + xpp + 0) = static_cast<uchar>(pixelValue); // R
-                *(frameImage.scanLine(y) + xpp + 1) = static_cast<uchar>(pixelValue); // G
-                *(frameImage.scanLine(y) + xpp + 2) = static_cast<uchar>(pixelValue); // B
+                imageLine[xpp + 0] = static_cast<uchar>(pixelValue); // R
+                imageLine[xpp + 1] = static_cast<uchar>(pixelValue); // G
+                imageLine[xpp + 2] = static_cast<uchar>(pixelValue); // B
             }
         }
     } else {
         // Display the current frame as source data
 
         // Get the field data
-        SourceVideo::Data firstField = sourceVideo.getVideoField(firstFieldNumber);
-        SourceVideo::Data secondField = sourceVideo.getVideoField(secondFieldNumber);
+        SourceVideo::Data firstField = getVideoField(firstFieldNumber);
+        SourceVideo::Data secondField = getVideoField(secondFieldNumber);
 
         // Get pointers to the 16-bit greyscale data
         const quint16 *firstFieldPointer = firstField.data();
@@ -653,6 +808,7 @@ QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumb
 
         // Copy the raw 16-bit grayscale data into the RGB888 QImage
         for (qint32 y = 0; y < frameHeight; y++) {
+            uchar *imageLine = frameImage.scanLine(y);
             for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
                 // Take just the MSB of the input data
                 qint32 pixelOffset = (videoParameters.fieldWidth * (y / 2)) + x;
@@ -664,9 +820,9 @@ QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumb
                 }
 
                 qint32 xpp = x * 3;
-                *(frameImage.scanLine(y) + xpp + 0) = static_cast<uchar>(pixelValue); // R
-                *(frameImage.scanLine(y) + xpp + 1) = static_cast<uchar>(pixelValue); // G
-                *(frameImage.scanLine(y) + xpp + 2) = static_cast<uchar>(pixelValue); // B
+                imageLine[xpp + 0] = static_cast<uchar>(pixelValue); // R
+                imageLine[xpp + 1] = static_cast<uchar>(pixelValue); // G
+                imageLine[xpp + 2] = static_cast<uchar>(pixelValue); // B
             }
         }
     }
@@ -674,15 +830,163 @@ QImage TbcSource::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumb
     return frameImage;
 }
 
+// Method to read a field (or a range of field lines) from the source video.
+// SourceVideo is not thread-safe, so this serialises access from the
+// decode-ahead workers.
+SourceVideo::Data TbcSource::getVideoField(qint32 fieldNumber, qint32 startFieldLine, qint32 endFieldLine)
+{
+    QMutexLocker locker(&sourceVideoMutex);
+
+    return sourceVideo.getVideoField(fieldNumber, startFieldLine, endFieldLine);
+}
+
+// Method to get the dropouts for a field, sorted and indexed by field line.
+// The indexes for recently-used fields are cached, since the oscilloscope
+// looks up one line at a time.
+const TbcSource::DropoutLineIndex &TbcSource::getDropoutLineIndex(qint32 fieldNumber, qint32 fieldHeight)
+{
+    DropoutLineIndex *dropoutIndex = dropoutIndexCache.object(fieldNumber);
+    if (dropoutIndex != nullptr) return *dropoutIndex;
+
+    LdDecodeMetaData::DropOuts fieldDropOuts = ldDecodeMetaData.getFieldDropOuts(fieldNumber);
+    const qint32 numberOfDropOuts = fieldDropOuts.startx.size();
+
+    // Count the dropouts on each line (ignoring any with an invalid line number),
+    // and turn the counts into the index of the first dropout on each line
+    dropoutIndex = new DropoutLineIndex;
+    dropoutIndex->lineStart.fill(0, fieldHeight + 2);
+    for (qint32 i = 0; i < numberOfDropOuts; i++) {
+        qint32 fieldLine = fieldDropOuts.fieldLine[i];
+        if (fieldLine >= 1 && fieldLine <= fieldHeight) dropoutIndex->lineStart[fieldLine + 1]++;
+    }
+    for (qint32 fieldLine = 1; fieldLine <= fieldHeight; fieldLine++) {
+        dropoutIndex->lineStart[fieldLine + 1] += dropoutIndex->lineStart[fieldLine];
+    }
+
+    // Place the dropouts in line order
+    const qint32 numberOfIndexedDropOuts = dropoutIndex->lineStart[fieldHeight + 1];
+    dropoutIndex->dropOuts.startx.resize(numberOfIndexedDropOuts);
+    dropoutIndex->dropOuts.endx.resize(numberOfIndexedDropOuts);
+    dropoutIndex->dropOuts.fieldLine.resize(numberOfIndexedDropOuts);
+    QVector<qint32> nextPosition = dropoutIndex->lineStart;
+    for (qint32 i = 0; i < numberOfDropOuts; i++) {
+        qint32 fieldLine = fieldDropOuts.fieldLine[i];
+        if (fieldLine < 1 || fieldLine > fieldHeight) continue;
+
+        qint32 position = nextPosition[fieldLine]++;
+        dropoutIndex->dropOuts.startx[position] = fieldDropOuts.startx[i];
+        dropoutIndex->dropOuts.endx[position] = fieldDropOuts.endx[i];
+        dropoutIndex->dropOuts.fieldLine[position] = fieldLine;
+    }
+
+    dropoutIndexCache.insert(fieldNumber, dropoutIndex);
+    return *dropoutIndexCache.object(fieldNumber);
+}
+
+// Method to discard all cached frames; frames that are still being decoded
+// ahead will be discarded when they finish
+void TbcSource::invalidateFrameCache()
+{
+    QMutexLocker locker(&cacheMutex);
+
+    cacheGeneration++;
+    frameCache.clear();
+    pendingFrames.clear();
+    frameRendered.wakeAll();
+}
+
+// Method to discard all cached frames and wait for the decode-ahead workers to stop
+void TbcSource::stopDecodeAhead()
+{
+    invalidateFrameCache();
+    decodeAheadPool.waitForDone();
+}
+
+// Method to queue the frames following frameNumber (in the direction the user
+// is moving through the source) for decoding in the background
+void TbcSource::startDecodeAhead(qint32 frameNumber)
+{
+    // Work out which way the user is moving
+    if (lastRequestedFrameNumber != -1) {
+        if (frameNumber > lastRequestedFrameNumber) decodeAheadDirection = 1;
+        else if (frameNumber < lastRequestedFrameNumber) decodeAheadDirection = -1;
+    }
+    lastRequestedFrameNumber = frameNumber;
+
+    // Queue the nearest frames first, so they are decoded first
+    for (qint32 i = 1; i <= DECODE_AHEAD_FRAMES; i++) {
+        qint32 aheadFrameNumber = frameNumber + (i * decodeAheadDirection);
+        if (aheadFrameNumber < 1 || aheadFrameNumber > getNumberOfFrames()) break;
+
+        {
+            QMutexLocker locker(&cacheMutex);
+            if (frameCache.contains(aheadFrameNumber) || pendingFrames.contains(aheadFrameNumber)) continue;
+            pendingFrames.insert(aheadFrameNumber);
+        }
+
+        QtConcurrent::run(&decodeAheadPool, this, &TbcSource::decodeAheadFrame, makeFrameRequest(aheadFrameNumber));
+    }
+}
+
+// Decode-ahead worker - render a frame and add it to the cache
+void TbcSource::decodeAheadFrame(FrameRequest request)
+{
+    // Skip the frame if the options have changed since it was queued, or if
+    // the user has moved away from it (e.g. when scrubbing)
+    {
+        QMutexLocker locker(&cacheMutex);
+        if (request.cacheGeneration != cacheGeneration) return;
+
+        if (qAbs(request.frameNumber - lastRequestedFrameNumber) > DECODE_AHEAD_FRAMES) {
+            pendingFrames.remove(request.frameNumber);
+            frameRendered.wakeAll();
+            return;
+        }
+    }
+
+    // Get a set of decoders for this worker
+    WorkerDecoders *decoders = nullptr;
+    {
+        QMutexLocker locker(&workerDecodersMutex);
+        if (!idleWorkerDecoders.isEmpty()) decoders = idleWorkerDecoders.takeLast();
+    }
+    if (decoders == nullptr) {
+        decoders = new WorkerDecoders;
+        decoders->decoderGeneration = -1;
+    }
+
+    // Configure the decoders if the configuration has changed (this may
+    // create FFTW plans, which can't be done in parallel)
+    if (decoders->decoderGeneration != request.decoderGeneration) {
+        QMutexLocker locker(&decoderConfigurationMutex);
+        if (request.videoParameters.isSourcePal) {
+            decoders->palColour.updateConfiguration(request.videoParameters, request.palColourConfiguration);
+        } else {
+            Comb::Configuration configuration;
+            decoders->ntscColour.updateConfiguration(request.videoParameters, configuration);
+        }
+        decoders->decoderGeneration = request.decoderGeneration;
+    }
+
+    QImage frameImage = renderFrameImage(request, decoders->palColour, decoders->ntscColour);
+
+    {
+        QMutexLocker locker(&workerDecodersMutex);
+        idleWorkerDecoders.append(decoders);
+    }
+
+    // Add the frame to the cache, unless it has been invalidated in the meantime
+    QMutexLocker locker(&cacheMutex);
+    if (request.cacheGeneration != cacheGeneration) return;
+    frameCache.insert(request.frameNumber, new QImage(frameImage));
+    pendingFrames.remove(request.frameNumber);
+    frameRendered.wakeAll();
+}
+
 // Generate the data points for the Drop-out and SNR analysis graphs
 // We do these both at the same time to reduce calls to the metadata
 void TbcSource::generateData(qint32 _targetDataPoints)
 {
-    dropoutGraphData.clear();
-    blackSnrGraphData.clear();
-    whiteSnrGraphData.clear();
-    cqiGraphData.clear();
-
     qreal targetDataPoints = static_cast<qreal>(_targetDataPoints);
     qreal averageWidth = qRound(ldDecodeMetaData.getNumberOfFields() / targetDataPoints);
     if (averageWidth < 1) averageWidth = 1; // Ensure we don't divide by zero
@@ -693,8 +997,30 @@ void TbcSource::generateData(qint32 _targetDataPoints)
     // Get the total number of dots per field
     qint32 totalDotsPerField = ldDecodeMetaData.getVideoParameters().fieldHeight + ldDecodeMetaData.getVideoParameters().fieldWidth;
 
-    qint32 fieldNumber = 1;
-    for (qint32 dpCount = 0; dpCount < dataPoints; dpCount++) {
+    dropoutGraphData.fill(0, dataPoints);
+    blackSnrGraphData.fill(0, dataPoints);
+    whiteSnrGraphData.fill(0, dataPoints);
+    cqiGraphData.fill(0, dataPoints);
+
+    // The data points are independent, so split them into ranges and
+    // generate the ranges in parallel
+    qint32 numberOfRanges = qBound(1, QThread::idealThreadCount(), qMax(dataPoints, 1));
+    QVector<QFuture<void>> rangeFutures;
+    for (qint32 range = 0; range < numberOfRanges; range++) {
+        qint32 startDataPoint = (dataPoints * range) / numberOfRanges;
+        qint32 endDataPoint = (dataPoints * (range + 1)) / numberOfRanges;
+        rangeFutures.append(QtConcurrent::run(this, &TbcSource::generateDataRange,
+                                              startDataPoint, endDataPoint, totalDotsPerField));
+    }
+    for (QFuture<void> &rangeFuture : rangeFutures) rangeFuture.waitForFinished();
+}
+
+// Generate the graph data points from startDataPoint to endDataPoint - 1.
+// This is called in parallel for different ranges, so it only reads the metadata.
+void TbcSource::generateDataRange(qint32 startDataPoint, qint32 endDataPoint, qint32 totalDotsPerField)
+{
+    qint32 fieldNumber = (startDataPoint * fieldsPerGraphDataPoint) + 1;
+    for (qint32 dpCount = startDataPoint; dpCount < endDataPoint; dpCount++) {
         qreal doLength = 0;
         qreal blackSnrTotal = 0;
         qreal whiteSnrTotal = 0;
@@ -728,7 +1054,7 @@ void TbcSource::generateData(qint32 _targetDataPoints)
             }
 
             // Get the sync confidence
-            syncConf += static_cast<qreal>(ldDecodeMetaData.getField(fieldNumber).syncConf);
+            syncConf += static_cast<qreal>(field.syncConf);
 
             // Next field...
             fieldNumber++;
@@ -757,14 +1083,61 @@ void TbcSource::generateData(qint32 _targetDataPoints)
         // on the resulting capture than SNR.
         qreal captureQualityIndex = ((fieldDoPercent * 1000.0) + snrPercent + syncConf) / 1002.0;
 
-        // Add the result to the vectors
-        dropoutGraphData.append(doLength);
-        blackSnrGraphData.append(blackSnrTotal);
-        whiteSnrGraphData.append(whiteSnrTotal);
-        cqiGraphData.append(captureQualityIndex);
+        // Store the result in the vectors
+        dropoutGraphData[dpCount] = doLength;
+        blackSnrGraphData[dpCount] = blackSnrTotal;
+        whiteSnrGraphData[dpCount] = whiteSnrTotal;
+        cqiGraphData[dpCount] = captureQualityIndex;
+    }
+}
+
+// Generate a chapter map (used by the chapter skip forwards and backwards buttons)
+void TbcSource::generateChapterMap(const QString &jsonFileName, const QByteArray &metadataHash)
+{
+    vbiFrameIndex.build(ldDecodeMetaData, jsonFileName, metadataHash);
+    qint32 lastChapter = -1;
+    qint32 giveUpCounter = 0;
+    chapterMap.clear();
+    for (qint32 i = 1; i <= getNumberOfFrames(); i++) {
+        qint32 currentChapter = vbiFrameIndex.getChapterNumber(i);
+        if (currentChapter != -1) {
+            if (currentChapter != lastChapter) {
+                lastChapter = currentChapter;
+                chapterMap.append(i);
+            } else giveUpCounter++;
+        }
+
+        if (i == 100 && giveUpCounter < 50) {
+            qDebug() << "Not seeing valid chapter numbers, giving up chapter mapping";
+            break;
+        }
     }
 }
 
+// Read the graph data and chapter map from a summary cache file; returns
+// false if the cache doesn't exist, can't be read or is out of date
+bool TbcSource::readSummaryCache(const QString &cacheFileName, const QByteArray &cacheKey)
+{
+    SidecarCache cache(SUMMARY_CACHE_MAGIC, SUMMARY_CACHE_VERSION);
+    if (!cache.openRead(cacheFileName, cacheKey)) return false;
+
+    cache.stream() >> fieldsPerGraphDataPoint >> dropoutGraphData >> blackSnrGraphData >> whiteSnrGraphData >> cqiGraphData >> chapterMap;
+    return cache.finishRead(blackSnrGraphData.size() == dropoutGraphData.size()
+                            && whiteSnrGraphData.size() == dropoutGraphData.size()
+                            && cqiGraphData.size() == dropoutGraphData.size());
+}
+
+// Write the graph data and chapter map to a summary cache file
+bool TbcSource::writeSummaryCache(const QString &cacheFileName, const QByteArray &cacheKey)
+{
+    SidecarCache cache(SUMMARY_CACHE_MAGIC, SUMMARY_CACHE_VERSION);
+    if (!cache.openWrite(cacheFileName, cacheKey)) return false;
+
+    cache.stream() << fieldsPerGraphDataPoint << dropoutGraphData << blackSnrGraphData << whiteSnrGraphData << cqiGraphData << chapterMap;
+
+    return cache.finishWrite();
+}
+
 void TbcSource::startBackgroundLoad(QString sourceFilename)
 {
     // Open the TBC metadata file
@@ -784,7 +1157,7 @@ void TbcSource::startBackgroundLoad(QString sourceFilename)
         // Open the new source video
         qDebug() << "TbcSource::startBackgroundLoad(): Loading TBC file...";
         emit busyLoading("Loading TBC file...");
-        if (!sourceVideo.open(sourceFilename, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
+        if (!sourceVideo.open(sourceFilename, videoParameters.fieldWidth * videoParameters.fieldHeight, videoParameters.fieldWidth)) {
             // Open failed
             qWarning() << "Open TBC file failed for filename" << sourceFilename;
             currentSourceFilename.clear();
@@ -802,35 +1175,34 @@ void TbcSource::startBackgroundLoad(QString sourceFilename)
     LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
 
     // Configure the chroma decoder
+    decoderConfigurationMutex.lock();
     if (videoParameters.isSourcePal) {
-        palColour.updateConfiguration(videoParameters, palColourConfiguration);
+        palColour.updateConfiguration(videoParameters, getForegroundPalColourConfiguration());
     } else {
         Comb::Configuration configuration;
+        configuration.intraFrameThreads = QThread::idealThreadCount();
         ntscColour.updateConfiguration(videoParameters, configuration);
     }
+    decoderConfigurationMutex.unlock();
+
+    // Get the graph data and chapter map for the source from the summary
+    // cache, or generate them if the cache is missing or out of date. The
+    // metadata is only hashed once, for both this and the VBI frame index.
+    QString jsonFileName = sourceFilename + ".json";
+    QByteArray metadataHash = SidecarCache::hashFile(jsonFileName);
+    QByteArray summaryCacheKey = SidecarCache::makeKey(metadataHash, QByteArray::number(GRAPH_DATA_POINTS));
+    if (readSummaryCache(jsonFileName + ".summary", summaryCacheKey)) {
+        qDebug() << "TbcSource::startBackgroundLoad(): Using cached summary for" << jsonFileName;
+    } else {
+        // Generate the graph data for the source
+        emit busyLoading("Generating graph data...");
+        generateData(GRAPH_DATA_POINTS);
 
-    // Generate the graph data for the source
-    emit busyLoading("Generating graph data...");
-    generateData(2000);
-
-    // Generate a chapter map (used by the chapter skip
-    // forwards and backwards buttons)
-    emit busyLoading("Generating VBI chapter map...");
-    qint32 lastChapter = -1;
-    qint32 giveUpCounter = 0;
-    chapterMap.clear();
-    for (qint32 i = 1; i <= getNumberOfFrames(); i++) {
-        qint32 currentChapter = getFrameVbi(i).chNo;
-        if (currentChapter != -1) {
-            if (currentChapter != lastChapter) {
-                lastChapter = currentChapter;
-                chapterMap.append(i);
-            } else giveUpCounter++;
-        }
+        emit busyLoading("Generating VBI chapter map...");
+        generateChapterMap(jsonFileName, metadataHash);
 
-        if (i == 100 && giveUpCounter < 50) {
-            qDebug() << "Not seeing valid chapter numbers, giving up chapter mapping";
-            break;
+        if (!summaryCacheKey.isEmpty() && !writeSummaryCache(jsonFileName + ".summary", summaryCacheKey)) {
+            qDebug() << "TbcSource::startBackgroundLoad(): Could not write summary cache for" << jsonFileName;
         }
     }
 }
@@ -28,6 +28,13 @@
 #include <QObject>
 #include <QImage>
 #include <QPainter>
+#include <QCache>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QThread>
+#include <QThreadPool>
 #include <QtConcurrent/QtConcurrent>
 #include <QDebug>
 
@@ -35,6 +42,7 @@
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
 #include "vbidecoder.h"
+#include "vbiframeindex.h"
 #include "filters.h"
 
 // Chroma decoder includes
@@ -47,6 +55,7 @@ class TbcSource : public QObject
     Q_OBJECT
 public:
     explicit TbcSource(QObject *parent = nullptr);
+    ~TbcSource() override;
 
     struct ScanLineData {
         QVector<qint32> data;
@@ -75,6 +84,7 @@ public:
     bool getFieldOrder();
 
     QImage getFrameImage(qint32 frameNumber);
+    QImage getFramePreviewImage(qint32 frameNumber);
     qint32 getNumberOfFrames();
     qint32 getNumberOfFields();
     bool getIsSourcePal();
@@ -129,8 +139,10 @@ private:
     bool dropoutsOn;
     bool reverseFoOn;
 
-    // Source globals
+    // Source globals (sourceVideo is shared with the decode-ahead workers,
+    // so it must only be accessed through getVideoField)
     SourceVideo sourceVideo;
+    QMutex sourceVideoMutex;
     LdDecodeMetaData ldDecodeMetaData;
     QString currentSourceFilename;
     QString lastLoadError;
@@ -141,24 +153,85 @@ private:
 
     // VBI decoder
     VbiDecoder vbiDecoder;
+    VbiFrameIndex vbiFrameIndex;
 
     // Background loader globals
     QFutureWatcher<void> watcher;
     QFuture <void> future;
 
-    // Cache of current frame QImage
-    QImage frameCache;
-    qint32 frameCacheFrameNumber;
-
     // PAL chroma-decoder configuration
     PalColour::Configuration palColourConfiguration;
-    bool decoderConfigurationChanged;
 
     // Chapter map
     QVector<qint32> chapterMap;
 
-    QImage generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumber);
+    // The dropouts of a field, sorted by field line. The dropouts on line N
+    // are from lineStart[N] to lineStart[N + 1] - 1.
+    struct DropoutLineIndex {
+        LdDecodeMetaData::DropOuts dropOuts;
+        QVector<qint32> lineStart;
+    };
+    QCache<qint32, DropoutLineIndex> dropoutIndexCache;
+
+    // Everything needed to render a frame image, captured on the GUI thread
+    // so the frame can be rendered by a decode-ahead worker
+    struct FrameRequest {
+        qint32 frameNumber;
+        qint32 firstFieldNumber;
+        qint32 secondFieldNumber;
+        LdDecodeMetaData::Field firstField;
+        LdDecodeMetaData::Field secondField;
+        LdDecodeMetaData::VideoParameters videoParameters;
+        PalColour::Configuration palColourConfiguration;
+        bool chromaOn;
+        bool lpfOn;
+        bool dropoutsOn;
+        qint32 cacheGeneration;
+        qint32 decoderGeneration;
+    };
+
+    // Chroma decoders belonging to a decode-ahead worker
+    struct WorkerDecoders {
+        PalColour palColour;
+        Comb ntscColour;
+        qint32 decoderGeneration;
+    };
+
+    // Cache of rendered frame QImages (least-recently-used), keyed by frame
+    // number. The cache is cleared, and cacheGeneration incremented, whenever
+    // an option that affects the rendered image changes.
+    QMutex cacheMutex;
+    QWaitCondition frameRendered;
+    QCache<qint32, QImage> frameCache;
+    QSet<qint32> pendingFrames;
+    qint32 cacheGeneration;
+
+    // Incremented whenever the chroma decoders need to be reconfigured
+    qint32 decoderGeneration;
+    QMutex decoderConfigurationMutex;
+
+    // Decode-ahead workers
+    QThreadPool decodeAheadPool;
+    QMutex workerDecodersMutex;
+    QVector<WorkerDecoders *> idleWorkerDecoders;
+    QAtomicInt lastRequestedFrameNumber;
+    qint32 decodeAheadDirection;
+
+    FrameRequest makeFrameRequest(qint32 frameNumber);
+    PalColour::Configuration getForegroundPalColourConfiguration();
+    QImage renderFrameImage(const FrameRequest &request, PalColour &palColourDecoder, Comb &ntscColourDecoder);
+    QImage generateQImage(const FrameRequest &request, PalColour &palColourDecoder, Comb &ntscColourDecoder);
+    SourceVideo::Data getVideoField(qint32 fieldNumber, qint32 startFieldLine = -1, qint32 endFieldLine = -1);
+    const DropoutLineIndex &getDropoutLineIndex(qint32 fieldNumber, qint32 fieldHeight);
+    void invalidateFrameCache();
+    void stopDecodeAhead();
+    void startDecodeAhead(qint32 frameNumber);
+    void decodeAheadFrame(FrameRequest request);
     void generateData(qint32 _targetDataPoints);
+    void generateDataRange(qint32 startDataPoint, qint32 endDataPoint, qint32 totalDotsPerField);
+    void generateChapterMap(const QString &jsonFileName, const QByteArray &metadataHash);
+    bool readSummaryCache(const QString &cacheFileName, const QByteArray &cacheKey);
+    bool writeSummaryCache(const QString &cacheFileName, const QByteArray &cacheKey);
     void startBackgroundLoad(QString sourceFilename);
 };
 
@@ -0,0 +1,259 @@
+/************************************************************************
+
+    benchmark.cpp
+
+    ld-chroma-decoder - Colourisation filter for ld-decode
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "benchmark.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QtMath>
+#include <algorithm>
+#include <cstdio>
+
+#include "decoderpool.h"
+#include "encoder/ntscencoder.h"
+#include "encoder/palencoder.h"
+
+// Number of frames in the generated clip. This is a multiple of the length of
+// the PAL and NTSC colour sequences, so the clip can be repeated seamlessly.
+static const qint32 CLIP_FRAMES = 8;
+
+Benchmark::Benchmark(const QString &_decoderName, bool _isSourcePal, DecoderFactory _makeDecoder,
+                     qint32 _length, qint32 _maxThreads)
+    : decoderName(_decoderName), isSourcePal(_isSourcePal), makeDecoder(_makeDecoder),
+      length(_length), maxThreads(_maxThreads)
+{
+}
+
+bool Benchmark::run(const QString &outputFileName)
+{
+    if (!generateInput()) {
+        return false;
+    }
+
+    // Decode with 1, 2, 4... threads, and finally maxThreads
+    QVector<qint32> threadCounts;
+    for (qint32 threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.append(threads);
+    }
+    threadCounts.append(maxThreads);
+
+    QVector<Result> results;
+    for (qint32 threads : threadCounts) {
+        Result result;
+        if (!decode(threads, result)) {
+            return false;
+        }
+
+        // Scaling efficiency is relative to the single-thread throughput
+        result.scalingEfficiency = result.framesPerSecond / (threads * results.value(0, result).framesPerSecond);
+        results.append(result);
+    }
+
+    return writeResults(outputFileName, results);
+}
+
+// Generate an RGB test frame, with the given dimensions, as triples of 16-bit samples.
+//
+// The top third has stationary colour bars; the middle third has a colour
+// ramp that scrolls horizontally; the bottom third has a luma zone plate that
+// scrolls vertically. This gives the 3D decoders both stationary and moving
+// areas to deal with.
+static void generateTestFrame(qint32 frameNumber, qint32 width, qint32 height, quint16 *rgbData)
+{
+    // 75% colour bars: white, yellow, cyan, green, magenta, red, blue, black
+    static const double bars[8][3] = {
+        {0.75, 0.75, 0.75}, {0.75, 0.75, 0.0}, {0.0, 0.75, 0.75}, {0.0, 0.75, 0.0},
+        {0.75, 0.0, 0.75}, {0.75, 0.0, 0.0}, {0.0, 0.0, 0.75}, {0.0, 0.0, 0.0}
+    };
+
+    for (qint32 y = 0; y < height; y++) {
+        quint16 *line = rgbData + (y * width * 3);
+
+        for (qint32 x = 0; x < width; x++) {
+            double rgb[3];
+
+            if (y < height / 3) {
+                const double *bar = bars[(x * 8) / width];
+                for (qint32 c = 0; c < 3; c++) rgb[c] = bar[c];
+            } else if (y < (2 * height) / 3) {
+                const double phase = (2.0 * M_PI * (x + (4 * frameNumber))) / 128.0;
+                for (qint32 c = 0; c < 3; c++) rgb[c] = 0.5 + (0.4 * sin(phase + ((2.0 * M_PI * c) / 3.0)));
+            } else {
+                const double dx = x - (width / 2.0);
+                const double dy = y + (2 * frameNumber) - (height * 5.0 / 6.0);
+                const double value = 0.5 + (0.4 * cos((M_PI * ((dx * dx) + (dy * dy))) / (2.0 * width)));
+                for (qint32 c = 0; c < 3; c++) rgb[c] = value;
+            }
+
+            for (qint32 c = 0; c < 3; c++) {
+                line[(x * 3) + c] = static_cast<quint16>(qBound(0.0, rgb[c] * 65535.0, 65535.0));
+            }
+        }
+    }
+}
+
+// Generate the input fields and metadata.
+// Returns true on success; on failure, prints a message and returns false.
+bool Benchmark::generateInput()
+{
+    qInfo() << "Generating" << CLIP_FRAMES << "frames of" << (isSourcePal ? "PAL" : "NTSC") << "test input";
+
+    // Set up an encoder, reading and writing in memory
+    QBuffer rgbBuffer;
+    QBuffer tbcBuffer;
+    LdDecodeMetaData clipMetaData;
+    QScopedPointer<Encoder> encoder;
+    if (isSourcePal) {
+        encoder.reset(new PALEncoder(rgbBuffer, tbcBuffer, clipMetaData));
+    } else {
+        encoder.reset(new NTSCEncoder(rgbBuffer, tbcBuffer, clipMetaData));
+    }
+
+    // Generate the RGB frames
+    const qint32 width = encoder->getActiveWidth();
+    const qint32 height = encoder->getActiveHeight();
+    const qint32 frameSamples = width * height * 3;
+    QByteArray rgbData(frameSamples * 2 * CLIP_FRAMES, 0);
+    for (qint32 frame = 0; frame < CLIP_FRAMES; frame++) {
+        quint16 *frameData = reinterpret_cast<quint16 *>(rgbData.data()) + (frame * frameSamples);
+        generateTestFrame(frame, width, height, frameData);
+    }
+
+    // Encode them
+    rgbBuffer.setData(rgbData);
+    if (!rgbBuffer.open(QIODevice::ReadOnly) || !tbcBuffer.open(QIODevice::WriteOnly)) {
+        qCritical() << "Could not open buffers for the benchmark input";
+        return false;
+    }
+    if (!encoder->encode()) {
+        return false;
+    }
+
+    // Split the TBC data into fields
+    const LdDecodeMetaData::VideoParameters videoParameters = clipMetaData.getVideoParameters();
+    const qint32 fieldLength = videoParameters.fieldWidth * videoParameters.fieldHeight;
+    const qint32 clipFields = clipMetaData.getNumberOfFields();
+    const quint16 *tbcData = reinterpret_cast<const quint16 *>(tbcBuffer.data().constData());
+    QVector<SourceVideo::Data> clipFieldData(clipFields);
+    for (qint32 field = 0; field < clipFields; field++) {
+        clipFieldData[field].resize(fieldLength);
+        std::copy(tbcData + (field * fieldLength), tbcData + ((field + 1) * fieldLength), clipFieldData[field].data());
+    }
+
+    // Repeat the clip to make up the requested length. The repeated fields
+    // share their data, so this takes no more memory than the clip itself.
+    fieldData.clear();
+    for (qint32 field = 0; field < 2 * length; field++) {
+        metaData.appendField(clipMetaData.getField((field % clipFields) + 1));
+        fieldData.append(clipFieldData[field % clipFields]);
+    }
+    metaData.setVideoParameters(videoParameters);
+    metaData.setIsFirstFieldFirst(true);
+
+    return true;
+}
+
+// Decode the generated input with the given number of threads.
+// Returns true on success; on failure, prints a message and returns false.
+bool Benchmark::decode(qint32 threads, Result &result)
+{
+    qInfo() << "Benchmarking" << decoderName << "with" << threads << "threads";
+
+    // Use a new decoder each time, so no state is carried over between runs
+    QScopedPointer<Decoder> decoder(makeDecoder());
+
+    DecoderPool decoderPool(*decoder, QString(), metaData, QString(), 1, length, threads);
+    decoderPool.setBenchmarkInput(fieldData);
+    if (!decoderPool.process()) {
+        return false;
+    }
+
+    result.threads = threads;
+    result.framesPerSecond = (length * 1.0e9) / decoderPool.getProcessNsecs();
+
+    // Compute percentiles of the per-frame decoding time
+    QVector<qint64> frameNsecs = decoderPool.getFrameDecodeNsecs();
+    std::sort(frameNsecs.begin(), frameNsecs.end());
+    auto percentile = [&](qint32 p) {
+        return frameNsecs[((frameNsecs.size() - 1) * p) / 100] / 1.0e6;
+    };
+    result.frameMsecsP50 = percentile(50);
+    result.frameMsecsP90 = percentile(90);
+    result.frameMsecsP99 = percentile(99);
+    result.frameMsecsMax = percentile(100);
+
+    return true;
+}
+
+// Write the results as JSON.
+// Returns true on success; on failure, prints a message and returns false.
+bool Benchmark::writeResults(const QString &outputFileName, const QVector<Result> &results)
+{
+    QJsonArray resultsArray;
+    for (const Result &result : results) {
+        QJsonObject frameMsecs;
+        frameMsecs["p50"] = result.frameMsecsP50;
+        frameMsecs["p90"] = result.frameMsecsP90;
+        frameMsecs["p99"] = result.frameMsecsP99;
+        frameMsecs["max"] = result.frameMsecsMax;
+
+        QJsonObject resultObject;
+        resultObject["threads"] = result.threads;
+        resultObject["framesPerSecond"] = result.framesPerSecond;
+        resultObject["scalingEfficiency"] = result.scalingEfficiency;
+        resultObject["frameMsecs"] = frameMsecs;
+        resultsArray.append(resultObject);
+    }
+
+    QJsonObject root;
+    root["decoder"] = decoderName;
+    root["isSourcePal"] = isSourcePal;
+    root["frames"] = length;
+    root["results"] = resultsArray;
+
+    QFile outputFile;
+    if (outputFileName == "-") {
+        if (!outputFile.open(stdout, QIODevice::WriteOnly)) {
+            qCritical() << "Could not open stdout for benchmark output";
+            return false;
+        }
+    } else {
+        outputFile.setFileName(outputFileName);
+        if (!outputFile.open(QIODevice::WriteOnly)) {
+            qCritical() << "Could not open" << outputFileName << "for benchmark output";
+            return false;
+        }
+    }
+
+    if (outputFile.write(QJsonDocument(root).toJson()) < 0) {
+        qCritical() << "Writing benchmark output failed";
+        return false;
+    }
+
+    return true;
+}
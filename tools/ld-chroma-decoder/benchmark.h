@@ -0,0 +1,88 @@
+/************************************************************************
+
+    benchmark.h
+
+    ld-chroma-decoder - Colourisation filter for ld-decode
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+#include "lddecodemetadata.h"
+#include "sourcevideo.h"
+
+#include "decoder.h"
+
+// Throughput benchmark for the decoders.
+//
+// This generates a short clip of test frames, encodes it using PALEncoder or
+// NTSCEncoder, and repeats it in memory to make up the requested number of
+// frames. The frames are then decoded by DecoderPool with increasing numbers
+// of threads, discarding the output, so the results measure only the
+// decoder's work -- not disk I/O.
+//
+// For each number of threads, the results give the throughput, percentiles of
+// the time taken to decode each frame, and the scaling efficiency relative to
+// a single thread. They are written as JSON.
+class Benchmark
+{
+public:
+    // Construct a new instance of the decoder being benchmarked
+    using DecoderFactory = std::function<Decoder *()>;
+
+    Benchmark(const QString &decoderName, bool isSourcePal, DecoderFactory makeDecoder,
+              qint32 length, qint32 maxThreads);
+
+    // Run the benchmark, writing the results to outputFileName ("-" for stdout).
+    // Returns true on success; on failure, prints a message and returns false.
+    bool run(const QString &outputFileName);
+
+private:
+    // The results for one number of threads
+    struct Result {
+        qint32 threads;
+        double framesPerSecond;
+        double scalingEfficiency;
+        double frameMsecsP50;
+        double frameMsecsP90;
+        double frameMsecsP99;
+        double frameMsecsMax;
+    };
+
+    bool generateInput();
+    bool decode(qint32 threads, Result &result);
+    bool writeResults(const QString &outputFileName, const QVector<Result> &results);
+
+    QString decoderName;
+    bool isSourcePal;
+    DecoderFactory makeDecoder;
+    qint32 length;
+    qint32 maxThreads;
+
+    // The generated input
+    LdDecodeMetaData metaData;
+    QVector<SourceVideo::Data> fieldData;
+};
+
+#endif // BENCHMARK_H
@@ -27,6 +27,15 @@
 
 #include "deemp.h"
 
+#include <QtConcurrent/QtConcurrent>
+
+// Number of samples of the previous line's input used as history by the NR
+// filters (this must be at least the length of the longest filter)
+static const qint32 NR_HISTORY = 32;
+
+// Delay of the NR filters, in samples
+static const qint32 NR_DELAY = 12;
+
 // Public methods -----------------------------------------------------------------------------------------------------
 
 Comb::Comb()
@@ -59,16 +68,40 @@ void Comb::updateConfiguration(const LdDecodeMetaData::VideoParameters &_videoPa
     // Set the frame height
     frameHeight = ((videoParameters.fieldHeight * 2) - 1);
 
+    // Allocate the planar scratch buffers for the line filters, with one row
+    // for each active line: NR history, a full line, and the NR delay padding
+    filterStride = NR_HISTORY + videoParameters.fieldWidth + NR_DELAY;
+    const qint32 activeLines = qMax(videoParameters.lastActiveFrameLine - videoParameters.firstActiveFrameLine, 0);
+    filterInput.resize(activeLines * filterStride);
+    filterOutput.resize(activeLines * filterStride);
+
+    // Select the motion detector for 3D
+    opticalFlow.setMotionDetector(configuration.motionDetector, configuration.compareMotionDetector);
+
     configurationSet = true;
 }
 
-// Process the input buffer into the RGB output buffer
+const OpticalFlow::Comparison &Comb::getMotionComparison() const
+{
+    return opticalFlow.getComparison();
+}
+
+// Process the input buffer into a new RGB output buffer
 RGBFrame Comb::decodeFrame(const SourceField &firstField, const SourceField &secondField)
+{
+    RGBFrame rgbOutputBuffer;
+    decodeFrame(firstField, secondField, rgbOutputBuffer);
+    return rgbOutputBuffer;
+}
+
+// Process the input buffer into the RGB output buffer
+void Comb::decodeFrame(const SourceField &firstField, const SourceField &secondField, RGBFrame &rgbOutputBuffer)
 {
     // Ensure the object has been configured
     if (!configurationSet) {
         qDebug() << "Comb::process(): Called, but the object has not been configured";
-        return RGBFrame();
+        rgbOutputBuffer.clear();
+        return;
     }
 
     // Allocate the frame buffer
@@ -78,9 +111,6 @@ RGBFrame Comb::decodeFrame(const SourceField &firstField, const SourceField &sec
     // Allocate the temporary YIQ buffer
     YiqBuffer tempYiqBuffer;
 
-    // Allocate RGB output buffer
-    RGBFrame rgbOutputBuffer;
-
     // Interlace the input fields and place in the frame[0]'s raw buffer
     qint32 fieldLine = 0;
     currentFrameBuffer.rawbuffer.clear();
@@ -123,7 +153,7 @@ RGBFrame Comb::decodeFrame(const SourceField &firstField, const SourceField &sec
         doCNR(tempYiqBuffer);
 
         // Convert the YIQ result to RGB
-        rgbOutputBuffer = yiqToRgbFrame(tempYiqBuffer, currentFrameBuffer.burstLevel);
+        yiqToRgbFrame(tempYiqBuffer, currentFrameBuffer.burstLevel, rgbOutputBuffer);
     } else {
         // 3D comb filter processing
 
@@ -161,7 +191,7 @@ RGBFrame Comb::decodeFrame(const SourceField &firstField, const SourceField &sec
         doCNR(tempYiqBuffer);
 
         // Convert the YIQ result to RGB
-        rgbOutputBuffer = yiqToRgbFrame(tempYiqBuffer, currentFrameBuffer.burstLevel);
+        yiqToRgbFrame(tempYiqBuffer, currentFrameBuffer.burstLevel, rgbOutputBuffer);
 
         // Overlay the optical flow map if required
         if (configuration.showOpticalFlowMap) overlayOpticalFlowMap(currentFrameBuffer, rgbOutputBuffer);
@@ -169,9 +199,6 @@ RGBFrame Comb::decodeFrame(const SourceField &firstField, const SourceField &sec
         // Store the current frame
         previousFrameBuffer = currentFrameBuffer;
     }
-
-    // Return the output frame
-    return rgbOutputBuffer;
 }
 
 // Private methods ----------------------------------------------------------------------------------------------------
@@ -352,32 +379,41 @@ void Comb::splitIQ(FrameBuffer *frameBuffer)
 // Filter the IQ from the input YIQ buffer
 void Comb::filterIQ(YiqBuffer &yiqBuffer)
 {
-    auto iFilter(f_colorlpi);
-    auto qFilter(configuration.colorlpf_hq ? f_colorlpi : f_colorlpq);
-
-    for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
-        iFilter.clear();
-        qFilter.clear();
+    const qint32 firstLine = videoParameters.firstActiveFrameLine;
+    const qint32 qoffset = 2; // f_colorlpf_hq ? f_colorlpi_offset : f_colorlpq_offset;
 
-        qint32 qoffset = 2; // f_colorlpf_hq ? f_colorlpi_offset : f_colorlpq_offset;
+    // The filters are cleared for each line, so the lines are independent
+    forEachActiveLine([&](qint32 lineNumber) {
+        auto iFilter(f_colorlpi);
+        auto qFilter(configuration.colorlpf_hq ? f_colorlpi : f_colorlpq);
 
-        qreal filti = 0, filtq = 0;
+        YiqLine &line = yiqBuffer[lineNumber];
 
+        // I is sampled on even phases and Q on odd phases. Gather each into a
+        // separate plane (I in the first half of the scratch row, Q in the second)
+        double *iPlane = filterInput.data() + (lineNumber - firstLine) * filterStride;
+        double *qPlane = iPlane + (filterStride / 2);
+        qint32 iCount = 0, qCount = 0;
         for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
-            qint32 phase = h % 4;
+            if ((h % 2) == 0) iPlane[iCount++] = line[h].i;
+            else qPlane[qCount++] = line[h].q;
+        }
 
-            switch (phase) {
-                case 0: filti = iFilter.feed(yiqBuffer[lineNumber][h].i); break;
-                case 1: filtq = qFilter.feed(yiqBuffer[lineNumber][h].q); break;
-                case 2: filti = iFilter.feed(yiqBuffer[lineNumber][h].i); break;
-                case 3: filtq = qFilter.feed(yiqBuffer[lineNumber][h].q); break;
-                default: break;
-            }
+        // The filters are recursive, so this is the same as feeding each sample in turn
+        iFilter.apply(iPlane, iPlane, iCount);
+        qFilter.apply(qPlane, qPlane, qCount);
+
+        // Each output holds the most recent filtered I and Q values
+        qreal filti = 0, filtq = 0;
+        qint32 iIndex = 0, qIndex = 0;
+        for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
+            if ((h % 2) == 0) filti = iPlane[iIndex++];
+            else filtq = qPlane[qIndex++];
 
-            yiqBuffer[lineNumber][h - qoffset].i = filti;
-            yiqBuffer[lineNumber][h - qoffset].q = filtq;
+            line[h - qoffset].i = filti;
+            line[h - qoffset].q = filtq;
         }
-    }
+    });
 }
 
 /*
@@ -392,79 +428,110 @@ void Comb::doCNR(YiqBuffer &yiqBuffer)
 {
     if (configuration.cNRLevel == 0) return;
 
-    // High-pass filters for I/Q
-    auto iFilter(f_nrc);
-    auto qFilter(f_nrc);
-
     // nr_c is the coring level
     qreal nr_c = configuration.cNRLevel * irescale;
 
-    QVector<YIQ> hplinef;
-    hplinef.resize(videoParameters.fieldWidth + 32);
-
-    for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
-        // Filters not cleared from previous line
-
-        for (qint32 h = videoParameters.activeVideoStart; h <= videoParameters.activeVideoEnd; h++) {
-            hplinef[h].i = iFilter.feed(yiqBuffer[lineNumber][h].i);
-            hplinef[h].q = qFilter.feed(yiqBuffer[lineNumber][h].q);
-        }
-
-        for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
-            // Offset by 12 to cover the filter delay
-            qreal ai = hplinef[h + 12].i;
-            qreal aq = hplinef[h + 12].q;
-
-            if (fabs(ai) > nr_c) {
-                ai = (ai > 0) ? nr_c : -nr_c;
-            }
-
-            if (fabs(aq) > nr_c) {
-                aq = (aq > 0) ? nr_c : -nr_c;
-            }
-
-            yiqBuffer[lineNumber][h].i -= ai;
-            yiqBuffer[lineNumber][h].q -= aq;
-        }
-    }
+    // High-pass filters for I/Q
+    coreChannel(yiqBuffer, &YIQ::i, f_nrc, nr_c);
+    coreChannel(yiqBuffer, &YIQ::q, f_nrc, nr_c);
 }
 
 void Comb::doYNR(YiqBuffer &yiqBuffer)
 {
     if (configuration.yNRLevel == 0) return;
 
-    // High-pass filter for Y
-    auto yFilter(f_nr);
-
     // nr_y is the coring level
     qreal nr_y = configuration.yNRLevel * irescale;
 
-    QVector<YIQ> hplinef;
-    hplinef.resize(videoParameters.fieldWidth + 32);
-
-    for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
-        // Filter not cleared from previous line
+    // High-pass filter for Y
+    coreChannel(yiqBuffer, &YIQ::y, f_nr, nr_y);
+}
 
-        for (qint32 h = videoParameters.activeVideoStart; h <= videoParameters.activeVideoEnd; h++) {
-            hplinef[h].y = yFilter.feed(yiqBuffer[lineNumber][h].y);
+// Subtract the high-pass filtered signal, cored to +/- level, from one channel of the YIQ buffer
+template <typename FilterType>
+void Comb::coreChannel(YiqBuffer &yiqBuffer, qreal YIQ::*channel, const FilterType &filter, qreal level)
+{
+    const qint32 firstLine = videoParameters.firstActiveFrameLine;
+    const qint32 videoStart = videoParameters.activeVideoStart;
+    const qint32 videoEnd = videoParameters.activeVideoEnd;
+
+    // The filter runs from activeVideoStart to activeVideoEnd inclusive. It is
+    // not cleared between lines, so each line is preceded in the scratch row
+    // by the end of the previous line's input (or zeros for the first line,
+    // which is the same as a cleared filter).
+    const qint32 lineLength = videoEnd + 1 - videoStart;
+    const qint32 historyLength = qMin(NR_HISTORY, lineLength);
+
+    // Filter each line into a planar scratch row. This only reads the YIQ
+    // buffer, so all lines see the unmodified input of the line before.
+    forEachActiveLine([&](qint32 lineNumber) {
+        double *input = filterInput.data() + (lineNumber - firstLine) * filterStride;
+        double *output = filterOutput.data() + (lineNumber - firstLine) * filterStride;
+
+        qint32 n = 0;
+        if (lineNumber == firstLine) {
+            for (qint32 i = 0; i < historyLength; i++) input[n++] = 0.0;
+        } else {
+            const YiqLine &previousLine = yiqBuffer[lineNumber - 1];
+            for (qint32 h = videoEnd + 1 - historyLength; h <= videoEnd; h++) input[n++] = previousLine[h].*channel;
         }
+        const YiqLine &line = yiqBuffer[lineNumber];
+        for (qint32 h = videoStart; h <= videoEnd; h++) input[n++] = line[h].*channel;
 
-        for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
-            qreal a = hplinef[h + 12].y;
+        FilterType lineFilter(filter);
+        lineFilter.apply(input, output, n);
+
+        // Beyond activeVideoEnd there is no filter output
+        for (qint32 i = 0; i < NR_DELAY; i++) output[n++] = 0.0;
+    });
+
+    // Core the filtered signal and subtract it from the line
+    forEachActiveLine([&](qint32 lineNumber) {
+        // Index the output by sample number, offset to cover the filter delay
+        const double *output = filterOutput.data() + (lineNumber - firstLine) * filterStride
+                               + historyLength - videoStart + NR_DELAY;
+        YiqLine &line = yiqBuffer[lineNumber];
 
-            if (fabs(a) > nr_y) {
-                a = (a > 0) ? nr_y : -nr_y;
+        for (qint32 h = videoStart; h < videoEnd; h++) {
+            qreal a = output[h];
+
+            if (fabs(a) > level) {
+                a = (a > 0) ? level : -level;
             }
 
-            yiqBuffer[lineNumber][h].y -= a;
+            line[h].*channel -= a;
+        }
+    });
+}
+
+// Call lineFunction(lineNumber) for each active line of the frame, spread
+// across configuration.intraFrameThreads threads
+template <typename LineFunction>
+void Comb::forEachActiveLine(LineFunction lineFunction)
+{
+    const qint32 firstLine = videoParameters.firstActiveFrameLine;
+    const qint32 lastLine = videoParameters.lastActiveFrameLine;
+    const qint32 numThreads = qMax(configuration.intraFrameThreads, 1);
+
+    // Thread t does lines firstLine + t, + numThreads, ...
+    auto processLines = [&](qint32 thread) {
+        for (qint32 lineNumber = firstLine + thread; lineNumber < lastLine; lineNumber += numThreads) {
+            lineFunction(lineNumber);
         }
+    };
+
+    if (numThreads == 1) {
+        processLines(0);
+    } else {
+        QVector<qint32> threads(numThreads);
+        for (qint32 i = 0; i < numThreads; i++) threads[i] = i;
+        QtConcurrent::blockingMap(threads, [&](qint32 &thread) { processLines(thread); });
     }
 }
 
 // Convert buffer from YIQ to RGB 16-16-16
-RGBFrame Comb::yiqToRgbFrame(const YiqBuffer &yiqBuffer, qreal burstLevel)
+void Comb::yiqToRgbFrame(const YiqBuffer &yiqBuffer, qreal burstLevel, RGBFrame &rgbOutputFrame)
 {
-    RGBFrame rgbOutputFrame;
     rgbOutputFrame.resize(videoParameters.fieldWidth * frameHeight * 3); // for RGB 16-16-16
 
     // Initialise the output frame
@@ -489,9 +556,6 @@ RGBFrame Comb::yiqToRgbFrame(const YiqBuffer &yiqBuffer, qreal burstLevel)
                         &yiqBuffer[lineNumber][videoParameters.activeVideoEnd],
                         &linePointer[o]);
     }
-
-    // Return the RGB frame data
-    return rgbOutputFrame;
 }
 
 // Convert buffer from YIQ to RGB
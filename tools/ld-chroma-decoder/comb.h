@@ -53,9 +53,14 @@ public:
         bool whitePoint100 = false;
         bool use3D = false;
         bool showOpticalFlowMap = false;
+        OpticalFlow::MotionDetector motionDetector = OpticalFlow::farnebackDetector;
+        bool compareMotionDetector = false;
 
         qreal cNRLevel = 0.0;
         qreal yNRLevel = 1.0;
+
+        // Number of threads to use for the line filters within a frame
+        qint32 intraFrameThreads = 1;
     };
 
     const Configuration &getConfiguration() const;
@@ -65,6 +70,13 @@ public:
     // Decode two fields to produce an interlaced frame.
     RGBFrame decodeFrame(const SourceField &firstField, const SourceField &secondField);
 
+    // Decode two fields to produce an interlaced frame, writing the result
+    // into an existing buffer (which is resized if necessary).
+    void decodeFrame(const SourceField &firstField, const SourceField &secondField, RGBFrame &rgbOutputFrame);
+
+    // Return the motion detector comparison results (if compareMotionDetector is set)
+    const OpticalFlow::Comparison &getMotionComparison() const;
+
 protected:
 
 private:
@@ -102,6 +114,11 @@ private:
     // Previous and next frame for 3D processing
     FrameBuffer previousFrameBuffer;
 
+    // Planar scratch buffers for the line filters (one row of filterStride samples per active line)
+    qint32 filterStride;
+    QVector<double> filterInput;
+    QVector<double> filterOutput;
+
     inline qint32 GetFieldID(FrameBuffer *frameBuffer, qint32 lineNumber);
     inline bool GetLinePhase(FrameBuffer *frameBuffer, qint32 lineNumber);
 
@@ -114,8 +131,12 @@ private:
 
     void doCNR(YiqBuffer &yiqBuffer);
     void doYNR(YiqBuffer &yiqBuffer);
+    template <typename FilterType>
+    void coreChannel(YiqBuffer &yiqBuffer, qreal YIQ::*channel, const FilterType &filter, qreal level);
+    template <typename LineFunction>
+    void forEachActiveLine(LineFunction lineFunction);
 
-    RGBFrame yiqToRgbFrame(const YiqBuffer &yiqBuffer, qreal burstLevel);
+    void yiqToRgbFrame(const YiqBuffer &yiqBuffer, qreal burstLevel, RGBFrame &rgbOutputFrame);
     void overlayOpticalFlowMap(const FrameBuffer &frameBuffer, RGBFrame &rgbOutputFrame);
     void adjustY(FrameBuffer *frameBuffer, YiqBuffer &yiqBuffer);
 };
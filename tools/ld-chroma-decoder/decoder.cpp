@@ -26,6 +26,9 @@
 
 #include "decoderpool.h"
 
+#include <QElapsedTimer>
+#include <algorithm>
+
 qint32 Decoder::getLookBehind() const
 {
     return 0;
@@ -36,6 +39,14 @@ qint32 Decoder::getLookAhead() const
     return 0;
 }
 
+void Decoder::threadsFinished()
+{
+}
+
+void Decoder::reportStatistics() const
+{
+}
+
 void Decoder::setVideoParameters(Decoder::Configuration &config, const LdDecodeMetaData::VideoParameters &videoParameters) {
     config.videoParameters = videoParameters;
     config.topPadLines = 0;
@@ -81,30 +92,26 @@ void Decoder::setVideoParameters(Decoder::Configuration &config, const LdDecodeM
                "will be colourised and trimmed to" << outputWidth << "x" << outputHeight << "RGB 16-16-16 frames";
 }
 
-RGBFrame Decoder::cropOutputFrame(const Decoder::Configuration &config, const RGBFrame &outputData) {
+void Decoder::cropOutputFrame(const Decoder::Configuration &config, const RGBFrame &outputData, RGBFrame &croppedData) {
     const qint32 activeVideoStart = config.videoParameters.activeVideoStart;
     const qint32 activeVideoEnd = config.videoParameters.activeVideoEnd;
     const qint32 outputLineLength = (activeVideoEnd - activeVideoStart) * 3;
+    const qint32 activeLines = config.videoParameters.lastActiveFrameLine - config.videoParameters.firstActiveFrameLine;
 
-    RGBFrame croppedData;
+    croppedData.resize((config.topPadLines + activeLines + config.bottomPadLines) * outputLineLength);
+    quint16 *outputPointer = croppedData.data();
 
     // Insert padding at the top
-    if (config.topPadLines > 0) {
-        croppedData.insert(croppedData.begin(), config.topPadLines * outputLineLength, 0);
-    }
+    outputPointer = std::fill_n(outputPointer, config.topPadLines * outputLineLength, 0);
 
     // Copy the active region from the decoded image
     for (qint32 y = config.videoParameters.firstActiveFrameLine; y < config.videoParameters.lastActiveFrameLine; y++) {
-        croppedData.append(outputData.mid((y * config.videoParameters.fieldWidth * 3) + (activeVideoStart * 3),
-                                          outputLineLength));
+        const quint16 *inputPointer = outputData.constData() + (y * config.videoParameters.fieldWidth * 3) + (activeVideoStart * 3);
+        outputPointer = std::copy(inputPointer, inputPointer + outputLineLength, outputPointer);
     }
 
     // Insert padding at the bottom
-    if (config.bottomPadLines > 0) {
-        croppedData.insert(croppedData.end(), config.bottomPadLines * outputLineLength, 0);
-    }
-
-    return croppedData;
+    std::fill_n(outputPointer, config.bottomPadLines * outputLineLength, 0);
 }
 
 DecoderThread::DecoderThread(QAtomicInt& _abort, DecoderPool& _decoderPool, QObject *parent)
@@ -126,14 +133,19 @@ void DecoderThread::run()
             break;
         }
 
-        // Adjust the output to the right size
+        // Adjust the output to the right size, reusing buffers from the pool
         outputFrames.resize((endIndex - startIndex) / 2);
+        decoderPool.getOutputFrames(outputFrames);
 
         // Decode the fields to frames
+        QElapsedTimer decodeTimer;
+        decodeTimer.start();
         decodeFrames(inputFields, startIndex, endIndex, outputFrames);
+        const qint64 decodeNsecs = decodeTimer.nsecsElapsed();
+        decoderPool.getStatistics().addTime(PoolStatistics::processStage, decodeNsecs);
 
         // Write the frames to the output file
-        if (!decoderPool.putOutputFrames(startFrameNumber, outputFrames)) {
+        if (!decoderPool.putOutputFrames(startFrameNumber, outputFrames, decodeNsecs)) {
             abort = true;
             break;
         }
@@ -76,6 +76,14 @@ public:
     // Construct a new worker thread
     virtual QThread *makeThread(QAtomicInt& abort, DecoderPool& decoderPool) = 0;
 
+    // After all the worker threads have finished (or aborted), release any
+    // state shared between them. The default implementation does nothing.
+    virtual void threadsFinished();
+
+    // After all the worker threads have finished, report any statistics the
+    // decoder has collected. The default implementation does nothing.
+    virtual void reportStatistics() const;
+
     // Parameters used by the decoder and its threads.
     // This may be subclassed by decoders to add extra parameters.
     struct Configuration {
@@ -89,8 +97,10 @@ public:
     // video region as required
     static void setVideoParameters(Configuration &config, const LdDecodeMetaData::VideoParameters &videoParameters);
 
-    // Crop a full decoded frame to the output frame size
-    static RGBFrame cropOutputFrame(const Configuration &config, const RGBFrame &outputData);
+    // Crop a full decoded frame to the output frame size, writing the result
+    // into croppedData (which is resized if necessary, so a buffer from a
+    // previous frame can be reused without reallocating)
+    static void cropOutputFrame(const Configuration &config, const RGBFrame &outputData, RGBFrame &croppedData);
 };
 
 // Abstract base class for chroma decoder worker threads.
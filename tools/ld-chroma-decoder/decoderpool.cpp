@@ -33,11 +33,38 @@ DecoderPool::DecoderPool(Decoder &_decoder, QString _inputFileName,
                          qint32 _startFrame, qint32 _length, qint32 _maxThreads)
     : decoder(_decoder), inputFileName(_inputFileName),
       outputFileName(_outputFileName), startFrame(_startFrame),
-      length(_length), maxThreads(_maxThreads),
-      abort(false), ldDecodeMetaData(_ldDecodeMetaData)
+      length(_length), maxThreads(_maxThreads), benchmarkMode(false), processNsecs(0),
+      resume(false), abort(false), ldDecodeMetaData(_ldDecodeMetaData)
 {
 }
 
+void DecoderPool::setBenchmarkInput(const QVector<SourceVideo::Data> &inputFieldData)
+{
+    benchmarkMode = true;
+    benchmarkFieldData = inputFieldData;
+}
+
+const QVector<qint64> &DecoderPool::getFrameDecodeNsecs() const
+{
+    return frameDecodeNsecs;
+}
+
+qint64 DecoderPool::getProcessNsecs() const
+{
+    return processNsecs;
+}
+
+PoolStatistics &DecoderPool::getStatistics()
+{
+    return statistics;
+}
+
+void DecoderPool::setCheckpoint(const QByteArray &runKey, bool _resume)
+{
+    checkpoint.enable(outputFileName, runKey);
+    resume = _resume;
+}
+
 bool DecoderPool::process()
 {
     LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
@@ -52,7 +79,12 @@ bool DecoderPool::process()
     decoderLookAhead = decoder.getLookAhead();
 
     // Open the source video file
-    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
+    if (benchmarkMode) {
+        if (!sourceVideo.open(benchmarkFieldData)) {
+            qInfo() << "Unable to use benchmark input data";
+            return false;
+        }
+    } else if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
         // Could not open source video file
         qInfo() << "Unable to open ld-decode video file";
         return false;
@@ -76,8 +108,29 @@ bool DecoderPool::process()
         }
     }
 
+    // If we're resuming, find the last frame written before the interruption.
+    // Decoding starts from the frame after it; the decoder's lookbehind is
+    // loaded from the input as usual.
+    firstFrameNumber = startFrame;
+    outputBytes = 0;
+    if (resume) {
+        qint32 lastWrittenFrame;
+        if (!checkpoint.read(lastWrittenFrame, outputBytes)) {
+            sourceVideo.close();
+            return false;
+        }
+        if (lastWrittenFrame < (startFrame - 1) || lastWrittenFrame > length + (startFrame - 1)) {
+            qCritical() << "Cannot resume - checkpoint frame" << lastWrittenFrame << "is outside the range being processed";
+            sourceVideo.close();
+            return false;
+        }
+        firstFrameNumber = lastWrittenFrame + 1;
+    }
+
     // Open the output RGB file
-    if (outputFileName == "-") {
+    if (benchmarkMode) {
+        // The output is discarded
+    } else if (outputFileName == "-") {
         // No output filename, use stdout instead
         if (!targetVideo.open(stdout, QIODevice::WriteOnly)) {
             // Failed to open stdout
@@ -86,6 +139,28 @@ bool DecoderPool::process()
             return false;
         }
         qInfo() << "Using stdout as RGB output";
+    } else if (resume) {
+        // Reopen the existing output file, discarding anything that was
+        // written after the checkpoint, and append to it
+        targetVideo.setFileName(outputFileName);
+        if (!targetVideo.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qCritical() << "Could not open " << outputFileName << "as RGB output file";
+            sourceVideo.close();
+            return false;
+        }
+        if (targetVideo.size() < outputBytes) {
+            qCritical() << "Cannot resume - output file" << outputFileName << "is shorter than the checkpoint expects";
+            sourceVideo.close();
+            targetVideo.close();
+            return false;
+        }
+        if (!targetVideo.resize(outputBytes)) {
+            qCritical() << "Cannot resume - could not truncate output file" << outputFileName;
+            sourceVideo.close();
+            targetVideo.close();
+            return false;
+        }
+        qInfo() << "Resuming after frame #" << firstFrameNumber - 1 << "with" << outputBytes << "bytes already written";
     } else {
         // Open output file
         targetVideo.setFileName(outputFileName);
@@ -101,16 +176,27 @@ bool DecoderPool::process()
     qInfo() << "Processing from start frame #" << startFrame << "with a length of" << length << "frames";
 
     // Initialise processing state
-    inputFrameNumber = startFrame;
-    outputFrameNumber = startFrame;
+    inputFrameNumber = firstFrameNumber;
+    outputFrameNumber = firstFrameNumber;
+    previousFields.clear();
+    freeOutputFrames.clear();
+    frameDecodeNsecs.fill(0, length);
     lastFrameNumber = length + (startFrame - 1);
-    totalTimer.start();
 
-    // Start a vector of filtering threads to process the video
+    // Create a vector of filtering threads to process the video. Constructing
+    // the threads may involve some setup (e.g. planning FFTs), so the timer
+    // starts once they are all ready.
     QVector<QThread *> threads;
     threads.resize(maxThreads);
     for (qint32 i = 0; i < maxThreads; i++) {
         threads[i] = decoder.makeThread(abort, *this);
+    }
+
+    // Start the threads
+    totalTimer.start();
+    statistics.start(maxThreads);
+    checkpoint.start();
+    for (qint32 i = 0; i < maxThreads; i++) {
         threads[i]->start(QThread::LowPriority);
     }
 
@@ -119,6 +205,7 @@ bool DecoderPool::process()
         threads[i]->wait();
         delete threads[i];
     }
+    decoder.threadsFinished();
 
     // Did any of the threads abort?
     if (abort) {
@@ -136,9 +223,13 @@ bool DecoderPool::process()
         return false;
     }
 
+    processNsecs = totalTimer.nsecsElapsed();
+    const qint32 processedFrames = lastFrameNumber + 1 - firstFrameNumber;
     qreal totalSecs = (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
-    qInfo() << "Processing complete -" << length << "frames in" << totalSecs << "seconds (" <<
-               length / totalSecs << "FPS )";
+    qInfo() << "Processing complete -" << processedFrames << "frames in" << totalSecs << "seconds (" <<
+               processedFrames / totalSecs << "FPS )";
+    decoder.reportStatistics();
+    statistics.finish("frames");
 
     // Close the source video
     sourceVideo.close();
@@ -146,12 +237,20 @@ bool DecoderPool::process()
     // Close the target video
     targetVideo.close();
 
+    // The output is complete, so the checkpoint is no longer needed
+    checkpoint.remove();
+
+    // Free the output buffers
+    freeOutputFrames.clear();
+
     return true;
 }
 
 bool DecoderPool::getInputFrames(qint32 &startFrameNumber, QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex)
 {
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::inputWaitStage);
     QMutexLocker locker(&inputMutex);
+    waitTimer.stop();
 
     // Work out a reasonable batch size to provide work for all threads.
     // This assumes that the synchronisation to get a new batch is less
@@ -170,23 +269,51 @@ bool DecoderPool::getInputFrames(qint32 &startFrameNumber, QVector<SourceField>
     startFrameNumber = inputFrameNumber;
     inputFrameNumber += batchFrames;
 
-    // Load the fields
+    // Load the fields, reusing any that were loaded for the previous batch
+    PoolStatistics::Timer readTimer(statistics, PoolStatistics::readStage);
     SourceField::loadFields(sourceVideo, ldDecodeMetaData,
                             startFrameNumber, batchFrames, decoderLookBehind, decoderLookAhead,
-                            fields, startIndex, endIndex);
+                            fields, startIndex, endIndex, previousFields);
+    previousFields = fields;
 
     return true;
 }
 
-bool DecoderPool::putOutputFrames(qint32 startFrameNumber, const QVector<RGBFrame> &outputFrames)
+void DecoderPool::getOutputFrames(QVector<RGBFrame> &outputFrames)
 {
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::outputWaitStage);
     QMutexLocker locker(&outputMutex);
+    waitTimer.stop();
+
+    for (RGBFrame &outputFrame : outputFrames) {
+        if (freeOutputFrames.isEmpty()) break;
+        if (!outputFrame.isEmpty()) continue;
+
+        outputFrame.swap(freeOutputFrames.last());
+        freeOutputFrames.removeLast();
+    }
+}
 
+bool DecoderPool::putOutputFrames(qint32 startFrameNumber, QVector<RGBFrame> &outputFrames, qint64 decodeNsecs)
+{
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::outputWaitStage);
+    QMutexLocker locker(&outputMutex);
+    waitTimer.stop();
+
+    const qint32 firstOutputFrameNumber = outputFrameNumber;
     for (qint32 i = 0; i < outputFrames.size(); i++) {
+        frameDecodeNsecs[startFrameNumber + i - startFrame] = decodeNsecs / outputFrames.size();
+
         if (!putOutputFrame(startFrameNumber + i, outputFrames[i])) {
             return false;
         }
     }
+    statistics.recordOutput(outputFrameNumber - firstOutputFrameNumber, pendingOutputFrames.size());
+
+    // Write a checkpoint if one is due
+    if (checkpoint.isDue()) {
+        checkpoint.write(targetVideo, outputFrameNumber - 1, outputBytes);
+    }
 
     return true;
 }
@@ -199,26 +326,32 @@ bool DecoderPool::putOutputFrames(qint32 startFrameNumber, const QVector<RGBFram
 // whether we can now write some of them out.
 //
 // Returns true on success, false on failure.
-bool DecoderPool::putOutputFrame(qint32 frameNumber, const RGBFrame &outputFrame)
+bool DecoderPool::putOutputFrame(qint32 frameNumber, RGBFrame &outputFrame)
 {
-    // Put this frame into the map
-    pendingOutputFrames[frameNumber] = outputFrame;
+    // Move this frame into the map
+    pendingOutputFrames[frameNumber].swap(outputFrame);
 
     // Write out as many frames as possible
     while (pendingOutputFrames.contains(outputFrameNumber)) {
-        const RGBFrame& outputData = pendingOutputFrames.value(outputFrameNumber);
+        RGBFrame &outputData = pendingOutputFrames[outputFrameNumber];
 
         // Save the frame data to the output file
-        if (!targetVideo.write(reinterpret_cast<const char *>(outputData.data()), outputData.size() * 2)) {
+        PoolStatistics::Timer writeTimer(statistics, PoolStatistics::writeStage);
+        if (!benchmarkMode && !targetVideo.write(reinterpret_cast<const char *>(outputData.data()), outputData.size() * 2)) {
             // Could not write to target video file
             qCritical() << "Writing to the output video file failed";
             return false;
         }
+        writeTimer.stop();
+        outputBytes += outputData.size() * 2;
 
+        // The frame has been written, so return its buffer to the pool
+        freeOutputFrames.append(RGBFrame());
+        freeOutputFrames.last().swap(outputData);
         pendingOutputFrames.remove(outputFrameNumber);
         outputFrameNumber++;
 
-        const qint32 outputCount = outputFrameNumber - startFrame;
+        const qint32 outputCount = outputFrameNumber - firstFrameNumber;
         if ((outputCount % 32) == 0) {
             // Show an update to the user
             qreal fps = outputCount / (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
@@ -33,7 +33,9 @@
 #include <QThread>
 #include <QVector>
 
+#include "checkpoint.h"
 #include "lddecodemetadata.h"
+#include "poolstatistics.h"
 #include "sourcevideo.h"
 
 #include "decoder.h"
@@ -50,6 +52,30 @@ public:
     // Returns true on success; on failure, prints a message and returns false.
     bool process();
 
+    // For benchmarking: read the input fields from memory rather than from
+    // inputFileName, and discard the output rather than writing it to
+    // outputFileName. Call before process().
+    void setBenchmarkInput(const QVector<SourceVideo::Data> &inputFieldData);
+
+    // After process(), return the time taken to decode each frame (i.e. the
+    // time each worker took to decode a batch, divided by the number of
+    // frames in it), in frame order.
+    const QVector<qint64> &getFrameDecodeNsecs() const;
+
+    // After process(), return the total time taken to decode all the frames
+    qint64 getProcessNsecs() const;
+
+    // Get the timing statistics for this pool. These are disabled unless
+    // enabled before process() is called.
+    PoolStatistics &getStatistics();
+
+    // Write checkpoints while processing, so an interrupted run can be
+    // resumed. runKey identifies the settings for the run. If resume is true,
+    // verify the existing checkpoint and output file, then continue after the
+    // last frame written. Call before process(); checkpoints can't be used
+    // when the output is stdout.
+    void setCheckpoint(const QByteArray &runKey, bool resume);
+
     // For worker threads: get the next batch of data from the input file.
     //
     // fields will be resized and filled with pairs of SourceFields; entries
@@ -66,16 +92,26 @@ public:
     // been reached.
     bool getInputFrames(qint32 &startFrameNumber, QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex);
 
+    // For worker threads: get buffers to decode output frames into.
+    //
+    // Each empty entry in outputFrames is replaced with a buffer from the pool
+    // of output frames that have already been written, if there is one. The
+    // buffers will have the size of a previous output frame; the decoder
+    // should write (or resize) the whole frame.
+    void getOutputFrames(QVector<RGBFrame> &outputFrames);
+
     // For worker threads: return decoded frames to write to the output file.
     //
     // outputFrames should contain RGB16-16-16 output frames, with the first
-    // frame being startFrameNumber.
+    // frame being startFrameNumber. The frames are moved out of outputFrames
+    // (leaving it with empty entries), and returned to the pool once they have
+    // been written. decodeNsecs is the time taken to decode the batch.
     //
     // Returns true on success, false on failure.
-    bool putOutputFrames(qint32 startFrameNumber, const QVector<RGBFrame> &outputFrames);
+    bool putOutputFrames(qint32 startFrameNumber, QVector<RGBFrame> &outputFrames, qint64 decodeNsecs);
 
 private:
-    bool putOutputFrame(qint32 frameNumber, const RGBFrame &outputFrame);
+    bool putOutputFrame(qint32 frameNumber, RGBFrame &outputFrame);
 
     // Default batch size, in frames
     static constexpr qint32 DEFAULT_BATCH_SIZE = 16;
@@ -88,6 +124,17 @@ private:
     qint32 length;
     qint32 maxThreads;
 
+    // Benchmark mode
+    bool benchmarkMode;
+    QVector<SourceVideo::Data> benchmarkFieldData;
+    QVector<qint64> frameDecodeNsecs;
+    qint64 processNsecs;
+
+    // Checkpoint/resume state
+    Checkpoint checkpoint;
+    bool resume;
+    qint32 firstFrameNumber;
+
     // Atomic abort flag shared by worker threads; workers watch this, and shut
     // down as soon as possible if it becomes true
     QAtomicInt abort;
@@ -101,12 +148,21 @@ private:
     LdDecodeMetaData &ldDecodeMetaData;
     SourceVideo sourceVideo;
 
+    // The fields loaded for the previous batch; consecutive batches overlap
+    // by the lookbehind and lookahead, so these fields can be reused
+    QVector<SourceField> previousFields;
+
     // Output stream information (all guarded by outputMutex while threads are running)
     QMutex outputMutex;
     qint32 outputFrameNumber;
     QMap<qint32, RGBFrame> pendingOutputFrames;
+    QVector<RGBFrame> freeOutputFrames;
     QFile targetVideo;
+    qint64 outputBytes;
     QElapsedTimer totalTimer;
+
+    // Timing statistics
+    PoolStatistics statistics;
 };
 
 #endif // DECODERPOOL_H
@@ -0,0 +1,282 @@
+/************************************************************************
+
+    encoder.cpp
+
+    ld-chroma-encoder - PAL/NTSC encoder for testing
+    Copyright (C) 2019-2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "encoder.h"
+
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <cmath>
+
+// The line modulation uses SSE2 (which all x86-64 CPUs have) when the
+// compiler has it enabled
+#if defined(__SSE2__)
+#define ENCODER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Number of frames to encode per thread in each batch
+static const qint32 FRAMES_PER_THREAD = 2;
+
+Encoder::Encoder(QIODevice &_rgbFile, QIODevice &_tbcFile, LdDecodeMetaData &_metaData)
+    : rgbFile(_rgbFile), tbcFile(_tbcFile), metaData(_metaData)
+{
+}
+
+bool Encoder::encode()
+{
+    // Allocate the buffers for a batch of frames.
+    // The RGB data is triples of 16-bit unsigned numbers in native byte order.
+    const qint32 batchFrames = qMax(1, QThreadPool::globalInstance()->maxThreadCount()) * FRAMES_PER_THREAD;
+    QVector<QByteArray> rgbFrames(batchFrames);
+    for (QByteArray &rgbFrame : rgbFrames) {
+        rgbFrame.resize(activeWidth * activeHeight * 3 * 2);
+    }
+    QVector<QVector<quint16>> outputFields(2 * batchFrames);
+
+    // Process batches of frames until EOF
+    qint32 numFrames = 0;
+    while (true) {
+        // Read the input frames
+        qint32 numBatchFrames = 0;
+        while (numBatchFrames < batchFrames) {
+            qint32 result = readFrame(rgbFrames[numBatchFrames]);
+            if (result == -1) {
+                return false;
+            } else if (result == 0) {
+                break;
+            }
+            numBatchFrames++;
+        }
+        if (numBatchFrames == 0) {
+            break;
+        }
+
+        // Encode the fields in parallel
+        QVector<qint32> fieldIndexes(2 * numBatchFrames);
+        for (qint32 i = 0; i < fieldIndexes.size(); i++) fieldIndexes[i] = i;
+        QtConcurrent::blockingMap(fieldIndexes, [&](qint32 &i) {
+            encodeField((numFrames * 2) + i, rgbFrames[i / 2], outputFields[i]);
+        });
+
+        // Write the fields and their metadata, in order
+        for (qint32 i = 0; i < fieldIndexes.size(); i++) {
+            if (!writeField(outputFields[i])) {
+                return false;
+            }
+            metaData.appendField(getFieldMetadata((numFrames * 2) + i));
+        }
+
+        numFrames += numBatchFrames;
+    }
+
+    // Store video parameters, now we've generated all the fields
+    metaData.setVideoParameters(videoParameters);
+
+    return true;
+}
+
+qint32 Encoder::getActiveWidth() const
+{
+    return activeWidth;
+}
+
+qint32 Encoder::getActiveHeight() const
+{
+    return activeHeight;
+}
+
+// Read one frame from the input.
+// Returns 0 on EOF, 1 on success; on failure, prints an error and returns -1.
+qint32 Encoder::readFrame(QByteArray &rgbFrame)
+{
+    qint64 remainBytes = rgbFrame.size();
+    qint64 posBytes = 0;
+    while (remainBytes > 0) {
+        qint64 count = rgbFile.read(rgbFrame.data() + posBytes, remainBytes);
+        if (count == 0 && remainBytes == rgbFrame.size()) {
+            // EOF at the start of a frame
+            return 0;
+        } else if (count == 0) {
+            qCritical() << "Unexpected end of input file";
+            return -1;
+        } else if (count < 0) {
+            qCritical() << "Error reading from input file";
+            return -1;
+        }
+        remainBytes -= count;
+        posBytes += count;
+    }
+
+    return 1;
+}
+
+// Encode one field from rgbFrame into outputField.
+//
+// Each frame is written as two fields -- even-numbered lines, then
+// odd-numbered lines. In a TBC file, the first field is the one that starts on
+// frame line 0 (for PAL, this is the one with the half-line at frame line 44).
+void Encoder::encodeField(qint32 fieldNo, const QByteArray &rgbFrame, QVector<quint16> &outputField) const
+{
+    const qint32 lineOffset = fieldNo % 2;
+    const qint32 fieldWidth = videoParameters.fieldWidth;
+
+    // TBC data is unsigned 16-bit values in native byte order
+    outputField.resize(fieldWidth * videoParameters.fieldHeight);
+
+    LineBuffers buffers;
+    buffers.Y.resize(fieldWidth);
+    buffers.C1.resize(fieldWidth);
+    buffers.C2.resize(fieldWidth);
+    buffers.sinCarrier.resize(fieldWidth);
+    buffers.cosCarrier.resize(fieldWidth);
+
+    for (qint32 fieldLine = 0; fieldLine < videoParameters.fieldHeight; fieldLine++) {
+        const qint32 frameLine = (fieldLine * 2) + lineOffset;
+
+        // Encode the line
+        const quint16 *rgbData = nullptr;
+        if (frameLine >= activeTop && frameLine < (activeTop + activeHeight)) {
+            rgbData = reinterpret_cast<const quint16 *>(rgbFrame.data()) + ((frameLine - activeTop) * activeWidth * 3);
+        }
+        encodeLine(fieldNo, frameLine, rgbData, buffers, outputField.data() + (fieldLine * fieldWidth));
+    }
+}
+
+// Write one field to the output.
+// Returns true on success; on failure, prints an error and returns false.
+bool Encoder::writeField(const QVector<quint16> &outputField)
+{
+    const char *outputData = reinterpret_cast<const char *>(outputField.data());
+    qint64 remainBytes = outputField.size() * 2;
+    qint64 posBytes = 0;
+    while (remainBytes > 0) {
+        qint64 count = tbcFile.write(outputData + posBytes, remainBytes);
+        if (count < 0) {
+            qCritical() << "Error writing to output file";
+            return false;
+        }
+        remainBytes -= count;
+        posBytes += count;
+    }
+
+    return true;
+}
+
+void Encoder::computeGates(double sampleRate, double fSC)
+{
+    // Compute colourburst gating profile [Poynton p530]
+    const double halfBurstRiseTime = 300.0e-9 / 2.0;
+    const double burstStartTime = (1.0 * videoParameters.colourBurstStart) / sampleRate;
+    const double burstEndTime = (1.0 * videoParameters.colourBurstEnd) / sampleRate;
+
+    // Compute luma/chroma gating profiles to avoid sharp transitions at the
+    // edge of the active region. The rise times are as suggested in
+    // [Poynton p323], timed so that the video reaches full amplitude at the
+    // start/end of the active region.
+    const double halfLumaRiseTime = 2.0 / (4.0 * fSC);
+    const double halfChromaRiseTime = 3.0 / (4.0 * fSC);
+    const double activeStartTime = ((1.0 * videoParameters.activeVideoStart) / sampleRate) - (2.0 * halfChromaRiseTime);
+    const double activeEndTime = (1.0 * videoParameters.activeVideoEnd) / sampleRate + (2.0 * halfChromaRiseTime);
+
+    burstGate.resize(videoParameters.fieldWidth);
+    lumaGate.resize(videoParameters.fieldWidth);
+    chromaGate.resize(videoParameters.fieldWidth);
+    for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
+        const double t = (1.0 * x) / sampleRate;
+        burstGate[x] = raisedCosineGate(t, burstStartTime, burstEndTime, halfBurstRiseTime);
+        lumaGate[x] = raisedCosineGate(t, activeStartTime, activeEndTime, halfLumaRiseTime);
+        chromaGate[x] = raisedCosineGate(t, activeStartTime, activeEndTime, halfChromaRiseTime);
+    }
+}
+
+void Encoder::modulateLine(const LineBuffers &buffers, const double *sinCarrier, const double *cosCarrier,
+                           double burstSin, double burstCos, double chromaSin, double chromaCos,
+                           quint16 *outputLine) const
+{
+    const double *Y = buffers.Y.data();
+    const double *C1 = buffers.C1.data();
+    const double *C2 = buffers.C2.data();
+    const double scale = videoParameters.white16bIre - videoParameters.black16bIre;
+    const double offset = videoParameters.black16bIre;
+    const qint32 width = videoParameters.fieldWidth;
+
+    qint32 x = 0;
+
+#ifdef ENCODER_HAVE_SSE2
+    // Two samples at a time. This does exactly the same arithmetic as the
+    // loop below, so the results are identical.
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d maxSample = _mm_set1_pd(65535.0);
+    for (; x + 2 <= width; x += 2) {
+        const __m128d s = _mm_loadu_pd(sinCarrier + x);
+        const __m128d c = _mm_loadu_pd(cosCarrier + x);
+
+        const __m128d burst = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(burstSin), s), _mm_mul_pd(_mm_set1_pd(burstCos), c));
+        const __m128d chroma = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(chromaSin), _mm_mul_pd(_mm_loadu_pd(C1 + x), s)),
+                                          _mm_mul_pd(_mm_set1_pd(chromaCos), _mm_mul_pd(_mm_loadu_pd(C2 + x), c)));
+
+        const __m128d lg = _mm_loadu_pd(lumaGate.data() + x);
+        const __m128d cg = _mm_loadu_pd(chromaGate.data() + x);
+        const __m128d luma = _mm_max_pd(_mm_min_pd(lg, _mm_loadu_pd(Y + x)), _mm_xor_pd(lg, signMask));
+        const __m128d gatedChroma = _mm_max_pd(_mm_min_pd(cg, chroma), _mm_xor_pd(cg, signMask));
+
+        const __m128d composite = _mm_add_pd(_mm_add_pd(_mm_mul_pd(burst, _mm_loadu_pd(burstGate.data() + x)), luma), gatedChroma);
+        const __m128d scaled = _mm_add_pd(_mm_mul_pd(composite, _mm_set1_pd(scale)), _mm_set1_pd(offset));
+
+        const __m128i samples = _mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(maxSample, scaled), _mm_setzero_pd()));
+        outputLine[x] = static_cast<quint16>(_mm_cvtsi128_si32(samples));
+        outputLine[x + 1] = static_cast<quint16>(_mm_cvtsi128_si32(_mm_srli_si128(samples, 4)));
+    }
+#endif
+
+    for (; x < width; x++) {
+        const double burst = (burstSin * sinCarrier[x]) + (burstCos * cosCarrier[x]);
+        const double chroma = (chromaSin * (C1[x] * sinCarrier[x])) + (chromaCos * (C2[x] * cosCarrier[x]));
+
+        // Combine everything to make up the composite signal
+        const double composite = (burst * burstGate[x]) + qBound(-lumaGate[x], Y[x], lumaGate[x])
+                                 + qBound(-chromaGate[x], chroma, chromaGate[x]);
+
+        // Scale to a 16-bit output sample and limit the excursion. Some RGB
+        // colours (e.g. strongly saturated yellows) can go outside ld-decode's
+        // usual range.
+        const double scaled = (composite * scale) + offset;
+        outputLine[x] = static_cast<quint16>(qBound(0.0, scaled, 65535.0));
+    }
+}
+
+double Encoder::raisedCosineGate(double t, double startTime, double endTime, double halfRiseTime)
+{
+    if (t < startTime - halfRiseTime) {
+        return 0.0;
+    } else if (t < startTime + halfRiseTime) {
+        return 0.5 + (0.5 * sin((M_PI / 2.0) * ((t - startTime) / halfRiseTime)));
+    } else if (t < endTime - halfRiseTime) {
+        return 1.0;
+    } else if (t < endTime + halfRiseTime) {
+        return 0.5 - (0.5 * sin((M_PI / 2.0) * ((t - endTime) / halfRiseTime)));
+    } else {
+        return 0.0;
+    }
+}
@@ -0,0 +1,117 @@
+/************************************************************************
+
+    encoder.h
+
+    ld-chroma-encoder - PAL/NTSC encoder for testing
+    Copyright (C) 2019-2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QVector>
+
+#include "lddecodemetadata.h"
+
+// Abstract base class for the test-signal encoders.
+//
+// This reads RGB frames from the input, splits them into fields, and writes
+// the fields to the TBC output and metadata. Frames are read in batches, and
+// the fields in each batch are encoded in parallel using the global
+// QThreadPool, then written out in order. Subclasses set up the video
+// parameters and active region in their constructors (then call
+// computeGates), and implement encodeLine and getFieldMetadata for their
+// video standard.
+class Encoder
+{
+public:
+    Encoder(QIODevice &rgbFile, QIODevice &tbcFile, LdDecodeMetaData &metaData);
+    virtual ~Encoder() = default;
+
+    // Encode RGB stream to TBC.
+    // Returns true on success; on failure, prints an error and returns false.
+    bool encode();
+
+    // Return the dimensions of the input RGB frames
+    qint32 getActiveWidth() const;
+    qint32 getActiveHeight() const;
+
+protected:
+    // Working storage for encodeLine. Each thread has its own.
+    struct LineBuffers {
+        // Luma and the two chroma components, scaled so that 0.0 is black
+        // and 1.0 is white
+        QVector<double> Y;
+        QVector<double> C1;
+        QVector<double> C2;
+
+        // Subcarrier for the current line
+        QVector<double> sinCarrier;
+        QVector<double> cosCarrier;
+    };
+
+    // Encode one line of a field into outputLine, which has fieldWidth
+    // samples. rgbData points to the line's RGB samples, or is nullptr if the
+    // line is outside the active region. This may be called from several
+    // threads at once.
+    virtual void encodeLine(qint32 fieldNo, qint32 frameLine, const quint16 *rgbData,
+                            LineBuffers &buffers, quint16 *outputLine) const = 0;
+
+    // Return the metadata for a field
+    virtual LdDecodeMetaData::Field getFieldMetadata(qint32 fieldNo) = 0;
+
+    // Compute the burst and active-region gating profiles, given the sample
+    // rate and subcarrier frequency
+    void computeGates(double sampleRate, double fSC);
+
+    // Combine the components in buffers into a composite signal, and write it
+    // to outputLine as 16-bit samples. The carrier is given by sinCarrier and
+    // cosCarrier. The burst is (burstSin * sin) + (burstCos * cos), and the
+    // chroma is (chromaSin * C1 * sin) + (chromaCos * C2 * cos).
+    void modulateLine(const LineBuffers &buffers, const double *sinCarrier, const double *cosCarrier,
+                      double burstSin, double burstCos, double chromaSin, double chromaCos,
+                      quint16 *outputLine) const;
+
+    // Generate a gate waveform with raised-cosine transitions, with 50% points at given start and end times
+    static double raisedCosineGate(double t, double startTime, double endTime, double halfRiseTime);
+
+    LdDecodeMetaData::VideoParameters videoParameters;
+    qint32 activeWidth;
+    qint32 activeHeight;
+    qint32 activeLeft;
+    qint32 activeTop;
+
+private:
+    qint32 readFrame(QByteArray &rgbFrame);
+    void encodeField(qint32 fieldNo, const QByteArray &rgbFrame, QVector<quint16> &outputField) const;
+    bool writeField(const QVector<quint16> &outputField);
+
+    QIODevice &rgbFile;
+    QIODevice &tbcFile;
+    LdDecodeMetaData &metaData;
+
+    // Gating profiles for each sample of a line
+    QVector<double> burstGate;
+    QVector<double> lumaGate;
+    QVector<double> chromaGate;
+};
+
+#endif
@@ -27,10 +27,13 @@
 #include <QFile>
 #include <QtGlobal>
 #include <QCommandLineParser>
+#include <QScopedPointer>
+#include <QThreadPool>
 #include <cstdio>
 
 #include "lddecodemetadata.h"
 
+#include "ntscencoder.h"
 #include "palencoder.h"
 
 // Global for debug output
@@ -94,7 +97,7 @@ int main(int argc, char *argv[])
     // Set up the command line parser
     QCommandLineParser parser;
     parser.setApplicationDescription(
-                "ld-chroma-encoder - PAL encoder for testing\n"
+                "ld-chroma-encoder - PAL/NTSC encoder for testing\n"
                 "\n"
                 "(c)2019 Adam Sampson\n"
                 "GPLv3 Open-Source - github: https://github.com/happycube/ld-decode");
@@ -113,6 +116,18 @@ int main(int argc, char *argv[])
                                        QCoreApplication::translate("main", "Suppress info and warning messages"));
     parser.addOption(setQuietOption);
 
+    // Option to select the video system
+    QCommandLineOption systemOption(QStringList() << "system",
+                                    QCoreApplication::translate("main", "Video system to encode (pal, ntsc; default pal)"),
+                                    QCoreApplication::translate("main", "system"));
+    parser.addOption(systemOption);
+
+    // Option to select the number of threads (-t)
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads",
+                                     QCoreApplication::translate("main", "Specify the number of concurrent threads (default number of logical CPUs)"),
+                                     QCoreApplication::translate("main", "number"));
+    parser.addOption(threadsOption);
+
     // -- Positional arguments --
 
     // Positional argument to specify input video file
@@ -147,6 +162,30 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    QString systemName = "pal";
+    if (parser.isSet(systemOption)) {
+        systemName = parser.value(systemOption);
+
+        if (systemName != "pal" && systemName != "ntsc") {
+            // Quit with error
+            qCritical() << "Unknown video system" << systemName;
+            return -1;
+        }
+    }
+
+    if (parser.isSet(threadsOption)) {
+        const qint32 maxThreads = parser.value(threadsOption).toInt();
+
+        if (maxThreads < 1) {
+            // Quit with error
+            qCritical("Specified number of threads must be greater than zero");
+            return -1;
+        }
+
+        // The encoder uses the global thread pool
+        QThreadPool::globalInstance()->setMaxThreadCount(maxThreads);
+    }
+
     // Open the input file
     QFile rgbFile(inputFileName);
     if (inputFileName == "-") {
@@ -170,8 +209,13 @@ int main(int argc, char *argv[])
 
     // Encode the data
     LdDecodeMetaData metaData;
-    PALEncoder encoder(rgbFile, tbcFile, metaData);
-    if (!encoder.encode()) {
+    QScopedPointer<Encoder> encoder;
+    if (systemName == "ntsc") {
+        encoder.reset(new NTSCEncoder(rgbFile, tbcFile, metaData));
+    } else {
+        encoder.reset(new PALEncoder(rgbFile, tbcFile, metaData));
+    }
+    if (!encoder->encode()) {
         return -1;
     }
 
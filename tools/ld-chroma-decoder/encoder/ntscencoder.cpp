@@ -0,0 +1,179 @@
+/************************************************************************
+
+    ntscencoder.cpp
+
+    ld-chroma-encoder - NTSC encoder for testing
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+/*!
+    \class NTSCEncoder
+
+    This is a simplistic NTSC encoder for decoder testing, producing 4fSC
+    samples in the same form as ld-decode's NTSC output.
+
+    As with PALEncoder, the output includes the colourburst and encoded active
+    region, but no sync pulses. The samples are locked to the subcarrier, so
+    they fall on the I and Q axes. The subcarrier phase on each line is
+    chosen to match the field phase IDs in the metadata, as interpreted by
+    ld-chroma-decoder's NTSC comb filter: fields 1/2 and 3/4 form alternate
+    frames, and the phase inverts from line to line within a field and from
+    frame to frame.
+ */
+
+#include "ntscencoder.h"
+
+#include "firfilter.h"
+
+#include <array>
+#include <cmath>
+
+NTSCEncoder::NTSCEncoder(QIODevice &_rgbFile, QIODevice &_tbcFile, LdDecodeMetaData &_metaData)
+    : Encoder(_rgbFile, _tbcFile, _metaData)
+{
+    // NTSC subcarrier frequency
+    fSC = 315.0e6 / 88.0;
+
+    // Initialise video parameters based on ld-decode's usual output.
+    // numberOfSequentialFields will be computed automatically.
+    videoParameters.isSourcePal = false;
+    videoParameters.colourBurstStart = 76;
+    videoParameters.colourBurstEnd = 112;
+    videoParameters.activeVideoStart = 134;
+    videoParameters.activeVideoEnd = 894;
+    videoParameters.white16bIre = 51200;
+    videoParameters.black16bIre = 15360;
+    videoParameters.fieldWidth = 910;
+    videoParameters.fieldHeight = 263;
+    // If you change the sample rate, you will also need to recompute the
+    // filter coefficients below.
+    videoParameters.sampleRate = 14318181;
+    videoParameters.fsc = 3579545;
+    videoParameters.isMapped = false;
+
+    // Initialise active region dimensions, based on ld-chroma-decoder's usual
+    // output (which has two lines of padding above the first active line)
+    activeWidth = 760;
+    activeLeft = ((videoParameters.activeVideoStart + videoParameters.activeVideoEnd) / 2) - (activeWidth / 2);
+    activeTop = 38;
+    activeHeight = 525 + 1 - activeTop;
+
+    // Compute the gating profiles
+    computeGates(4.0 * fSC, fSC);
+
+    // With 4fSC sampling, each sample is 90 degrees of subcarrier, so the
+    // carrier is (+Q, -I, -Q, +I) for x % 4 = (0, 1, 2, 3)
+    static const double sinTable[4] = {0.0, 1.0, 0.0, -1.0};
+    static const double cosTable[4] = {1.0, 0.0, -1.0, 0.0};
+    sinSubcarrier.resize(videoParameters.fieldWidth);
+    cosSubcarrier.resize(videoParameters.fieldWidth);
+    for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
+        sinSubcarrier[x] = sinTable[x % 4];
+        cosSubcarrier[x] = cosTable[x % 4];
+    }
+}
+
+// Return the metadata for a field
+LdDecodeMetaData::Field NTSCEncoder::getFieldMetadata(qint32 fieldNo)
+{
+    LdDecodeMetaData::Field fieldData;
+    fieldData.isFirstField = (fieldNo % 2) == 0;
+    fieldData.syncConf = 100;
+    // Burst peak-to-peak amplitude is 40 IRE
+    fieldData.medianBurstIRE = 20.0;
+    fieldData.fieldPhaseID = getFieldPhaseID(fieldNo);
+    fieldData.audioSamples = 0;
+
+    return fieldData;
+}
+
+// Return the position of a field in the 4-field NTSC sequence (1-4)
+qint32 NTSCEncoder::getFieldPhaseID(qint32 fieldNo)
+{
+    return (fieldNo % 4) + 1;
+}
+
+// 1.3 MHz low-pass FIR filter for I.
+// Generated by: scipy.signal.firwin(9, [1.3e6/14318181], window='hamming')
+static constexpr std::array<double, 9> iFilterCoeffs {
+    0.01504706, 0.04472861, 0.12067746, 0.20150953, 0.23607471,
+    0.20150953, 0.12067746, 0.04472861, 0.01504706
+};
+static constexpr auto iFilter = makeFIRFilter(iFilterCoeffs);
+
+// 0.6 MHz low-pass FIR filter for Q.
+// Generated by: scipy.signal.firwin(17, [0.6e6/14318181], window='hamming')
+static constexpr std::array<double, 17> qFilterCoeffs {
+    0.00780770, 0.01175879, 0.02283868, 0.04000815, 0.06096058,
+    0.08250875, 0.10116664, 0.11381011, 0.11828118, 0.11381011,
+    0.10116664, 0.08250875, 0.06096058, 0.04000815, 0.02283868,
+    0.01175879, 0.00780770
+};
+static constexpr auto qFilter = makeFIRFilter(qFilterCoeffs);
+
+void NTSCEncoder::encodeLine(qint32 fieldNo, qint32 frameLine, const quint16 *rgbData,
+                             LineBuffers &buffers, quint16 *outputLine) const
+{
+    // Work out the subcarrier polarity on this line, to match the comb filter's
+    // expectation: fields 1 and 4 have positive phase on even field lines
+    const qint32 fieldID = getFieldPhaseID(fieldNo);
+    const bool isEvenLine = ((frameLine / 2) % 2) == 0;
+    const double lineSign = (((fieldID == 1) || (fieldID == 4)) == isEvenLine) ? 1.0 : -1.0;
+
+    // The burst is on the -(B-Y) axis, which is 33 degrees from the I/Q axes.
+    // Burst peak-to-peak amplitude is 40 IRE.
+    const double burstI = sin(33.0 * M_PI / 180.0) * 0.2;
+    const double burstQ = -cos(33.0 * M_PI / 180.0) * 0.2;
+
+    // Clear Y'IQ buffers. Values in these are scaled so that 0.0 is black and
+    // 1.0 is white.
+    QVector<double> &Y = buffers.Y;
+    QVector<double> &I = buffers.C1;
+    QVector<double> &Q = buffers.C2;
+    Y.fill(0.0);
+    I.fill(0.0);
+    Q.fill(0.0);
+
+    if (rgbData != nullptr) {
+        // Convert the R'G'B' data to Y'IQ form (the inverse of the matrix used by the decoder)
+        for (qint32 i = 0; i < activeWidth; i++) {
+            const double R = rgbData[i * 3]       / 65535.0;
+            const double G = rgbData[(i * 3) + 1] / 65535.0;
+            const double B = rgbData[(i * 3) + 2] / 65535.0;
+
+            const qint32 x = activeLeft + i;
+            Y[x] = (R * 0.299)    + (G * 0.587)     + (B * 0.114);
+            I[x] = (R * 0.595716) + (G * -0.274453) + (B * -0.321263);
+            Q[x] = (R * 0.211456) + (G * -0.522591) + (B * 0.311135);
+        }
+
+        // Low-pass filter I to 1.3 MHz and Q to 0.6 MHz. Outside the active
+        // region (plus the filter's overlap) the result would be 0.
+        const qint32 iOverlap = iFilterCoeffs.size() / 2;
+        const qint32 qOverlap = qFilterCoeffs.size() / 2;
+        iFilter.applyInPlace(I.data() + activeLeft - iOverlap, activeWidth + (2 * iOverlap));
+        qFilter.applyInPlace(Q.data() + activeLeft - qOverlap, activeWidth + (2 * qOverlap));
+    }
+
+    // Generate colourburst, and encode the chroma signal: Q on the cosine
+    // axis and -I on the sine axis, inverted on negative-phase lines
+    modulateLine(buffers, sinSubcarrier.data(), cosSubcarrier.data(),
+                 -burstI * lineSign, burstQ * lineSign,
+                 -lineSign, lineSign, outputLine);
+}
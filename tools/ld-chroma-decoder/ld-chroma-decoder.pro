@@ -1,4 +1,5 @@
 QT -= gui
+QT += concurrent
 
 CONFIG += c++11 console
 CONFIG -= app_bundle
@@ -15,6 +16,7 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    benchmark.cpp \
     comb.cpp \
     decoder.cpp \
     decoderpool.cpp \
@@ -30,13 +32,20 @@ SOURCES += \
     transformpal.cpp \
     transformpal2d.cpp \
     transformpal3d.cpp \
+    transformpal3dcache.cpp \
     yiq.cpp \
+    encoder/encoder.cpp \
+    encoder/ntscencoder.cpp \
+    encoder/palencoder.cpp \
+    ../library/tbc/checkpoint.cpp \
     ../library/tbc/lddecodemetadata.cpp \
+    ../library/tbc/poolstatistics.cpp \
     ../library/tbc/sourcevideo.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp
 
 HEADERS += \
+    benchmark.h \
     comb.h \
     decoder.h \
     decoderpool.h \
@@ -52,11 +61,18 @@ HEADERS += \
     transformpal.h \
     transformpal2d.h \
     transformpal3d.h \
+    transformpal3dcache.h \
     yiq.h \
     yiqbuffer.h \
+    encoder/encoder.h \
+    encoder/ntscencoder.h \
+    encoder/palencoder.h \
     ../library/filter/deemp.h \
+    ../library/filter/firfilter.h \
     ../library/filter/iirfilter.h \
+    ../library/tbc/checkpoint.h \
     ../library/tbc/lddecodemetadata.h \
+    ../library/tbc/poolstatistics.h \
     ../library/tbc/sourcevideo.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h
@@ -31,9 +31,12 @@
 #include <QThread>
 #include <fstream>
 
+#include "benchmark.h"
+#include "checkpoint.h"
 #include "decoderpool.h"
 #include "lddecodemetadata.h"
 #include "logging.h"
+#include "poolstatistics.h"
 
 #include "comb.h"
 #include "monodecoder.h"
@@ -123,6 +126,9 @@ int main(int argc, char *argv[])
     // Add the standard debug options --debug and --quiet
     addStandardDebugOptions(parser);
 
+    // Add the standard statistics options --stats and --stats-json
+    addStandardStatisticsOptions(parser);
+
     // Option to specify a different JSON input file
     QCommandLineOption inputJsonOption(QStringList() << "input-json",
                                        QCoreApplication::translate("main", "Specify the input JSON file (default input.json)"),
@@ -163,6 +169,16 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number"));
     parser.addOption(threadsOption);
 
+    // Option to run the throughput benchmark
+    QCommandLineOption benchmarkOption(QStringList() << "benchmark",
+                                       QCoreApplication::translate("main", "Benchmark the decoder on generated input, writing JSON results to output (default -)"));
+    parser.addOption(benchmarkOption);
+
+    // Option to resume an interrupted run from its checkpoint
+    QCommandLineOption resumeOption(QStringList() << "resume",
+                                    QCoreApplication::translate("main", "Resume an interrupted run, continuing the output file from its last checkpoint"));
+    parser.addOption(resumeOption);
+
     // -- NTSC decoder options --
 
     // Option to show the optical flow map (-o)
@@ -170,6 +186,17 @@ int main(int argc, char *argv[])
                                              QCoreApplication::translate("main", "NTSC: Show the optical flow map (only used for testing)"));
     parser.addOption(showOpticalFlowOption);
 
+    // Option to select the motion detector for ntsc3d
+    QCommandLineOption motionDetectorOption(QStringList() << "ntsc-motion",
+                                            QCoreApplication::translate("main", "NTSC: Motion detector for ntsc3d (farneback, farneback-half, difference; default farneback)"),
+                                            QCoreApplication::translate("main", "detector"));
+    parser.addOption(motionDetectorOption);
+
+    // Option to compare the motion detector with full-frame Farneback
+    QCommandLineOption compareMotionOption(QStringList() << "ntsc-motion-compare",
+                                           QCoreApplication::translate("main", "NTSC: Compare the speed and output of the motion detector with farneback"));
+    parser.addOption(compareMotionOption);
+
     // Option to set the white point to 75% (rather than 100%)
     QCommandLineOption whitePointOption(QStringList() << "w" << "white",
                                         QCoreApplication::translate("main", "NTSC: Use 75% white-point (default 100%)"));
@@ -201,6 +228,12 @@ int main(int argc, char *argv[])
                                                  QCoreApplication::translate("main", "file"));
     parser.addOption(transformThresholdsOption);
 
+    // Option to select the Transform PAL tile skip threshold
+    QCommandLineOption transformSkipThresholdOption(QStringList() << "transform-skip-threshold",
+                                                    QCoreApplication::translate("main", "Transform: Skip tiles with chroma amplitude below this fraction of the black-white range (default 0, never skip)"),
+                                                    QCoreApplication::translate("main", "number"));
+    parser.addOption(transformSkipThresholdOption);
+
     // Option to overlay the FFTs
     QCommandLineOption showFFTsOption(QStringList() << "show-ffts",
                                       QCoreApplication::translate("main", "Transform: Overlay the input and output FFTs"));
@@ -221,10 +254,20 @@ int main(int argc, char *argv[])
     processStandardDebugOptions(parser);
 
     // Get the arguments from the parser
+    const bool benchmarkMode = parser.isSet(benchmarkOption);
     QString inputFileName;
     QString outputFileName = "-";
     QStringList positionalArguments = parser.positionalArguments();
-    if (positionalArguments.count() == 2) {
+    if (benchmarkMode) {
+        // The benchmark generates its own input, so the only argument is the output
+        if (positionalArguments.count() == 1) {
+            outputFileName = positionalArguments.at(0);
+        } else if (positionalArguments.count() > 1) {
+            // Quit with error
+            qCritical("In benchmark mode, you may only specify the output JSON file");
+            return -1;
+        }
+    } else if (positionalArguments.count() == 2) {
         inputFileName = positionalArguments.at(0);
         outputFileName = positionalArguments.at(1);
     } else if (positionalArguments.count() == 1) {
@@ -236,16 +279,21 @@ int main(int argc, char *argv[])
     }
 
     // Check filename arguments are reasonable
-    if (inputFileName == "-" && !parser.isSet(inputJsonOption)) {
+    if (!benchmarkMode && inputFileName == "-" && !parser.isSet(inputJsonOption)) {
         // Quit with error
         qCritical("With piped input, you must also specify the input JSON file");
         return -1;
     }
-    if (inputFileName == outputFileName && outputFileName != "-") {
+    if (!benchmarkMode && inputFileName == outputFileName && outputFileName != "-") {
         // Quit with error
         qCritical("Input and output files cannot be the same");
         return -1;
     }
+    if (parser.isSet(resumeOption) && (benchmarkMode || inputFileName == "-" || outputFileName == "-")) {
+        // Quit with error
+        qCritical("Cannot resume with piped input or output, or in benchmark mode");
+        return -1;
+    }
 
     qint32 startFrame = -1;
     qint32 length = -1;
@@ -283,6 +331,13 @@ int main(int argc, char *argv[])
         }
     }
 
+    // If there are fewer frames than threads, the spare threads can work
+    // within each frame instead
+    if (length != -1 && length < maxThreads) {
+        palConfig.intraFrameThreads = maxThreads / length;
+        combConfig.intraFrameThreads = maxThreads / length;
+    }
+
     if (parser.isSet(setBwModeOption)) {
         palConfig.blackAndWhite = true;
         combConfig.blackAndWhite = true;
@@ -296,6 +351,26 @@ int main(int argc, char *argv[])
         combConfig.showOpticalFlowMap = true;
     }
 
+    if (parser.isSet(motionDetectorOption)) {
+        const QString name = parser.value(motionDetectorOption);
+
+        if (name == "farneback") {
+            combConfig.motionDetector = OpticalFlow::farnebackDetector;
+        } else if (name == "farneback-half") {
+            combConfig.motionDetector = OpticalFlow::halfFarnebackDetector;
+        } else if (name == "difference") {
+            combConfig.motionDetector = OpticalFlow::frameDifferenceDetector;
+        } else {
+            // Quit with error
+            qCritical() << "Unknown NTSC motion detector " << name;
+            return -1;
+        }
+    }
+
+    if (parser.isSet(compareMotionOption)) {
+        combConfig.compareMotionDetector = true;
+    }
+
     if (parser.isSet(transformModeOption)) {
         const QString name = parser.value(transformModeOption);
 
@@ -330,34 +405,47 @@ int main(int argc, char *argv[])
         }
     }
 
-    if (parser.isSet(showFFTsOption)) {
-        palConfig.showFFTs = true;
+    if (parser.isSet(transformSkipThresholdOption)) {
+        palConfig.transformSkipThreshold = parser.value(transformSkipThresholdOption).toDouble();
+
+        if (palConfig.transformSkipThreshold < 0.0 || palConfig.transformSkipThreshold > 1.0) {
+            // Quit with error
+            qCritical("Transform skip threshold must be between 0 and 1");
+            return -1;
+        }
     }
 
-    // Work out the metadata filename
-    QString inputJsonFileName = inputFileName + ".json";
-    if (parser.isSet(inputJsonOption)) {
-        inputJsonFileName = parser.value(inputJsonOption);
+    if (parser.isSet(showFFTsOption)) {
+        palConfig.showFFTs = true;
     }
 
-    // Load the source video metadata
+    // Load the source video metadata (unless we're benchmarking, which
+    // generates its own)
     LdDecodeMetaData metaData;
-    if (!metaData.read(inputJsonFileName)) {
-        qInfo() << "Unable to open ld-decode metadata file";
-        return -1;
-    }
+    if (!benchmarkMode) {
+        // Work out the metadata filename
+        QString inputJsonFileName = inputFileName + ".json";
+        if (parser.isSet(inputJsonOption)) {
+            inputJsonFileName = parser.value(inputJsonOption);
+        }
+
+        if (!metaData.read(inputJsonFileName)) {
+            qInfo() << "Unable to open ld-decode metadata file";
+            return -1;
+        }
 
-    // Reverse field order if required
-    if (parser.isSet(setReverseOption)) {
-        qInfo() << "Expected field order is reversed to second field/first field";
-        metaData.setIsFirstFieldFirst(false);
+        // Reverse field order if required
+        if (parser.isSet(setReverseOption)) {
+            qInfo() << "Expected field order is reversed to second field/first field";
+            metaData.setIsFirstFieldFirst(false);
+        }
     }
 
     // Work out which decoder to use
     QString decoderName;
     if (parser.isSet(decoderOption)) {
         decoderName = parser.value(decoderOption);
-    } else if (metaData.getVideoParameters().isSourcePal) {
+    } else if (benchmarkMode || metaData.getVideoParameters().isSourcePal) {
         decoderName = "pal2d";
     } else {
         decoderName = "ntsc2d";
@@ -369,42 +457,70 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // Require ntsc3d if the motion detector comparison is selected
+    if (combConfig.compareMotionDetector && decoderName != "ntsc3d") {
+        qCritical() << "Can only compare motion detectors with the ntsc3d decoder";
+        return -1;
+    }
+
     // Require transform2d/3d if the FFT overlay is selected
     if (palConfig.showFFTs && decoderName != "transform2d" && decoderName != "transform3d") {
         qCritical() << "Can only show FFTs with the transform2d/transform3d decoders";
         return -1;
     }
 
-    // Select the decoder
-    QScopedPointer<Decoder> decoder;
-    if (decoderName == "pal2d") {
-        decoder.reset(new PalDecoder(palConfig));
-    } else if (decoderName == "transform2d") {
-        palConfig.chromaFilter = PalColour::transform2DFilter;
-        if (!loadTransformThresholds(parser, transformThresholdsOption, palConfig)) {
-            return -1;
-        }
-        decoder.reset(new PalDecoder(palConfig));
-    } else if (decoderName == "transform3d") {
-        palConfig.chromaFilter = PalColour::transform3DFilter;
+    // Configure the decoder
+    if (decoderName == "transform2d" || decoderName == "transform3d") {
+        palConfig.chromaFilter = (decoderName == "transform2d") ? PalColour::transform2DFilter : PalColour::transform3DFilter;
         if (!loadTransformThresholds(parser, transformThresholdsOption, palConfig)) {
             return -1;
         }
-        decoder.reset(new PalDecoder(palConfig));
-    } else if (decoderName == "ntsc2d") {
-        decoder.reset(new NtscDecoder(combConfig));
     } else if (decoderName == "ntsc3d") {
         combConfig.use3D = true;
-        decoder.reset(new NtscDecoder(combConfig));
-    } else if (decoderName == "mono") {
-        decoder.reset(new MonoDecoder);
-    } else {
+    } else if (decoderName != "pal2d" && decoderName != "ntsc2d" && decoderName != "mono") {
         qCritical() << "Unknown decoder " << decoderName;
         return -1;
     }
 
+    // Construct a new instance of the selected decoder
+    auto makeDecoder = [&]() -> Decoder * {
+        if (decoderName == "ntsc2d" || decoderName == "ntsc3d") {
+            return new NtscDecoder(combConfig);
+        } else if (decoderName == "mono") {
+            return new MonoDecoder;
+        } else {
+            return new PalDecoder(palConfig);
+        }
+    };
+
+    if (benchmarkMode) {
+        // Benchmark the decoder on generated input
+        const bool isSourcePal = !decoderName.startsWith("ntsc");
+        Benchmark benchmark(decoderName, isSourcePal, makeDecoder, (length == -1) ? 100 : length, maxThreads);
+        if (!benchmark.run(outputFileName)) {
+            return -1;
+        }
+
+        // Quit with success
+        return 0;
+    }
+
     // Perform the processing
+    QScopedPointer<Decoder> decoder(makeDecoder());
     DecoderPool decoderPool(*decoder, inputFileName, metaData, outputFileName, startFrame, length, maxThreads);
+    if (!processStandardStatisticsOptions(parser, decoderPool.getStatistics())) {
+        return -1;
+    }
+    if (outputFileName != "-") {
+        // Only options that affect the output need to match between runs
+        const QList<QCommandLineOption> outputOptions {
+            inputJsonOption, startFrameOption, lengthOption, setReverseOption, setBwModeOption,
+            decoderOption, showOpticalFlowOption, motionDetectorOption, compareMotionOption,
+            whitePointOption, chromaGainOption, transformModeOption, transformThresholdOption,
+            transformThresholdsOption, transformSkipThresholdOption, showFFTsOption
+        };
+        decoderPool.setCheckpoint(Checkpoint::makeRunKey(parser, outputOptions), parser.isSet(resumeOption));
+    }
     if (!decoderPool.process()) {
         return -1;
     }
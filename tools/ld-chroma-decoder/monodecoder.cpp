@@ -79,6 +79,6 @@ void MonoThread::decodeFrames(const QVector<SourceField> &inputFields, qint32 st
         }
 
         // Crop the frame to just the active area
-        outputFrames[frameIndex] = MonoDecoder::cropOutputFrame(config, outputFrame);
+        MonoDecoder::cropOutputFrame(config, outputFrame, outputFrames[frameIndex]);
     }
 }
@@ -58,31 +58,57 @@ qint32 NtscDecoder::getLookBehind() const
 
 QThread *NtscDecoder::makeThread(QAtomicInt& abort, DecoderPool& decoderPool)
 {
-    return new NtscThread(abort, decoderPool, config);
+    return new NtscThread(abort, decoderPool, config, statistics);
+}
+
+void NtscDecoder::reportStatistics() const
+{
+    const OpticalFlow::Comparison &comparison = statistics.motionComparison;
+    if (!config.combConfig.compareMotionDetector || comparison.frames == 0) return;
+
+    // Show the speed and quality of the selected motion detector, relative to full-frame Farneback
+    const double detectorMsecs = comparison.detectorNsecs / (1000000.0 * comparison.frames);
+    const double referenceMsecs = comparison.referenceNsecs / (1000000.0 * comparison.frames);
+    qInfo().nospace() << "Motion detector: " << detectorMsecs << " ms/frame, Farneback reference: "
+                      << referenceMsecs << " ms/frame, mean K difference: "
+                      << comparison.kDifference / comparison.frames << " over " << comparison.frames << " frames";
 }
 
 NtscThread::NtscThread(QAtomicInt& _abort, DecoderPool &_decoderPool,
-                       const NtscDecoder::Configuration &_config, QObject *parent)
-    : DecoderThread(_abort, _decoderPool, parent), config(_config)
+                       const NtscDecoder::Configuration &_config, NtscDecoder::Statistics &_statistics,
+                       QObject *parent)
+    : DecoderThread(_abort, _decoderPool, parent), config(_config), statistics(_statistics)
 {
     // Configure NTSC decoder
     comb.updateConfiguration(config.videoParameters, config.combConfig);
 }
 
+NtscThread::~NtscThread()
+{
+    // Add this thread's motion detector comparison to the totals
+    const OpticalFlow::Comparison &comparison = comb.getMotionComparison();
+
+    QMutexLocker locker(&statistics.mutex);
+    statistics.motionComparison.frames += comparison.frames;
+    statistics.motionComparison.detectorNsecs += comparison.detectorNsecs;
+    statistics.motionComparison.referenceNsecs += comparison.referenceNsecs;
+    statistics.motionComparison.kDifference += comparison.kDifference;
+}
+
 void NtscThread::decodeFrames(const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
                               QVector<RGBFrame> &outputFrames)
 {
     // Decode lookahead fields, discarding the result
     for (qint32 i = 0; i < startIndex; i += 2) {
-        comb.decodeFrame(inputFields[i], inputFields[i + 1]);
+        comb.decodeFrame(inputFields[i], inputFields[i + 1], decodedFrame);
     }
 
     // Decode real fields to frames
     for (qint32 i = startIndex, j = 0; i < endIndex; i += 2, j++) {
         // Filter the frame
-        RGBFrame outputData = comb.decodeFrame(inputFields[i], inputFields[i + 1]);
+        comb.decodeFrame(inputFields[i], inputFields[i + 1], decodedFrame);
 
         // The NTSC filter outputs the whole frame, so here we crop it to the required dimensions
-        outputFrames[j] = NtscDecoder::cropOutputFrame(config, outputData);
+        NtscDecoder::cropOutputFrame(config, decodedFrame, outputFrames[j]);
     }
 }
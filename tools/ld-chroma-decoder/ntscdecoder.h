@@ -29,6 +29,7 @@
 
 #include <QObject>
 #include <QAtomicInt>
+#include <QMutex>
 #include <QThread>
 #include <QDebug>
 
@@ -48,14 +49,22 @@ public:
     bool configure(const LdDecodeMetaData::VideoParameters &videoParameters) override;
     qint32 getLookBehind() const override;
     QThread *makeThread(QAtomicInt& abort, DecoderPool& decoderPool) override;
+    void reportStatistics() const override;
 
     // Parameters used by NtscDecoder and NtscThread
     struct Configuration : public Decoder::Configuration {
         Comb::Configuration combConfig;
     };
 
+    // Motion detector comparison, totalled over all the threads
+    struct Statistics {
+        QMutex mutex;
+        OpticalFlow::Comparison motionComparison;
+    };
+
 private:
     Configuration config;
+    Statistics statistics;
 };
 
 class NtscThread : public DecoderThread
@@ -64,7 +73,9 @@ class NtscThread : public DecoderThread
 public:
     explicit NtscThread(QAtomicInt &abort, DecoderPool &decoderPool,
                         const NtscDecoder::Configuration &config,
+                        NtscDecoder::Statistics &statistics,
                         QObject *parent = nullptr);
+    ~NtscThread() override;
 
 protected:
     void decodeFrames(const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
@@ -74,8 +85,14 @@ private:
     // Settings
     const NtscDecoder::Configuration &config;
 
+    // Shared statistics
+    NtscDecoder::Statistics &statistics;
+
     // NTSC decoder
     Comb comb;
+
+    // Full-size decoded frame, before cropping
+    RGBFrame decodedFrame;
 };
 
 #endif // NTSCDECODER_H
@@ -25,9 +25,31 @@
 
 #include "opticalflow.h"
 
+#include <QElapsedTimer>
+
+// Size of the blocks used by the frame difference detector, in pixels
+static const qint32 DIFFERENCE_BLOCK_SIZE = 8;
+
+// Mean absolute luma difference (in 8-bit levels) below which a block is
+// treated as still, and the extra difference at which it's treated as fully moving
+static const double DIFFERENCE_NOISE_FLOOR = 2.0;
+static const double DIFFERENCE_FULL_SCALE = 8.0;
+
 OpticalFlow::OpticalFlow()
-    : framesProcessed(0)
+    : framesProcessed(0), motionDetector(farnebackDetector), compareDetector(false)
+{
+}
+
+void OpticalFlow::setMotionDetector(MotionDetector detector, bool compare)
 {
+    motionDetector = detector;
+    compareDetector = compare;
+}
+
+// Return the comparison results (if enabled by setMotionDetector)
+const OpticalFlow::Comparison &OpticalFlow::getComparison() const
+{
+    return comparison;
 }
 
 // Perform a dense optical flow analysis
@@ -36,33 +58,32 @@ void OpticalFlow::denseOpticalFlow(const YiqBuffer &yiqBuffer, QVector<qreal> &k
 {
     // Convert the buffer of Y values into an OpenCV n-dimensional dense array (cv::Mat)
     cv::Mat currentFrameGrey = convertYtoMat(yiqBuffer);
-    cv::Mat flow;
 
     kValues.resize(910 * 525);
 
     // If we have no previous image, simply copy the current to previous (and set all K values to 1 for 2D)
     if (framesProcessed > 0) {
-        // Perform the OpenCV compute dense optical flow (Gunnar Farneback’s algorithm)
-        cv::calcOpticalFlowFarneback(previousFrameGrey, currentFrameGrey, flow, 0.5, 4, 2, 3, 7, 1.5, 0);
-
-        // Apply a wide blur to the flow map to prevent the 3D filter from acting on small spots of the image;
-        // also helps a lot with sharp scene transitions and still-frame images due to the averaging effect
-        // on pixel velocity.
-        cv::GaussianBlur(flow, flow, cv::Size(21, 21), 0);
-
-        // Convert to K values
-        for (qint32 y = 0; y < 525; y++) {
-            for (qint32 x = 0; x < 910; x++) {
-                // Get the flow velocity at the current x, y point
-                const cv::Point2f flowatxy = flow.at<cv::Point2f>(y, x);
-
-                // Calculate the difference between x and y to get the relative velocity (in any direction)
-                // We multiply the x velocity by 2 in order to make the motion detection twice as sensitive
-                // in the X direction than the y
-                qreal velocity = calculateDistance(static_cast<qreal>(flowatxy.y), static_cast<qreal>(flowatxy.x) * 2);
-
-                kValues[(910 * y) + x] = qBound(0.0, velocity, 1.0);
+        QElapsedTimer timer;
+        timer.start();
+        detectMotion(motionDetector, currentFrameGrey, kValues);
+        const qint64 detectorNsecs = timer.nsecsElapsed();
+
+        if (compareDetector) {
+            // Run the reference detector as well, and compare the results
+            QVector<qreal> referenceKValues(910 * 525);
+            timer.restart();
+            detectMotion(farnebackDetector, currentFrameGrey, referenceKValues);
+            const qint64 referenceNsecs = timer.nsecsElapsed();
+
+            double kDifference = 0.0;
+            for (qint32 i = 0; i < kValues.size(); i++) {
+                kDifference += qAbs(kValues[i] - referenceKValues[i]);
             }
+
+            comparison.frames++;
+            comparison.detectorNsecs += detectorNsecs;
+            comparison.referenceNsecs += referenceNsecs;
+            comparison.kDifference += kDifference / kValues.size();
         }
     } else kValues.fill(1);
 
@@ -72,6 +93,110 @@ void OpticalFlow::denseOpticalFlow(const YiqBuffer &yiqBuffer, QVector<qreal> &k
     framesProcessed++;
 }
 
+// Compute K values for the motion between the previous frame and this one
+void OpticalFlow::detectMotion(MotionDetector detector, const cv::Mat &currentFrameGrey, QVector<qreal> &kValues)
+{
+    switch (detector) {
+    case farnebackDetector:
+        farnebackFlow(currentFrameGrey, kValues);
+        break;
+    case halfFarnebackDetector:
+        halfFarnebackFlow(currentFrameGrey, kValues);
+        break;
+    case frameDifferenceDetector:
+        frameDifference(currentFrameGrey, kValues);
+        break;
+    }
+}
+
+// Detect motion using dense optical flow on the full frame
+void OpticalFlow::farnebackFlow(const cv::Mat &currentFrameGrey, QVector<qreal> &kValues)
+{
+    cv::Mat flow;
+
+    // Perform the OpenCV compute dense optical flow (Gunnar Farneback’s algorithm)
+    cv::calcOpticalFlowFarneback(previousFrameGrey, currentFrameGrey, flow, 0.5, 4, 2, 3, 7, 1.5, 0);
+
+    // Apply a wide blur to the flow map to prevent the 3D filter from acting on small spots of the image;
+    // also helps a lot with sharp scene transitions and still-frame images due to the averaging effect
+    // on pixel velocity.
+    cv::GaussianBlur(flow, flow, cv::Size(21, 21), 0);
+
+    flowToKValues(flow, kValues);
+}
+
+// Detect motion using dense optical flow on a half-size frame.
+// This is roughly four times less work, and as the flow map is blurred
+// heavily anyway, loses little detail.
+void OpticalFlow::halfFarnebackFlow(const cv::Mat &currentFrameGrey, QVector<qreal> &kValues)
+{
+    cv::Mat previousSmall, currentSmall, flowSmall, flow;
+    const cv::Size smallSize(currentFrameGrey.cols / 2, currentFrameGrey.rows / 2);
+    cv::resize(previousFrameGrey, previousSmall, smallSize, 0, 0, cv::INTER_AREA);
+    cv::resize(currentFrameGrey, currentSmall, smallSize, 0, 0, cv::INTER_AREA);
+
+    // As above, with one fewer pyramid level and a proportionally smaller blur
+    cv::calcOpticalFlowFarneback(previousSmall, currentSmall, flowSmall, 0.5, 3, 2, 3, 5, 1.1, 0);
+    cv::GaussianBlur(flowSmall, flowSmall, cv::Size(11, 11), 0);
+
+    // Scale the flow map back up; the vectors are in half-size pixels, so double them
+    cv::resize(flowSmall, flow, currentFrameGrey.size(), 0, 0, cv::INTER_LINEAR);
+    flow *= 2.0;
+
+    flowToKValues(flow, kValues);
+}
+
+// Detect motion using the mean absolute difference between the previous and
+// current luma over small blocks. This doesn't measure speed, just whether
+// the picture has changed, but it's very cheap to compute.
+void OpticalFlow::frameDifference(const cv::Mat &currentFrameGrey, QVector<qreal> &kValues)
+{
+    // Compute the absolute difference for each pixel
+    cv::Mat difference, differenceFloat;
+    cv::absdiff(previousFrameGrey, currentFrameGrey, difference);
+    difference.convertTo(differenceFloat, CV_32F);
+
+    // Average over blocks (area resampling computes the mean of each block)
+    cv::Mat blocks;
+    const cv::Size blocksSize((currentFrameGrey.cols + DIFFERENCE_BLOCK_SIZE - 1) / DIFFERENCE_BLOCK_SIZE,
+                              (currentFrameGrey.rows + DIFFERENCE_BLOCK_SIZE - 1) / DIFFERENCE_BLOCK_SIZE);
+    cv::resize(differenceFloat, blocks, blocksSize, 0, 0, cv::INTER_AREA);
+
+    // Blur across neighbouring blocks, for the same reason as the flow map is
+    // blurred above, then convert to K values
+    cv::GaussianBlur(blocks, blocks, cv::Size(3, 3), 0);
+    blocks = (blocks - DIFFERENCE_NOISE_FLOOR) * (1.0 / DIFFERENCE_FULL_SCALE);
+
+    // Scale back up to the frame size
+    cv::Mat kMap;
+    cv::resize(blocks, kMap, currentFrameGrey.size(), 0, 0, cv::INTER_LINEAR);
+
+    for (qint32 y = 0; y < 525; y++) {
+        const float *kLine = kMap.ptr<float>(y);
+        for (qint32 x = 0; x < 910; x++) {
+            kValues[(910 * y) + x] = qBound(0.0, static_cast<qreal>(kLine[x]), 1.0);
+        }
+    }
+}
+
+// Convert a flow map to K values
+void OpticalFlow::flowToKValues(const cv::Mat &flow, QVector<qreal> &kValues)
+{
+    for (qint32 y = 0; y < 525; y++) {
+        for (qint32 x = 0; x < 910; x++) {
+            // Get the flow velocity at the current x, y point
+            const cv::Point2f flowatxy = flow.at<cv::Point2f>(y, x);
+
+            // Calculate the difference between x and y to get the relative velocity (in any direction)
+            // We multiply the x velocity by 2 in order to make the motion detection twice as sensitive
+            // in the X direction than the y
+            qreal velocity = calculateDistance(static_cast<qreal>(flowatxy.y), static_cast<qreal>(flowatxy.x) * 2);
+
+            kValues[(910 * y) + x] = qBound(0.0, velocity, 1.0);
+        }
+    }
+}
+
 // Method to convert a qreal vector frame of Y values to an OpenCV n-dimensional dense array (cv::Mat)
 cv::Mat OpticalFlow::convertYtoMat(const YiqBuffer &yiqBuffer)
 {
@@ -32,6 +32,7 @@
 
 // OpenCV3
 #include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/video/tracking.hpp>
 
 #include "yiqbuffer.h"
@@ -46,6 +47,30 @@ public:
         YIQ pixel[911]; // One line of YIQ data
     };
 
+    // Method used to detect motion between frames
+    enum MotionDetector {
+        // Dense optical flow (Farneback) on the full frame
+        farnebackDetector = 0,
+        // Dense optical flow (Farneback) on a half-size frame
+        halfFarnebackDetector,
+        // Mean absolute luma difference over small blocks
+        frameDifferenceDetector
+    };
+
+    // Speed and quality of a motion detector, compared with full-frame Farneback
+    struct Comparison {
+        qint64 frames = 0;
+        qint64 detectorNsecs = 0;
+        qint64 referenceNsecs = 0;
+        // Sum of the mean absolute K difference for each frame
+        double kDifference = 0.0;
+    };
+
+    // Select the motion detector. If compare is true, full-frame Farneback
+    // is run as well on each frame, and the results compared.
+    void setMotionDetector(MotionDetector detector, bool compare);
+    const Comparison &getComparison() const;
+
     void denseOpticalFlow(const YiqBuffer &yiqBuffer, QVector<qreal> &kValues);
 
 private:
@@ -53,6 +78,16 @@ private:
     cv::Mat previousFrameGrey;
     qint32 framesProcessed;
 
+    // Motion detector settings and comparison results
+    MotionDetector motionDetector;
+    bool compareDetector;
+    Comparison comparison;
+
+    void detectMotion(MotionDetector detector, const cv::Mat &currentFrameGrey, QVector<qreal> &kValues);
+    void farnebackFlow(const cv::Mat &currentFrameGrey, QVector<qreal> &kValues);
+    void halfFarnebackFlow(const cv::Mat &currentFrameGrey, QVector<qreal> &kValues);
+    void frameDifference(const cv::Mat &currentFrameGrey, QVector<qreal> &kValues);
+    void flowToKValues(const cv::Mat &flow, QVector<qreal> &kValues);
     cv::Mat convertYtoMat(const YiqBuffer &yiqBuffer);
     inline qreal calculateDistance(qreal yDifference, qreal xDifference);
 };
@@ -35,6 +35,7 @@
 #include "transformpal2d.h"
 #include "transformpal3d.h"
 
+#include <QtConcurrent/QtConcurrent>
 #include <cassert>
 
 /*!
@@ -105,7 +106,8 @@ const PalColour::Configuration &PalColour::getConfiguration() const {
 }
 
 void PalColour::updateConfiguration(const LdDecodeMetaData::VideoParameters &_videoParameters,
-                                    const Configuration &_configuration)
+                                    const Configuration &_configuration,
+                                    TransformPal3DCache *transformCache)
 {
     // Copy the configuration parameters
     videoParameters = _videoParameters;
@@ -119,17 +121,30 @@ void PalColour::updateConfiguration(const LdDecodeMetaData::VideoParameters &_vi
         if (configuration.chromaFilter == transform2DFilter) {
             transformPal.reset(new TransformPal2D);
         } else {
-            transformPal.reset(new TransformPal3D);
+            TransformPal3D *transformPal3D = new TransformPal3D;
+            transformPal3D->setSharedCache(transformCache);
+            transformPal.reset(transformPal3D);
         }
 
         // Configure the filter
         transformPal->updateConfiguration(videoParameters, configuration.transformMode, configuration.transformThreshold,
-                                          configuration.transformThresholds);
+                                          configuration.transformThresholds, configuration.transformSkipThreshold,
+                                          configuration.intraFrameThreads);
     }
 
     configurationSet = true;
 }
 
+qint64 PalColour::getTransformTilesProcessed() const
+{
+    return transformPal.isNull() ? 0 : transformPal->getTilesProcessed();
+}
+
+qint64 PalColour::getTransformTilesSkipped() const
+{
+    return transformPal.isNull() ? 0 : transformPal->getTilesSkipped();
+}
+
 // Rebuild the lookup tables based on the configuration
 void PalColour::buildLookUpTables()
 {
@@ -302,19 +317,33 @@ void PalColour::decodeField(const SourceField &inputField, const double *chromaD
 
     const qint32 firstLine = inputField.getFirstActiveLine(videoParameters);
     const qint32 lastLine = inputField.getLastActiveLine(videoParameters);
-    for (qint32 fieldLine = firstLine; fieldLine < lastLine; fieldLine++) {
-        LineInfo line(fieldLine);
-
-        // Detect the colourburst from the composite signal
-        detectBurst(line, compPtr);
 
-        if (configuration.chromaFilter == palColourFilter) {
-            // Decode chroma and luma from the composite signal
-            decodeLine<quint16, false>(inputField, compPtr, line, chromaGain, outputFrame);
-        } else {
-            // Decode chroma and luma from the Transform PAL output
-            decodeLine<double, true>(inputField, chromaData, line, chromaGain, outputFrame);
+    // Each line is decoded independently, so the lines can be spread across
+    // several threads: thread t does lines firstLine + t, + numThreads, ...
+    const qint32 numThreads = qMax(configuration.intraFrameThreads, 1);
+    auto decodeLines = [&](qint32 thread) {
+        for (qint32 fieldLine = firstLine + thread; fieldLine < lastLine; fieldLine += numThreads) {
+            LineInfo line(fieldLine);
+
+            // Detect the colourburst from the composite signal
+            detectBurst(line, compPtr);
+
+            if (configuration.chromaFilter == palColourFilter) {
+                // Decode chroma and luma from the composite signal
+                decodeLine<quint16, false>(inputField, compPtr, line, chromaGain, outputFrame);
+            } else {
+                // Decode chroma and luma from the Transform PAL output
+                decodeLine<double, true>(inputField, chromaData, line, chromaGain, outputFrame);
+            }
         }
+    };
+
+    if (numThreads == 1) {
+        decodeLines(0);
+    } else {
+        QVector<qint32> threads(numThreads);
+        for (qint32 i = 0; i < numThreads; i++) threads[i] = i;
+        QtConcurrent::blockingMap(threads, [&](qint32 &thread) { decodeLines(thread); });
     }
 }
 
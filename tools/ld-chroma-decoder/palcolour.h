@@ -37,6 +37,7 @@
 #include "rgbframe.h"
 #include "sourcefield.h"
 #include "transformpal.h"
+#include "transformpal3dcache.h"
 
 class PalColour : public QObject
 {
@@ -63,9 +64,12 @@ public:
         TransformPal::TransformMode transformMode = TransformPal::thresholdMode;
         double transformThreshold = 0.4;
         QVector<double> transformThresholds;
+        double transformSkipThreshold = 0.0;
         bool showFFTs = false;
         qint32 showPositionX = 200;
         qint32 showPositionY = 200;
+        // Number of threads to use within each field (for decoding single frames quickly)
+        qint32 intraFrameThreads = 1;
 
         qint32 getThresholdsSize() const;
         qint32 getLookBehind() const;
@@ -73,8 +77,13 @@ public:
     };
 
     const Configuration &getConfiguration() const;
+
+    // Update the configuration. If several PalColour instances are decoding
+    // consecutive batches of frames from the same input, they can share work
+    // between batches through transformCache (for the 3D Transform PAL filter).
     void updateConfiguration(const LdDecodeMetaData::VideoParameters &videoParameters,
-                             const Configuration &configuration);
+                             const Configuration &configuration,
+                             TransformPal3DCache *transformCache = nullptr);
 
     // Decode two fields to produce an interlaced frame.
     RGBFrame decodeFrame(const SourceField &firstField, const SourceField &secondField);
@@ -83,6 +92,10 @@ public:
     void decodeFrames(const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
                       QVector<RGBFrame> &outputFrames);
 
+    // Return the number of tiles processed, and skipped, by the Transform PAL filter
+    qint64 getTransformTilesProcessed() const;
+    qint64 getTransformTilesSkipped() const;
+
     // Maximum frame size, based on PAL
     static constexpr qint32 MAX_WIDTH = 1135;
 
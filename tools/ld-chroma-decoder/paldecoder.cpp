@@ -56,27 +56,53 @@ qint32 PalDecoder::getLookAhead() const
 }
 
 QThread *PalDecoder::makeThread(QAtomicInt& abort, DecoderPool& decoderPool) {
-    return new PalThread(abort, decoderPool, config);
+    return new PalThread(abort, decoderPool, config, statistics, transformCache);
+}
+
+void PalDecoder::threadsFinished()
+{
+    // Drop any boundary tiles that were never picked up by a neighbouring
+    // batch (at the ends of the run, or if processing was aborted)
+    transformCache.clear();
+}
+
+void PalDecoder::reportStatistics() const
+{
+    const qint64 tilesProcessed = statistics.transformTilesProcessed.load();
+    const qint64 tilesSkipped = statistics.transformTilesSkipped.load();
+    if (tilesProcessed == 0 || config.pal.transformSkipThreshold <= 0.0) return;
+
+    qInfo().nospace() << "Transform PAL skipped " << tilesSkipped << " of " << tilesProcessed << " tiles ("
+                      << (100.0 * tilesSkipped) / tilesProcessed << "%)";
 }
 
 PalThread::PalThread(QAtomicInt& _abort, DecoderPool& _decoderPool,
-                     const PalDecoder::Configuration &_config, QObject *parent)
-    : DecoderThread(_abort, _decoderPool, parent), config(_config)
+                     const PalDecoder::Configuration &_config, PalDecoder::Statistics &_statistics,
+                     TransformPal3DCache &transformCache, QObject *parent)
+    : DecoderThread(_abort, _decoderPool, parent), config(_config), statistics(_statistics)
+{
+    // Configure PALcolour, sharing Transform PAL work between the threads
+    palColour.updateConfiguration(config.videoParameters, config.pal, &transformCache);
+}
+
+PalThread::~PalThread()
 {
-    // Configure PALcolour
-    palColour.updateConfiguration(config.videoParameters, config.pal);
+    // Add this thread's tile counts to the totals
+    statistics.transformTilesProcessed.fetchAndAddRelaxed(palColour.getTransformTilesProcessed());
+    statistics.transformTilesSkipped.fetchAndAddRelaxed(palColour.getTransformTilesSkipped());
 }
 
 void PalThread::decodeFrames(const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
                              QVector<RGBFrame> &outputFrames)
 {
-    QVector<RGBFrame> decodedFrames(outputFrames.size());
+    // Reuse the full-size frames from the previous batch
+    decodedFrames.resize(outputFrames.size());
 
     // Perform the PALcolour filtering
     palColour.decodeFrames(inputFields, startIndex, endIndex, decodedFrames);
 
     for (qint32 i = 0; i < outputFrames.size(); i++) {
         // Crop the frame to just the active area
-        outputFrames[i] = PalDecoder::cropOutputFrame(config, decodedFrames[i]);
+        PalDecoder::cropOutputFrame(config, decodedFrames[i], outputFrames[i]);
     }
 }
@@ -28,6 +28,7 @@
 
 #include <QObject>
 #include <QAtomicInt>
+#include <QAtomicInteger>
 #include <QThread>
 #include <QDebug>
 
@@ -48,14 +49,24 @@ public:
     qint32 getLookBehind() const override;
     qint32 getLookAhead() const override;
     QThread *makeThread(QAtomicInt& abort, DecoderPool& decoderPool) override;
+    void threadsFinished() override;
+    void reportStatistics() const override;
 
     // Parameters used by PalDecoder and PalThread
     struct Configuration : public Decoder::Configuration {
         PalColour::Configuration pal;
     };
 
+    // Transform PAL tile counts, totalled over all the threads
+    struct Statistics {
+        QAtomicInteger<qint64> transformTilesProcessed;
+        QAtomicInteger<qint64> transformTilesSkipped;
+    };
+
 private:
     Configuration config;
+    Statistics statistics;
+    TransformPal3DCache transformCache;
 };
 
 class PalThread : public DecoderThread
@@ -64,7 +75,9 @@ class PalThread : public DecoderThread
 public:
     explicit PalThread(QAtomicInt &abort, DecoderPool &decoderPool,
                        const PalDecoder::Configuration &config,
+                       PalDecoder::Statistics &statistics, TransformPal3DCache &transformCache,
                        QObject *parent = nullptr);
+    ~PalThread() override;
 
 protected:
     void decodeFrames(const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
@@ -74,8 +87,14 @@ private:
     // Settings
     const PalDecoder::Configuration &config;
 
+    // Shared statistics
+    PalDecoder::Statistics &statistics;
+
     // PAL colour object
     PalColour palColour;
+
+    // Full-size decoded frames, before cropping
+    QVector<RGBFrame> decodedFrames;
 };
 
 #endif // PALDECODER
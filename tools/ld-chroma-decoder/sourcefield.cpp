@@ -29,7 +29,8 @@
 void SourceField::loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecodeMetaData,
                              qint32 firstFrameNumber, qint32 numFrames,
                              qint32 lookBehindFrames, qint32 lookAheadFrames,
-                             QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex)
+                             QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex,
+                             const QVector<SourceField> &previousFields)
 {
     // Work out indexes.
     // fields will contain {lookbehind fields... [startIndex] real fields... [endIndex] lookahead fields...}.
@@ -40,8 +41,18 @@ void SourceField::loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecod
     // Populate fields
     const qint32 numInputFrames = ldDecodeMetaData.getNumberOfFrames();
     qint32 frameNumber = firstFrameNumber - lookBehindFrames;
+    const qint32 previousFirstFrameNumber = previousFields.isEmpty() ? 0 : previousFields[0].frameNumber;
     for (qint32 i = 0; i < fields.size(); i += 2) {
 
+        // Has this frame already been loaded? If so, the copy shares its data
+        const qint32 previousIndex = 2 * (frameNumber - previousFirstFrameNumber);
+        if (!previousFields.isEmpty() && previousIndex >= 0 && previousIndex < previousFields.size()) {
+            fields[i] = previousFields[previousIndex];
+            fields[i + 1] = previousFields[previousIndex + 1];
+            frameNumber++;
+            continue;
+        }
+
         // Is this frame outside the bounds of the input file?
         // If so, use real metadata (from frame 1) and black fields.
         const bool useBlankFrame = frameNumber < 1 || frameNumber > numInputFrames;
@@ -65,6 +76,9 @@ void SourceField::loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecod
             fields[i + 1].data = sourceVideo.getVideoField(secondFieldNumber);
         }
 
+        fields[i].frameNumber = frameNumber;
+        fields[i + 1].frameNumber = frameNumber;
+
         frameNumber++;
     }
 }
@@ -33,14 +33,23 @@ struct SourceField {
     LdDecodeMetaData::Field field;
     SourceVideo::Data data;
 
+    // The sequential number of the frame this field belongs to (set by
+    // loadFields; this may be outside the bounds of the file)
+    qint32 frameNumber;
+
     // Load a sequence of frames from the input files.
     //
     // fields will contain {lookbehind fields... [startIndex] real fields... [endIndex] lookahead fields...}.
     // Fields requested outside the bounds of the file will have dummy metadata and black data.
+    //
+    // Frames that are also present in previousFields (usually the result of
+    // the previous call, for a batch that overlaps this one) are copied from
+    // there rather than being read again.
     static void loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecodeMetaData,
                            qint32 firstFrameNumber, qint32 numFrames,
                            qint32 lookBehindFrames, qint32 lookAheadFrames,
-                           QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex);
+                           QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex,
+                           const QVector<SourceField> &previousFields = QVector<SourceField>());
 
     // Return the vertical offset of this field within the interlaced frame
     // (i.e. 0 for the top field, 1 for the bottom field).
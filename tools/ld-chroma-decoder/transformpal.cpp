@@ -33,18 +33,52 @@
 TransformPal::TransformPal(qint32 _xComplex, qint32 _yComplex, qint32 _zComplex)
     : xComplex(_xComplex), yComplex(_yComplex), zComplex(_zComplex), configurationSet(false)
 {
+    // Allocate the first set of buffers, for the subclass to make its plans with
+    resizeTileBuffers(1);
 }
 
 TransformPal::~TransformPal()
 {
+    resizeTileBuffers(0);
+}
+
+// Allocate or free FFT buffers so there are numBuffers sets
+void TransformPal::resizeTileBuffers(qint32 numBuffers)
+{
+    // The input tile size (the real-to-complex FFT only returns half the X bins)
+    const qint32 realSize = (xComplex - 1) * 2 * yComplex * zComplex;
+    const qint32 complexSize = xComplex * yComplex * zComplex;
+
+    while (tileBuffers.size() > numBuffers) {
+        const TileBuffers &buffers = tileBuffers.last();
+        fftw_free(buffers.fftReal);
+        fftw_free(buffers.fftComplexIn);
+        fftw_free(buffers.fftComplexOut);
+        tileBuffers.removeLast();
+    }
+
+    while (tileBuffers.size() < numBuffers) {
+        tileBuffers.append(TileBuffers {fftw_alloc_real(realSize),
+                                        fftw_alloc_complex(complexSize),
+                                        fftw_alloc_complex(complexSize)});
+    }
 }
 
 void TransformPal::updateConfiguration(const LdDecodeMetaData::VideoParameters &_videoParameters,
                                        TransformPal::TransformMode _mode, double threshold,
-                                       const QVector<double> &_thresholds)
+                                       const QVector<double> &_thresholds, double skipThreshold,
+                                       qint32 tileThreads)
 {
     videoParameters = _videoParameters;
     mode = _mode;
+    resizeTileBuffers(qMax(tileThreads, 1));
+
+    // canSkipTile measures the energy of the difference between samples two
+    // apart; for a carrier of amplitude A, this averages 2 * A^2 per sample
+    const double skipAmplitude = skipThreshold * (videoParameters.white16bIre - videoParameters.black16bIre);
+    skipEnergyPerSample = 2.0 * skipAmplitude * skipAmplitude;
+    tilesProcessed.store(0);
+    tilesSkipped.store(0);
 
     // Resize thresholds to match the number of FFT bins we will consider in
     // applyFilter. The x loop there doesn't need to look at every bin.
@@ -65,6 +99,42 @@ void TransformPal::updateConfiguration(const LdDecodeMetaData::VideoParameters &
     configurationSet = true;
 }
 
+qint64 TransformPal::getTilesProcessed() const
+{
+    return tilesProcessed.load();
+}
+
+qint64 TransformPal::getTilesSkipped() const
+{
+    return tilesSkipped.load();
+}
+
+bool TransformPal::canSkipTile(const double *tileData, qint32 numRows, qint32 rowLength)
+{
+    tilesProcessed.fetchAndAddRelaxed(1);
+    if (skipEnergyPerSample <= 0.0) return false;
+
+    // Correlating with the subcarrier at 4fSC only needs the difference
+    // between samples two apart (as the sine/cosine samples are 0, 1, 0, -1).
+    // This is also a band-pass filter peaking at fSC with zeros at 0 and 2fSC,
+    // so it picks up anything the frequency-domain filter might keep.
+    const double energyLimit = skipEnergyPerSample * numRows * (rowLength - 2);
+    double energy = 0.0;
+    for (qint32 row = 0; row < numRows; row++) {
+        const double *rowData = tileData + (row * rowLength);
+        for (qint32 x = 0; x < rowLength - 2; x++) {
+            const double difference = rowData[x] - rowData[x + 2];
+            energy += difference * difference;
+        }
+
+        // Stop as soon as we know the tile must be filtered
+        if (energy >= energyLimit) return false;
+    }
+
+    tilesSkipped.fetchAndAddRelaxed(1);
+    return true;
+}
+
 void TransformPal::overlayFFT(qint32 positionX, qint32 positionY,
                               const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
                               QVector<RGBFrame> &rgbFrames)
@@ -28,7 +28,9 @@
 #ifndef TRANSFORMPAL_H
 #define TRANSFORMPAL_H
 
+#include <QAtomicInteger>
 #include <QVector>
+#include <QtConcurrent/QtConcurrent>
 #include <fftw3.h>
 
 #include "lddecodemetadata.h"
@@ -59,9 +61,17 @@ public:
     // threshold is the similarity threshold for the filter in thresholdMode.
     // Values from 0-1 are meaningful, with higher values requiring signals to
     // be more similar to be considered chroma. 0.6 is pyctools-pal's default.
+    //
+    // skipThreshold is the chroma amplitude, as a fraction of the black-white
+    // range, below which a (windowed) tile is assumed to contain no chroma,
+    // and isn't filtered at all. 0 disables skipping.
+    //
+    // tileThreads is the number of threads to split the tiles within each
+    // field across. The output doesn't depend on the number of threads.
     void updateConfiguration(const LdDecodeMetaData::VideoParameters &videoParameters,
                              TransformMode mode, double threshold,
-                             const QVector<double> &thresholds);
+                             const QVector<double> &thresholds, double skipThreshold,
+                             qint32 tileThreads = 1);
 
     // Filter input fields.
     //
@@ -80,7 +90,35 @@ public:
                     const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
                     QVector<RGBFrame> &rgbFrames);
 
+    // Return the number of tiles filtered since the filter was configured, and
+    // how many of those were skipped because they contained no chroma
+    qint64 getTilesProcessed() const;
+    qint64 getTilesSkipped() const;
+
 protected:
+    // FFT input/output buffers for one thread. These are allocated using
+    // FFTW's own functions so they're properly aligned for SIMD operations;
+    // the plans are made using the first set, and work with any of them.
+    struct TileBuffers {
+        double *fftReal;
+        fftw_complex *fftComplexIn;
+        fftw_complex *fftComplexOut;
+    };
+
+    // Call rowFunction(row, buffers) for each of numRows overlapping rows of
+    // tiles, spread across the tile threads.
+    //
+    // Adjacent rows overlap, so the even rows are done first and then the odd
+    // rows; each output sample gets its contributions in the same order
+    // however many threads there are.
+    template <typename RowFunction>
+    void forEachTileRow(qint32 numRows, RowFunction rowFunction);
+
+    // Return true if a windowed input tile has so little energy around the
+    // subcarrier frequency that it can be skipped, and update the tile counts.
+    // The tile is numRows rows of rowLength samples.
+    bool canSkipTile(const double *tileData, qint32 numRows, qint32 rowLength);
+
     // Overlay a visualisation of one field's FFT.
     // Calls back to overlayFFTArrays to draw the arrays.
     virtual void overlayFFTFrame(qint32 positionX, qint32 positionY,
@@ -95,11 +133,47 @@ protected:
     qint32 yComplex;
     qint32 zComplex;
 
+    // FFT buffers for each tile thread
+    QVector<TileBuffers> tileBuffers;
+
     // Configuration parameters
     bool configurationSet;
     LdDecodeMetaData::VideoParameters videoParameters;
     QVector<double> thresholds;
     TransformMode mode;
+    double skipEnergyPerSample;
+
+    // Tile counts
+    QAtomicInteger<qint64> tilesProcessed;
+    QAtomicInteger<qint64> tilesSkipped;
+
+private:
+    void resizeTileBuffers(qint32 numBuffers);
 };
 
+template <typename RowFunction>
+void TransformPal::forEachTileRow(qint32 numRows, RowFunction rowFunction)
+{
+    const qint32 numThreads = tileBuffers.size();
+
+    for (qint32 phase = 0; phase < 2; phase++) {
+        if (numThreads == 1) {
+            for (qint32 row = phase; row < numRows; row += 2) {
+                rowFunction(row, tileBuffers[0]);
+            }
+            continue;
+        }
+
+        // Each thread takes every numThreads'th row of this phase
+        QVector<qint32> threads(numThreads);
+        for (qint32 i = 0; i < numThreads; i++) threads[i] = i;
+
+        QtConcurrent::blockingMap(threads, [&](qint32 &thread) {
+            for (qint32 row = phase + (2 * thread); row < numRows; row += 2 * numThreads) {
+                rowFunction(row, tileBuffers[thread]);
+            }
+        });
+    }
+}
+
 #endif
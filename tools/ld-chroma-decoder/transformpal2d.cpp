@@ -72,25 +72,17 @@ TransformPal2D::TransformPal2D()
         }
     }
 
-    // Allocate buffers for FFTW. These must be allocated using FFTW's own
-    // functions so they're properly aligned for SIMD operations.
-    fftReal = fftw_alloc_real(YTILE * XTILE);
-    fftComplexIn = fftw_alloc_complex(YCOMPLEX * XCOMPLEX);
-    fftComplexOut = fftw_alloc_complex(YCOMPLEX * XCOMPLEX);
-
     // Plan FFTW operations
-    forwardPlan = fftw_plan_dft_r2c_2d(YTILE, XTILE, fftReal, fftComplexIn, FFTW_MEASURE);
-    inversePlan = fftw_plan_dft_c2r_2d(YTILE, XTILE, fftComplexOut, fftReal, FFTW_MEASURE);
+    const TileBuffers &buffers = tileBuffers[0];
+    forwardPlan = fftw_plan_dft_r2c_2d(YTILE, XTILE, buffers.fftReal, buffers.fftComplexIn, FFTW_MEASURE);
+    inversePlan = fftw_plan_dft_c2r_2d(YTILE, XTILE, buffers.fftComplexOut, buffers.fftReal, FFTW_MEASURE);
 }
 
 TransformPal2D::~TransformPal2D()
 {
-    // Free FFTW plans and buffers
+    // Free FFTW plans (TransformPal frees the buffers)
     fftw_destroy_plan(forwardPlan);
     fftw_destroy_plan(inversePlan);
-    fftw_free(fftReal);
-    fftw_free(fftComplexIn);
-    fftw_free(fftComplexOut);
 }
 
 qint32 TransformPal2D::getThresholdsSize()
@@ -140,31 +132,42 @@ void TransformPal2D::filterField(const SourceField& inputField, qint32 outputInd
 
     // Iterate through the overlapping tile positions, covering the active area.
     // (See TransformPal2D member variable documentation for how the tiling works.)
-    for (qint32 tileY = firstFieldLine - HALFYTILE; tileY < lastFieldLine; tileY += HALFYTILE) {
+    const qint32 firstTileY = firstFieldLine - HALFYTILE;
+    const qint32 numRows = (lastFieldLine - firstTileY + HALFYTILE - 1) / HALFYTILE;
+
+    forEachTileRow(numRows, [&](qint32 row, TileBuffers &buffers) {
+        const qint32 tileY = firstTileY + (row * HALFYTILE);
+
         // Work out which lines of these tiles are within the active region
         const qint32 startY = qMax(firstFieldLine - tileY, 0);
         const qint32 endY = qMin(lastFieldLine - tileY, YTILE);
 
         for (qint32 tileX = videoParameters.activeVideoStart - HALFXTILE; tileX < videoParameters.activeVideoEnd; tileX += HALFXTILE) {
-            // Compute the forward FFT
-            forwardFFTTile(tileX, tileY, startY, endY, inputField);
+            // Compute the forward FFT (skipping the tile if it has no chroma,
+            // in which case its contribution to the output would be zero)
+            if (!forwardFFTTile(tileX, tileY, startY, endY, inputField, true, buffers)) continue;
 
             // Apply the frequency-domain filter in the appropriate mode
             if (mode == levelMode) {
-                applyFilter<levelMode>();
+                applyFilter<levelMode>(buffers);
             } else {
-                applyFilter<thresholdMode>();
+                applyFilter<thresholdMode>(buffers);
             }
 
             // Compute the inverse FFT
-            inverseFFTTile(tileX, tileY, startY, endY, outputIndex);
+            inverseFFTTile(tileX, tileY, startY, endY, outputIndex, buffers);
         }
-    }
+    });
 }
 
-// Apply the forward FFT to an input tile, populating fftComplexIn
-void TransformPal2D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, const SourceField &inputField)
+// Apply the forward FFT to an input tile, populating fftComplexIn.
+// If allowSkip is true and the tile contains no chroma, return false without
+// computing the FFT.
+bool TransformPal2D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, const SourceField &inputField,
+                                    bool allowSkip, TileBuffers &buffers)
 {
+    double *fftReal = buffers.fftReal;
+
     // Copy the input signal into fftReal, applying the window function
     const quint16 *inputPtr = inputField.data.data();
     for (qint32 y = 0; y < YTILE; y++) {
@@ -183,19 +186,26 @@ void TransformPal2D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 startY, q
         }
     }
 
+    if (allowSkip && canSkipTile(fftReal, YTILE, XTILE)) return false;
+
     // Convert time domain in fftReal to frequency domain in fftComplexIn
-    fftw_execute(forwardPlan);
+    fftw_execute_dft_r2c(forwardPlan, fftReal, buffers.fftComplexIn);
+
+    return true;
 }
 
 // Apply the inverse FFT to fftComplexOut, overlaying the result into chromaBuf[outputIndex]
-void TransformPal2D::inverseFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, qint32 outputIndex)
+void TransformPal2D::inverseFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, qint32 outputIndex,
+                                    TileBuffers &buffers)
 {
+    const double *fftReal = buffers.fftReal;
+
     // Work out what X range of this tile is inside the active area
     const qint32 startX = qMax(videoParameters.activeVideoStart - tileX, 0);
     const qint32 endX = qMin(videoParameters.activeVideoEnd - tileX, XTILE);
 
     // Convert frequency domain in fftComplexOut back to time domain in fftReal
-    fftw_execute(inversePlan);
+    fftw_execute_dft_c2r(inversePlan, buffers.fftComplexOut, buffers.fftReal);
 
     // Overlay the result, normalising the FFTW output, into chromaBuf
     double *outputPtr = chromaBuf[outputIndex].data();
@@ -216,8 +226,11 @@ static inline double fftwAbsSq(const fftw_complex &value)
 // Apply the frequency-domain filter.
 // (Templated so that the inner loop gets specialised for each mode.)
 template <TransformPal::TransformMode MODE>
-void TransformPal2D::applyFilter()
+void TransformPal2D::applyFilter(TileBuffers &buffers)
 {
+    const fftw_complex *fftComplexIn = buffers.fftComplexIn;
+    fftw_complex *fftComplexOut = buffers.fftComplexOut;
+
     // Get pointer to squared threshold values
     const double *thresholdsPtr = thresholds.data();
 
@@ -334,13 +347,14 @@ void TransformPal2D::overlayFFTFrame(qint32 positionX, qint32 positionY,
     const qint32 endY = qMin(lastFieldLine - tileY, YTILE);
 
     // Compute the forward FFT
-    forwardFFTTile(positionX, tileY, startY, endY, inputField);
+    TileBuffers &buffers = tileBuffers[0];
+    forwardFFTTile(positionX, tileY, startY, endY, inputField, false, buffers);
 
     // Apply the frequency-domain filter in the appropriate mode
     if (mode == levelMode) {
-        applyFilter<levelMode>();
+        applyFilter<levelMode>(buffers);
     } else {
-        applyFilter<thresholdMode>();
+        applyFilter<thresholdMode>(buffers);
     }
 
     // Create a canvas
@@ -350,5 +364,5 @@ void TransformPal2D::overlayFFTFrame(qint32 positionX, qint32 positionY,
     canvas.drawRectangle(positionX - 1, positionY + inputField.getOffset() - 1, XTILE + 1, (YTILE * 2) + 1, FrameCanvas::green);
 
     // Draw the arrays
-    overlayFFTArrays(fftComplexIn, fftComplexOut, canvas);
+    overlayFFTArrays(buffers.fftComplexIn, buffers.fftComplexOut, canvas);
 }
@@ -48,10 +48,12 @@ public:
 
 protected:
     void filterField(const SourceField& inputField, qint32 outputIndex);
-    void forwardFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, const SourceField &inputField);
-    void inverseFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, qint32 outputIndex);
+    bool forwardFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, const SourceField &inputField,
+                        bool allowSkip, TileBuffers &buffers);
+    void inverseFFTTile(qint32 tileX, qint32 tileY, qint32 startY, qint32 endY, qint32 outputIndex,
+                        TileBuffers &buffers);
     template <TransformMode MODE>
-    void applyFilter();
+    void applyFilter(TileBuffers &buffers);
     void overlayFFTFrame(qint32 positionX, qint32 positionY,
                          const QVector<SourceField> &inputFields, qint32 fieldIndex,
                          RGBFrame &rgbFrame) override;
@@ -74,11 +76,6 @@ protected:
     // Window function applied before the FFT
     double windowFunction[YTILE][XTILE];
 
-    // FFT input/output buffers
-    double *fftReal;
-    fftw_complex *fftComplexIn;
-    fftw_complex *fftComplexOut;
-
     // FFT plans
     fftw_plan forwardPlan, inversePlan;
 
@@ -67,7 +67,7 @@ static double computeWindow(qint32 element, qint32 limit)
 }
 
 TransformPal3D::TransformPal3D()
-    : TransformPal(XCOMPLEX, YCOMPLEX, ZCOMPLEX)
+    : TransformPal(XCOMPLEX, YCOMPLEX, ZCOMPLEX), sharedCache(nullptr)
 {
     // Compute the window function.
     for (qint32 z = 0; z < ZTILE; z++) {
@@ -81,25 +81,22 @@ TransformPal3D::TransformPal3D()
         }
     }
 
-    // Allocate buffers for FFTW. These must be allocated using FFTW's own
-    // functions so they're properly aligned for SIMD operations.
-    fftReal = fftw_alloc_real(ZTILE * YTILE * XTILE);
-    fftComplexIn = fftw_alloc_complex(ZCOMPLEX * YCOMPLEX * XCOMPLEX);
-    fftComplexOut = fftw_alloc_complex(ZCOMPLEX * YCOMPLEX * XCOMPLEX);
-
     // Plan FFTW operations
-    forwardPlan = fftw_plan_dft_r2c_3d(ZTILE, YTILE, XTILE, fftReal, fftComplexIn, FFTW_MEASURE);
-    inversePlan = fftw_plan_dft_c2r_3d(ZTILE, YTILE, XTILE, fftComplexOut, fftReal, FFTW_MEASURE);
+    const TileBuffers &buffers = tileBuffers[0];
+    forwardPlan = fftw_plan_dft_r2c_3d(ZTILE, YTILE, XTILE, buffers.fftReal, buffers.fftComplexIn, FFTW_MEASURE);
+    inversePlan = fftw_plan_dft_c2r_3d(ZTILE, YTILE, XTILE, buffers.fftComplexOut, buffers.fftReal, FFTW_MEASURE);
 }
 
 TransformPal3D::~TransformPal3D()
 {
-    // Free FFTW plans and buffers
+    // Free FFTW plans (TransformPal frees the buffers)
     fftw_destroy_plan(forwardPlan);
     fftw_destroy_plan(inversePlan);
-    fftw_free(fftReal);
-    fftw_free(fftComplexIn);
-    fftw_free(fftComplexOut);
+}
+
+void TransformPal3D::setSharedCache(TransformPal3DCache *cache)
+{
+    sharedCache = cache;
 }
 
 qint32 TransformPal3D::getThresholdsSize()
@@ -153,32 +150,109 @@ void TransformPal3D::filterFields(const QVector<SourceField> &inputFields, qint3
         outputFields[i] = chromaBuf[i].data();
     }
 
+    // The first and last Z positions overlap the neighbouring batches. If the
+    // batch is a whole number of half-tiles long, the neighbours will use the
+    // same tiles, so the work can be shared with them.
+    const bool shareBoundaryTiles = sharedCache != nullptr && ((endIndex - startIndex) % HALFZTILE) == 0;
+
     // Iterate through the overlapping tile positions, covering the active area.
     // (See TransformPal3D member variable documentation for how the tiling works;
     // if you change the Z tiling here, also review getLookBehind/getLookAhead above.)
     for (qint32 tileZ = startIndex - HALFZTILE; tileZ < endIndex; tileZ += HALFZTILE) {
-        for (qint32 tileY = videoParameters.firstActiveFrameLine - HALFYTILE; tileY < videoParameters.lastActiveFrameLine; tileY += HALFYTILE) {
-            for (qint32 tileX = videoParameters.activeVideoStart - HALFXTILE; tileX < videoParameters.activeVideoEnd; tileX += HALFXTILE) {
-                // Compute the forward FFT
-                forwardFFTTile(tileX, tileY, tileZ, inputFields);
-
-                // Apply the frequency-domain filter in the appropriate mode
-                if (mode == levelMode) {
-                    applyFilter<levelMode>();
-                } else {
-                    applyFilter<thresholdMode>();
-                }
+        const bool isFirst = tileZ == startIndex - HALFZTILE;
+        const bool isLast = tileZ == endIndex - HALFZTILE;
 
-                // Compute the inverse FFT
-                inverseFFTTile(tileX, tileY, tileZ, startIndex, endIndex);
+        if (shareBoundaryTiles && (isFirst || isLast)) {
+            filterBoundaryTiles(tileZ, isFirst, inputFields, startIndex, endIndex);
+        } else {
+            filterTiles(tileZ, inputFields, startIndex, endIndex, chromaBuf);
+        }
+    }
+}
+
+// Filter all the tiles at one Z position, accumulating the results for fields
+// startIndex to endIndex into outputBuf (where outputBuf[0] is startIndex)
+void TransformPal3D::filterTiles(qint32 tileZ, const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
+                                 QVector<QVector<double>> &outputBuf)
+{
+    const qint32 firstTileY = videoParameters.firstActiveFrameLine - HALFYTILE;
+    const qint32 numRows = (videoParameters.lastActiveFrameLine - firstTileY + HALFYTILE - 1) / HALFYTILE;
+
+    forEachTileRow(numRows, [&](qint32 row, TileBuffers &buffers) {
+        const qint32 tileY = firstTileY + (row * HALFYTILE);
+
+        for (qint32 tileX = videoParameters.activeVideoStart - HALFXTILE; tileX < videoParameters.activeVideoEnd; tileX += HALFXTILE) {
+            // Compute the forward FFT (skipping the tile if it has no chroma,
+            // in which case its contribution to the output would be zero)
+            if (!forwardFFTTile(tileX, tileY, tileZ, inputFields, true, buffers)) continue;
+
+            // Apply the frequency-domain filter in the appropriate mode
+            if (mode == levelMode) {
+                applyFilter<levelMode>(buffers);
+            } else {
+                applyFilter<thresholdMode>(buffers);
             }
+
+            // Compute the inverse FFT
+            inverseFFTTile(tileX, tileY, tileZ, startIndex, endIndex, outputBuf, buffers);
+        }
+    });
+}
+
+// Filter the tiles at the first or last Z position, where half of each tile is
+// in the neighbouring batch, sharing the work with that batch via sharedCache.
+//
+// The tiles are always accumulated into a separate buffer before being added
+// to chromaBuf, so the output is the same whichever batch computes them.
+void TransformPal3D::filterBoundaryTiles(qint32 tileZ, bool isFirst, const QVector<SourceField> &inputFields,
+                                         qint32 startIndex, qint32 endIndex)
+{
+    // Our half of the tile is the second half for the first Z position, and
+    // the first half for the last Z position
+    const qint32 ourStartZ = isFirst ? HALFZTILE : 0;
+    const qint32 otherStartZ = isFirst ? 0 : HALFZTILE;
+
+    QVector<QVector<double>> ourHalf;
+    const qint32 tileFrameNumber = inputFields[tileZ].frameNumber;
+    const TransformPal3DCache::LookupResult result = sharedCache->lookup(tileFrameNumber, ourHalf);
+
+    if (result != TransformPal3DCache::found) {
+        // Compute the whole tile
+        const qint32 fieldSize = videoParameters.fieldWidth * videoParameters.fieldHeight;
+        QVector<QVector<double>> slabBuf(ZTILE);
+        for (qint32 z = 0; z < ZTILE; z++) {
+            slabBuf[z].fill(0.0, fieldSize);
+        }
+        filterTiles(tileZ, inputFields, tileZ, tileZ + ZTILE, slabBuf);
+
+        // Pass the other half on to the neighbouring batch
+        if (result == TransformPal3DCache::claimed) {
+            sharedCache->store(tileFrameNumber, slabBuf.mid(otherStartZ, HALFZTILE));
+        }
+        ourHalf = slabBuf.mid(ourStartZ, HALFZTILE);
+    }
+
+    // Add our half into chromaBuf
+    for (qint32 z = 0; z < HALFZTILE; z++) {
+        const qint32 outputIndex = tileZ + ourStartZ + z - startIndex;
+        assert(outputIndex >= 0 && outputIndex < (endIndex - startIndex));
+
+        double *outputPtr = chromaBuf[outputIndex].data();
+        const double *slabPtr = ourHalf[z].constData();
+        for (qint32 i = 0; i < chromaBuf[outputIndex].size(); i++) {
+            outputPtr[i] += slabPtr[i];
         }
     }
 }
 
-// Apply the forward FFT to an input tile, populating fftComplexIn
-void TransformPal3D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, const QVector<SourceField> &inputFields)
+// Apply the forward FFT to an input tile, populating fftComplexIn.
+// If allowSkip is true and the tile contains no chroma, return false without
+// computing the FFT.
+bool TransformPal3D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, const QVector<SourceField> &inputFields,
+                                    bool allowSkip, TileBuffers &buffers)
 {
+    double *fftReal = buffers.fftReal;
+
     // Work out which lines of this tile are within the active region
     const qint32 startY = qMax(videoParameters.firstActiveFrameLine - tileY, 0);
     const qint32 endY = qMin(videoParameters.lastActiveFrameLine - tileY, YTILE);
@@ -208,13 +282,21 @@ void TransformPal3D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, co
         }
     }
 
+    if (allowSkip && canSkipTile(fftReal, ZTILE * YTILE, XTILE)) return false;
+
     // Convert time domain in fftReal to frequency domain in fftComplexIn
-    fftw_execute(forwardPlan);
+    fftw_execute_dft_r2c(forwardPlan, fftReal, buffers.fftComplexIn);
+
+    return true;
 }
 
-// Apply the inverse FFT to fftComplexOut, overlaying the result into chromaBuf
-void TransformPal3D::inverseFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, qint32 startIndex, qint32 endIndex)
+// Apply the inverse FFT to fftComplexOut, overlaying the result into outputBuf
+// (which contains the fields from startIndex to endIndex)
+void TransformPal3D::inverseFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, qint32 startIndex, qint32 endIndex,
+                                    QVector<QVector<double>> &outputBuf, TileBuffers &buffers)
 {
+    const double *fftReal = buffers.fftReal;
+
     // Work out what portion of this tile is inside the active area
     const qint32 startX = qMax(videoParameters.activeVideoStart - tileX, 0);
     const qint32 endX = qMin(videoParameters.activeVideoEnd - tileX, XTILE);
@@ -224,12 +306,12 @@ void TransformPal3D::inverseFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, qi
     const qint32 endZ = qMin(endIndex - tileZ, ZTILE);
 
     // Convert frequency domain in fftComplexOut back to time domain in fftReal
-    fftw_execute(inversePlan);
+    fftw_execute_dft_c2r(inversePlan, buffers.fftComplexOut, buffers.fftReal);
 
-    // Overlay the result, normalising the FFTW output, into the chroma buffers
+    // Overlay the result, normalising the FFTW output, into the output buffers
     for (qint32 z = startZ; z < endZ; z++) {
         const qint32 outputIndex = tileZ + z - startIndex;
-        double *outputPtr = chromaBuf[outputIndex].data();
+        double *outputPtr = outputBuf[outputIndex].data();
 
         for (qint32 y = startY; y < endY; y++) {
             // If this frame line is not part of this field, ignore it.
@@ -255,8 +337,11 @@ static inline double fftwAbsSq(const fftw_complex &value)
 // Apply the frequency-domain filter.
 // (Templated so that the inner loop gets specialised for each mode.)
 template <TransformPal::TransformMode MODE>
-void TransformPal3D::applyFilter()
+void TransformPal3D::applyFilter(TileBuffers &buffers)
 {
+    const fftw_complex *fftComplexIn = buffers.fftComplexIn;
+    fftw_complex *fftComplexOut = buffers.fftComplexOut;
+
     // Get pointer to squared threshold values
     const double *thresholdsPtr = thresholds.data();
 
@@ -372,13 +457,14 @@ void TransformPal3D::overlayFFTFrame(qint32 positionX, qint32 positionY,
     }
 
     // Compute the forward FFT
-    forwardFFTTile(positionX, positionY, fieldIndex, inputFields);
+    TileBuffers &buffers = tileBuffers[0];
+    forwardFFTTile(positionX, positionY, fieldIndex, inputFields, false, buffers);
 
     // Apply the frequency-domain filter in the appropriate mode
     if (mode == levelMode) {
-        applyFilter<levelMode>();
+        applyFilter<levelMode>(buffers);
     } else {
-        applyFilter<thresholdMode>();
+        applyFilter<thresholdMode>(buffers);
     }
 
     // Create a canvas
@@ -388,5 +474,5 @@ void TransformPal3D::overlayFFTFrame(qint32 positionX, qint32 positionY,
     canvas.drawRectangle(positionX - 1, positionY - 1, XTILE + 1, YTILE + 1, FrameCanvas::green);
 
     // Draw the arrays
-    overlayFFTArrays(fftComplexIn, fftComplexOut, canvas);
+    overlayFFTArrays(buffers.fftComplexIn, buffers.fftComplexOut, canvas);
 }
@@ -34,6 +34,7 @@
 #include "rgbframe.h"
 #include "sourcefield.h"
 #include "transformpal.h"
+#include "transformpal3dcache.h"
 
 class TransformPal3D : public TransformPal {
 public:
@@ -51,11 +52,21 @@ public:
     void filterFields(const QVector<SourceField> &inputFields, qint32 startFieldIndex, qint32 endFieldIndex,
                       QVector<const double *> &outputFields) override;
 
+    // Share the results for tiles at the ends of each batch with other
+    // TransformPal3D instances, through the given cache (or nullptr to stop).
+    void setSharedCache(TransformPal3DCache *cache);
+
 protected:
-    void forwardFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, const QVector<SourceField> &inputFields);
-    void inverseFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, qint32 startFieldIndex, qint32 endFieldIndex);
+    void filterTiles(qint32 tileZ, const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
+                     QVector<QVector<double>> &outputBuf);
+    void filterBoundaryTiles(qint32 tileZ, bool isFirst, const QVector<SourceField> &inputFields,
+                             qint32 startIndex, qint32 endIndex);
+    bool forwardFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, const QVector<SourceField> &inputFields,
+                        bool allowSkip, TileBuffers &buffers);
+    void inverseFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, qint32 startFieldIndex, qint32 endFieldIndex,
+                        QVector<QVector<double>> &outputBuf, TileBuffers &buffers);
     template <TransformMode MODE>
-    void applyFilter();
+    void applyFilter(TileBuffers &buffers);
     void overlayFFTFrame(qint32 positionX, qint32 positionY,
                          const QVector<SourceField> &inputFields, qint32 fieldIndex,
                          RGBFrame &rgbFrame) override;
@@ -87,17 +98,15 @@ protected:
     // Window function applied before the FFT
     double windowFunction[ZTILE][YTILE][XTILE];
 
-    // FFT input/output buffers
-    double *fftReal;
-    fftw_complex *fftComplexIn;
-    fftw_complex *fftComplexOut;
-
     // FFT plans
     fftw_plan forwardPlan, inversePlan;
 
     // The combined result of all the FFT processing for each input field.
     // Inverse-FFT results are accumulated into these buffers.
     QVector<QVector<double>> chromaBuf;
+
+    // Cache shared with other instances for tiles at batch boundaries
+    TransformPal3DCache *sharedCache;
 };
 
 #endif
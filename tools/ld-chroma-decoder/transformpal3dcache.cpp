@@ -0,0 +1,68 @@
+/************************************************************************
+
+    transformpal3dcache.cpp
+
+    ld-chroma-decoder - Colourisation filter for ld-decode
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+
+#include "transformpal3dcache.h"
+
+// Look up the tile starting at tileFrameNumber, claiming it if it hasn't been
+// seen before.
+TransformPal3DCache::LookupResult TransformPal3DCache::lookup(qint32 tileFrameNumber, QVector<QVector<double>> &halfSlab)
+{
+    QMutexLocker locker(&mutex);
+
+    auto it = entries.find(tileFrameNumber);
+    if (it == entries.end()) {
+        // Nobody has looked at this tile yet
+        entries.insert(tileFrameNumber, Entry {false, {}});
+        return claimed;
+    }
+
+    // Either way, the tile is finished with once both batches have looked at it
+    const bool ready = it->ready;
+    if (ready) halfSlab = it->halfSlab;
+    entries.erase(it);
+
+    return ready ? found : busy;
+}
+
+// Store the result for the other batch's half of a tile claimed by lookup().
+// If the other batch has given up waiting for it, the result is discarded.
+void TransformPal3DCache::store(qint32 tileFrameNumber, const QVector<QVector<double>> &halfSlab)
+{
+    QMutexLocker locker(&mutex);
+
+    auto it = entries.find(tileFrameNumber);
+    if (it == entries.end()) return;
+
+    it->ready = true;
+    it->halfSlab = halfSlab;
+}
+
+// Discard all the entries, including any whose other batch never looked them up
+void TransformPal3DCache::clear()
+{
+    QMutexLocker locker(&mutex);
+
+    entries.clear();
+}
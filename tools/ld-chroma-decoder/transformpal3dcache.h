@@ -0,0 +1,74 @@
+/************************************************************************
+
+    transformpal3dcache.h
+
+    ld-chroma-decoder - Colourisation filter for ld-decode
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+
+#ifndef TRANSFORMPAL3DCACHE_H
+#define TRANSFORMPAL3DCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+// Results of the 3D Transform PAL filter for tiles that straddle the boundary
+// between two batches of frames, shared between the worker threads.
+//
+// Each tile spans ZTILE fields, and the tiles at the ends of a batch overlap
+// the neighbouring batch by half a tile. Rather than both batches computing
+// the same tile, the first batch to reach it claims it, computes it, and
+// leaves the half of the result that falls in the other batch here.
+//
+// Tiles are identified by the sequential number of the frame they start at.
+class TransformPal3DCache
+{
+public:
+    TransformPal3DCache() = default;
+
+    // Result of looking up a tile
+    enum LookupResult {
+        // The other batch has already computed the tile; halfSlab has been
+        // filled in with its result for the caller's half of the tile
+        found = 0,
+        // The tile hasn't been claimed; the caller should compute it, and
+        // store the other half of the result using store()
+        claimed,
+        // The other batch is computing the tile right now; the caller should
+        // compute it too, and not store the result
+        busy
+    };
+
+    LookupResult lookup(qint32 tileFrameNumber, QVector<QVector<double>> &halfSlab);
+    void store(qint32 tileFrameNumber, const QVector<QVector<double>> &halfSlab);
+    void clear();
+
+private:
+    struct Entry {
+        bool ready;
+        QVector<QVector<double>> halfSlab;
+    };
+
+    QMutex mutex;
+    QHash<qint32, Entry> entries;
+};
+
+#endif
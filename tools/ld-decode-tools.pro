@@ -11,6 +11,7 @@ SUBDIRS = \
     ld-export-metadata \
     ld-lds-converter \
     ld-process-efm \
+    ld-process-efm/batch \
     ld-process-vbi \
     library/filter/testfilter \
     library/tbc/testvbidecoder
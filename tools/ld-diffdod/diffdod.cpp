@@ -25,8 +25,11 @@
 #include "diffdod.h"
 #include "sources.h"
 
+#include <algorithm>
+
 DiffDod::DiffDod(QAtomicInt& abort, Sources& sources, QObject *parent)
-    : QThread(parent), m_abort(abort), m_sources(sources)
+    : QThread(parent), m_abort(abort), m_sources(sources), m_sortNetworkSize(-1),
+      m_lutBlack16bIre(0), m_lutWhite16bIre(0), m_lutIsSourcePal(false)
 {
 
 }
@@ -43,6 +46,13 @@ void DiffDod::run()
     qint32 dodThreshold;
     bool signalClip;
 
+    // Input variables for the combined dropout correction mode
+    QVector<qint32> firstFieldNumbers;
+    QVector<qint32> secondFieldNumbers;
+    QVector<LdDecodeMetaData::Field> firstFieldMetadata;
+    QVector<LdDecodeMetaData::Field> secondFieldMetadata;
+    bool correctFrame, intraField, overCorrect;
+
     // Set up the output variables
     QVector<LdDecodeMetaData::DropOuts> firstFieldDropouts;
     QVector<LdDecodeMetaData::DropOuts> secondFieldDropouts;
@@ -51,7 +61,9 @@ void DiffDod::run()
     while(!m_abort) {
         // Get the next frame to process ------------------------------------------------------------------------------
         if (!m_sources.getInputFrame(targetVbiFrame, firstFields, secondFields, videoParameters,
-                                     availableSourcesForFrame, dodThreshold, signalClip)) {
+                                     availableSourcesForFrame, dodThreshold, signalClip,
+                                     firstFieldNumbers, secondFieldNumbers, firstFieldMetadata, secondFieldMetadata,
+                                     correctFrame, intraField, overCorrect)) {
             // No more input fields --> exit
             break;
         }
@@ -79,6 +91,16 @@ void DiffDod::run()
             performClipCheck(secondFields, secondFieldDiff, videoParameters, availableSourcesForFrame);
         }
 
+        // Keep the unfiltered fields for dropout correction (these share the
+        // data until the filter writes to the fields, so nothing is copied
+        // unless the correction is being done)
+        QVector<SourceVideo::Data> unfilteredFirstFields;
+        QVector<SourceVideo::Data> unfilteredSecondFields;
+        if (correctFrame) {
+            unfilteredFirstFields = firstFields;
+            unfilteredSecondFields = secondFields;
+        }
+
         // Filter the frame to leave just the luma information
         performLumaFilter(firstFields, videoParameters, availableSourcesForFrame);
         performLumaFilter(secondFields, videoParameters, availableSourcesForFrame);
@@ -96,6 +118,33 @@ void DiffDod::run()
         concatenateFieldDropouts(firstFieldDropouts, availableSourcesForFrame);
         concatenateFieldDropouts(secondFieldDropouts, availableSourcesForFrame);
 
+        // Correct the first source's frame using the new dropouts (combined mode) ------------------------------------
+        if (correctFrame) {
+            DropOutCorrect::Statistics statistics = {0, 0, 0};
+
+            // If the first source's frame is padded, it isn't available for
+            // correction; its original fields (which getInputFrame always reads
+            // in the combined mode) are written unchanged, as ld-dropout-correct
+            // does, so the output still matches the metadata
+            if (availableSourcesForFrame.contains(0)) {
+                // Use the new dropouts (if it was possible to create them, otherwise the existing ones are used)
+                if (availableSourcesForFrame.size() >= 3) {
+                    for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
+                        qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
+                        firstFieldMetadata[sourceNo].dropOuts = firstFieldDropouts[sourceNo];
+                        secondFieldMetadata[sourceNo].dropOuts = secondFieldDropouts[sourceNo];
+                    }
+                }
+
+                m_dropOutCorrect.correctFrame(unfilteredFirstFields, unfilteredSecondFields, firstFieldNumbers, secondFieldNumbers,
+                                              firstFieldMetadata, secondFieldMetadata, videoParameters, intraField, overCorrect,
+                                              availableSourcesForFrame, statistics);
+            }
+
+            m_sources.setCorrectedFrame(targetVbiFrame, unfilteredFirstFields[0], unfilteredSecondFields[0],
+                                        firstFieldNumbers[0], secondFieldNumbers[0], statistics);
+        }
+
         // Return the processed frame ---------------------------------------------------------------------------------
         m_sources.setOutputFrame(targetVbiFrame, firstFieldDropouts, secondFieldDropouts, availableSourcesForFrame);
     }
@@ -195,36 +244,67 @@ void DiffDod::getFieldErrorByMedian(QVector<SourceVideo::Data> &fields, QVector<
     // Calculate the linear threshold for the colourburst region
     qint32 cbThreshold = ((65535 / 100) * dodThreshold) / 4; // Note: The /4 is just a guess
 
+    // Prepare the sorting network and brightness look-up table
+    const qint32 numberOfSources = fields.size();
+    buildSortNetwork(numberOfSources);
+    buildBrightnessLut(videoParameters);
+    const float *brightness = m_brightnessLut.constData();
+
+    // The dot values for a line are held source-major (one row of lineWidth
+    // values per source), so each comparator of the sorting network runs
+    // across the whole line at once. Sources that are not available for the
+    // frame contribute zeros to the median.
+    const qint32 lineStart = videoParameters.colourBurstStart;
+    const qint32 lineWidth = videoParameters.activeVideoEnd - lineStart;
+    if (lineWidth <= 0) return;
+    m_lineValues.resize(numberOfSources * lineWidth);
+    quint16 *lineValues = m_lineValues.data();
+
+    // The row that holds the median after sorting
+    const quint16 *medianValues = lineValues + ((numberOfSources / 2) * lineWidth);
+
+    // The visible (Rec.709 logarithmic comparison) and colour burst (linear comparison) areas of the line
+    const qint32 visibleStart = qMax(videoParameters.activeVideoStart, lineStart) - lineStart;
+    const qint32 visibleEnd = lineWidth;
+    const qint32 burstEnd = qMin(videoParameters.colourBurstEnd, videoParameters.activeVideoEnd) - lineStart;
+
     for (qint32 y = 0; y < videoParameters.fieldHeight; y++) {
-        qint32 startOfLinePointer = y * videoParameters.fieldWidth;
-        for (qint32 x = videoParameters.colourBurstStart; x < videoParameters.activeVideoEnd; x++) {
-            // Get the dot value from all of the sources
-            QVector<qint32> dotValues(fields.size());
-            for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
-                qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
-                dotValues[sourceNo] = static_cast<qint32>(fields[sourceNo][x + startOfLinePointer]);
+        qint32 startOfLinePointer = (y * videoParameters.fieldWidth) + lineStart;
+
+        // Get the dot values from all of the sources
+        std::fill(lineValues, lineValues + (numberOfSources * lineWidth), 0);
+        for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
+            qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
+            const quint16 *sourceLine = fields[sourceNo].constData() + startOfLinePointer;
+            std::copy(sourceLine, sourceLine + lineWidth, lineValues + (sourceNo * lineWidth));
+        }
+
+        // Sort the values at each x position
+        for (qint32 i = 0; i < m_sortNetwork.size(); i += 2) {
+            quint16 *lower = lineValues + (m_sortNetwork[i] * lineWidth);
+            quint16 *upper = lineValues + (m_sortNetwork[i + 1] * lineWidth);
+            for (qint32 x = 0; x < lineWidth; x++) {
+                const quint16 a = lower[x];
+                const quint16 b = upper[x];
+                lower[x] = qMin(a, b);
+                upper[x] = qMax(a, b);
             }
+        }
+
+        // Compare each source to the median
+        for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
+            qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
+            const quint16 *sourceLine = fields[sourceNo].constData() + startOfLinePointer;
+            char *diffLine = fieldDiff[sourceNo].data() + startOfLinePointer;
 
             // If we are in the visible area use Rec.709 logarithmic comparison
-            if (x >= videoParameters.activeVideoStart && x < videoParameters.activeVideoEnd) {
-                // Compute the median of the dot values
-                float vMedian = static_cast<float>(convertLinearToBrightness(median(dotValues), videoParameters.black16bIre, videoParameters.white16bIre, videoParameters.isSourcePal));
-
-                for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
-                    qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
-                    float v = convertLinearToBrightness(dotValues[sourceNo], videoParameters.black16bIre, videoParameters.white16bIre, videoParameters.isSourcePal);
-                    if ((v - vMedian) > threshold) fieldDiff[sourceNo][x + startOfLinePointer] = 2;
-                }
+            for (qint32 x = visibleStart; x < visibleEnd; x++) {
+                if ((brightness[sourceLine[x]] - brightness[medianValues[x]]) > threshold) diffLine[x] = 2;
             }
 
             // If we are in the colourburst use linear comparison
-            if (x >= videoParameters.colourBurstStart && x < videoParameters.colourBurstEnd) {
-                // We are in the colour burst, use linear comparison
-                qint32 dotMedian = median(dotValues);
-                for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
-                    qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
-                    if ((dotValues[sourceNo] - dotMedian) > cbThreshold) fieldDiff[sourceNo][x + startOfLinePointer] = 2;
-                }
+            for (qint32 x = 0; x < burstEnd; x++) {
+                if ((static_cast<qint32>(sourceLine[x]) - static_cast<qint32>(medianValues[x])) > cbThreshold) diffLine[x] = 2;
             }
         }
     }
@@ -342,12 +422,47 @@ void DiffDod::concatenateFieldDropouts(QVector<LdDecodeMetaData::DropOuts> &drop
     }
 }
 
-// Method to find the median of a vector of qint32s
-qint32 DiffDod::median(QVector<qint32> v)
+// Build a sorting network for the specified number of values (Batcher's odd-even
+// merge sort, which works for any size), as a list of pairs of row indexes to
+// compare and exchange
+void DiffDod::buildSortNetwork(qint32 size)
 {
-    size_t n = v.size() / 2;
-    std::nth_element(v.begin(), v.begin()+n, v.end());
-    return v[n];
+    if (size == m_sortNetworkSize) return;
+
+    m_sortNetwork.clear();
+    for (qint32 p = 1; p < size; p <<= 1) {
+        for (qint32 k = p; k >= 1; k >>= 1) {
+            for (qint32 j = k % p; j <= size - 1 - k; j += 2 * k) {
+                for (qint32 i = 0; i <= qMin(k - 1, size - j - k - 1); i++) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        m_sortNetwork.append(i + j);
+                        m_sortNetwork.append(i + j + k);
+                    }
+                }
+            }
+        }
+    }
+
+    m_sortNetworkSize = size;
+}
+
+// Fill the brightness look-up table for the video parameters (if they have changed)
+void DiffDod::buildBrightnessLut(const LdDecodeMetaData::VideoParameters &videoParameters)
+{
+    if (!m_brightnessLut.isEmpty() && m_lutBlack16bIre == videoParameters.black16bIre &&
+            m_lutWhite16bIre == videoParameters.white16bIre && m_lutIsSourcePal == videoParameters.isSourcePal) {
+        return;
+    }
+
+    m_brightnessLut.resize(65536);
+    for (qint32 value = 0; value < 65536; value++) {
+        m_brightnessLut[value] = convertLinearToBrightness(static_cast<quint16>(value), videoParameters.black16bIre,
+                                                           videoParameters.white16bIre, videoParameters.isSourcePal);
+    }
+
+    m_lutBlack16bIre = videoParameters.black16bIre;
+    m_lutWhite16bIre = videoParameters.white16bIre;
+    m_lutIsSourcePal = videoParameters.isSourcePal;
 }
 
 // Method to convert a linear IRE to a logarithmic reflective brightness %
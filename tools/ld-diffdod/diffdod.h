@@ -38,6 +38,9 @@
 #include "vbidecoder.h"
 #include "filters.h"
 
+// ld-dropout-correct includes
+#include "dropoutcorrect.h"
+
 class Sources;
 
 class DiffDod : public QThread
@@ -54,6 +57,20 @@ private:
     QAtomicInt& m_abort;
     Sources& m_sources;
 
+    // Dropout corrector for the combined mode
+    DropOutCorrect m_dropOutCorrect;
+
+    // Median workspace, reused between fields so the median kernel doesn't allocate
+    qint32 m_sortNetworkSize;
+    QVector<qint32> m_sortNetwork;
+    QVector<quint16> m_lineValues;
+
+    // Look-up table of convertLinearToBrightness for every 16-bit sample value
+    QVector<float> m_brightnessLut;
+    qint32 m_lutBlack16bIre;
+    qint32 m_lutWhite16bIre;
+    bool m_lutIsSourcePal;
+
     // Processing methods
     void performClipCheck(QVector<SourceVideo::Data> &fields, QVector<QByteArray> &fieldDiff,
                                    LdDecodeMetaData::VideoParameters videoParameters,
@@ -70,7 +87,8 @@ private:
 
     void concatenateFieldDropouts(QVector<LdDecodeMetaData::DropOuts> &dropouts, QVector<qint32> availableSourcesForFrame);
 
-    qint32 median(QVector<qint32> v);
+    void buildSortNetwork(qint32 size);
+    void buildBrightnessLut(const LdDecodeMetaData::VideoParameters &videoParameters);
     float convertLinearToBrightness(quint16 value, quint16 black16bIre, quint16 white16bIre, bool isSourcePal);
 };
 
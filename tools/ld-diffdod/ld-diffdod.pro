@@ -1,4 +1,5 @@
 QT -= gui
+QT += concurrent
 
 CONFIG += c++11 console
 CONFIG -= app_bundle
@@ -18,8 +19,11 @@ SOURCES += \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/sourcevideo.cpp \
     ../library/tbc/vbidecoder.cpp \
+    ../library/tbc/sidecarcache.cpp \
+    ../library/tbc/vbiframeindex.cpp \
     ../library/tbc/filters.cpp \
     ../library/tbc/logging.cpp \
+    ../ld-dropout-correct/dropoutcorrect.cpp \
     diffdod.cpp \
     main.cpp \
     sources.cpp
@@ -29,14 +33,18 @@ HEADERS += \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/sourcevideo.h \
     ../library/tbc/vbidecoder.h \
+    ../library/tbc/sidecarcache.h \
+    ../library/tbc/vbiframeindex.h \
     ../library/tbc/filters.h \
     ../library/tbc/logging.h \
+    ../ld-dropout-correct/dropoutcorrect.h \
     diffdod.h \
     sources.h
 
 # Add external includes to the include path
 INCLUDEPATH += ../library/filter
 INCLUDEPATH += ../library/tbc
+INCLUDEPATH += ../ld-dropout-correct
 
 # Include git information definitions
 isEmpty(BRANCH) {
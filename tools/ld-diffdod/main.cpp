@@ -84,6 +84,23 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number"));
     parser.addOption(lengthVbiOption);
 
+    // Option to also correct the dropouts in the first source (-c / --correct)
+    QCommandLineOption correctOption(QStringList() << "c" << "correct",
+                                        QCoreApplication::translate(
+                                         "main", "Also correct the dropouts in the first input file, writing the corrected TBC to the specified file"),
+                                        QCoreApplication::translate("main", "filename"));
+    parser.addOption(correctOption);
+
+    // Option to select over correct mode for --correct (-o / --overcorrect)
+    QCommandLineOption setOverCorrectOption(QStringList() << "o" << "overcorrect",
+                                       QCoreApplication::translate("main", "With --correct, use over correct mode (use on heavily damaged sources)"));
+    parser.addOption(setOverCorrectOption);
+
+    // Option to force intrafield correction for --correct (-i / --intra)
+    QCommandLineOption setIntrafieldOption(QStringList() << "i" << "intra",
+                                       QCoreApplication::translate("main", "With --correct, force intrafield correction (default interfield)"));
+    parser.addOption(setIntrafieldOption);
+
     // Option to select the number of threads (-t)
     QCommandLineOption threadsOption(QStringList() << "t" << "threads",
                                         QCoreApplication::translate(
@@ -168,9 +185,22 @@ int main(int argc, char *argv[])
         }
     }
 
+    QString correctedFilename;
+    if (parser.isSet(correctOption)) {
+        correctedFilename = parser.value(correctOption);
+
+        if (inputFilenames.contains(correctedFilename)) {
+            // Quit with error
+            qCritical("The corrected output file must not be one of the input files");
+            return -1;
+        }
+    }
+    bool overCorrect = parser.isSet(setOverCorrectOption);
+    bool intraField = parser.isSet(setIntrafieldOption);
+
     // Process the TBC file
     Sources sources(inputFilenames, reverse, dodThreshold, signalClip,
-                    vbiFrameStart, vbiFrameLength, maxThreads);
+                    vbiFrameStart, vbiFrameLength, correctedFilename, intraField, overCorrect, maxThreads);
     if (!sources.process()) {
         return 1;
     }
@@ -24,13 +24,17 @@
 
 #include "sources.h"
 
+#include <QtConcurrent/QtConcurrent>
+
 Sources::Sources(QVector<QString> inputFilenames, bool reverse,
                  qint32 dodThreshold, bool signalClip,
                  qint32 startVbi, qint32 lengthVbi,
+                 QString correctedFilename, bool intraField, bool overCorrect,
                  qint32 maxThreads, QObject *parent)
     : QObject(parent), m_inputFilenames(inputFilenames), m_reverse(reverse),
       m_dodThreshold(dodThreshold), m_signalClip(signalClip), m_startVbi(startVbi),
-      m_lengthVbi(lengthVbi), m_maxThreads(maxThreads)
+      m_lengthVbi(lengthVbi), m_maxThreads(maxThreads), m_correctedFilename(correctedFilename),
+      m_intraField(intraField), m_overCorrect(overCorrect)
 {
     // Used to track the sources as they are loaded
     currentSource = 0;
@@ -47,6 +51,7 @@ bool Sources::process()
     if (m_reverse) qInfo() << "Using reverse field order"; else qInfo() << "Using normal field order";
     qInfo().nospace() << "Dropout detection threshold is " << m_dodThreshold << "% difference";
     if (m_signalClip) qInfo() << "Performing signal clip detection"; else qInfo() << "Not performing signal clip detection";
+    if (!m_correctedFilename.isEmpty()) qInfo() << "Correcting the dropouts in source #0 to" << m_correctedFilename;
     qInfo() << "";
 
     // Load the input TBC files ---------------------------------------------------------------------------------------
@@ -80,6 +85,12 @@ bool Sources::process()
     lastFrameNumber = vbiStartFrame + length;
     processedFrames = 0;
 
+    // Open the corrected output for the combined mode
+    if (!m_correctedFilename.isEmpty() && !openCorrectedOutput(inputFrameNumber, lastFrameNumber)) {
+        unloadInputTbcFiles();
+        return false;
+    }
+
     qInfo() << "";
     qInfo() << "Beginning multi-threaded diffDOD processing...";
     qInfo() << "Processing" << length << "frames - from VBI frame" << inputFrameNumber << "to" << lastFrameNumber;
@@ -103,6 +114,7 @@ bool Sources::process()
     // Did any of the threads abort?
     if (abort) {
         qCritical() << "Threads aborted!  Cleaning up...";
+        if (correctedVideo.isOpen()) correctedVideo.remove();
         unloadInputTbcFiles();
         return false;
     }
@@ -112,11 +124,28 @@ bool Sources::process()
     qInfo().nospace() << "DiffDOD complete - " << length << " frames in " << totalSecs << " seconds (" <<
                length / totalSecs << " FPS)";
 
+    // Check the corrected output is complete, as it must match source #0's metadata
+    if (correctedVideo.isOpen() && correctedFrameNumber <= sourceVideos[0]->ldDecodeMetaData.getNumberOfFrames()) {
+        qCritical() << "Only" << correctedFrameNumber - 1 << "of" << sourceVideos[0]->ldDecodeMetaData.getNumberOfFrames() <<
+                       "frames of source #0 were written to the corrected output - cannot continue!";
+        correctedVideo.remove();
+        unloadInputTbcFiles();
+        return false;
+    }
+
     // Save the sources -----------------------------------------------------------------------------------------------
     qInfo() << "";
     qInfo() << "Saving sources...";
     saveSources();
 
+    // Finish the corrected output
+    if (correctedVideo.isOpen()) {
+        correctedVideo.close();
+
+        qInfo() << "Writing JSON metadata file for the corrected TBC file";
+        sourceVideos[0]->ldDecodeMetaData.write(m_correctedFilename + ".json");
+    }
+
     // Unload the input sources
     qInfo() << "";
     qInfo() << "Cleaning up...";
@@ -130,35 +159,77 @@ bool Sources::getInputFrame(qint32& targetVbiFrame,
                             QVector<SourceVideo::Data>& firstFields, QVector<SourceVideo::Data>& secondFields,
                             LdDecodeMetaData::VideoParameters& videoParameters,
                             QVector<qint32>& availableSourcesForFrame,
-                            qint32& dodThreshold, bool& signalClip)
+                            qint32& dodThreshold, bool& signalClip,
+                            QVector<qint32>& firstFieldNumbers, QVector<qint32>& secondFieldNumbers,
+                            QVector<LdDecodeMetaData::Field>& firstFieldMetadata,
+                            QVector<LdDecodeMetaData::Field>& secondFieldMetadata,
+                            bool& correctFrame, bool& intraField, bool& overCorrect)
 {
-    QMutexLocker locker(&inputMutex);
+    {
+        QMutexLocker locker(&inputMutex);
 
-    if (inputFrameNumber > lastFrameNumber) {
-        // No more input frames
-        return false;
-    }
-
-    targetVbiFrame = inputFrameNumber;
-    inputFrameNumber++;
-    processedFrames++;
+        if (inputFrameNumber > lastFrameNumber) {
+            // No more input frames
+            return false;
+        }
 
-    // Get the metadata for the video parameters (all sources are the same, so just grab from the first)
-    videoParameters = sourceVideos[0]->ldDecodeMetaData.getVideoParameters();
+        targetVbiFrame = inputFrameNumber;
+        inputFrameNumber++;
+        processedFrames++;
+
+        // Get the metadata for the video parameters (all sources are the same, so just grab from the first)
+        videoParameters = sourceVideos[0]->ldDecodeMetaData.getVideoParameters();
+
+        // Get the number of available sources for the current frame
+        availableSourcesForFrame = getAvailableSourcesForFrame(targetVbiFrame);
+        qDebug() << "Processing VBI Frame" << targetVbiFrame << "-" << availableSourcesForFrame.size() << "sources available";
+
+        // Get the field numbers for the current frame (from all available sources)
+        firstFieldNumbers.fill(-1, getNumberOfAvailableSources());
+        secondFieldNumbers.fill(-1, getNumberOfAvailableSources());
+        for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
+            qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
+            qint32 sequentialFrameNumber = convertVbiFrameNumberToSequential(targetVbiFrame, sourceNo);
+            firstFieldNumbers[sourceNo] = sourceVideos[sourceNo]->ldDecodeMetaData.getFirstFieldNumber(sequentialFrameNumber);
+            secondFieldNumbers[sourceNo] = sourceVideos[sourceNo]->ldDecodeMetaData.getSecondFieldNumber(sequentialFrameNumber);
+        }
 
-    // Get the number of available sources for the current frame
-    availableSourcesForFrame = getAvailableSourcesForFrame(targetVbiFrame);
+        // In the combined mode, every frame of the first source is corrected and
+        // written out (even if it's padded, and so not available for diffDOD -
+        // its fields are still read here, so they can be written unchanged)
+        correctFrame = correctedVideo.isOpen() && convertVbiFrameNumberToSequential(targetVbiFrame, 0) != -1;
+
+        firstFieldMetadata.clear();
+        secondFieldMetadata.clear();
+        if (correctFrame) {
+            qint32 sequentialFrameNumber = convertVbiFrameNumberToSequential(targetVbiFrame, 0);
+            firstFieldNumbers[0] = sourceVideos[0]->ldDecodeMetaData.getFirstFieldNumber(sequentialFrameNumber);
+            secondFieldNumbers[0] = sourceVideos[0]->ldDecodeMetaData.getSecondFieldNumber(sequentialFrameNumber);
+
+            // Get the existing field metadata for the corrector
+            firstFieldMetadata.resize(getNumberOfAvailableSources());
+            secondFieldMetadata.resize(getNumberOfAvailableSources());
+            for (qint32 sourceNo = 0; sourceNo < getNumberOfAvailableSources(); sourceNo++) {
+                if (firstFieldNumbers[sourceNo] == -1) continue;
+                firstFieldMetadata[sourceNo] = sourceVideos[sourceNo]->ldDecodeMetaData.getField(firstFieldNumbers[sourceNo]);
+                secondFieldMetadata[sourceNo] = sourceVideos[sourceNo]->ldDecodeMetaData.getField(secondFieldNumbers[sourceNo]);
+            }
+        }
 
-    // Get the field data for the current frame (from all available sources)
-    firstFields = getFieldData(targetVbiFrame, true, availableSourcesForFrame);
-    secondFields = getFieldData(targetVbiFrame, false, availableSourcesForFrame);
+        // Set the other miscellaneous parameters
+        dodThreshold = m_dodThreshold;
+        signalClip = m_signalClip;
+        intraField = m_intraField;
+        overCorrect = m_overCorrect;
 
-    // Set the other miscellaneous parameters
-    dodThreshold = m_dodThreshold;
-    signalClip = m_signalClip;
+        // User feedback
+        if (processedFrames % 100 == 0) qInfo() << "Processing frame" << targetVbiFrame;
+    }
 
-    // User feedback
-    if (processedFrames % 100 == 0) qInfo() << "Processing frame" << targetVbiFrame;
+    // Get the field data for the current frame. The reads are done by each
+    // source's own I/O thread, so the input mutex isn't needed (and other
+    // workers can fetch their frames at the same time)
+    getFieldData(firstFieldNumbers, secondFieldNumbers, firstFields, secondFields);
 
     return true;
 }
@@ -206,16 +277,204 @@ bool Sources::setOutputFrame(qint32 targetVbiFrame,
     return true;
 }
 
+// Receive a corrected frame of the first source from the threaded processing (combined mode).
+//
+// The frames are completed in an arbitrary order, so they're kept until all
+// the frames before them have been written.
+//
+// Returns true on success, false on failure.
+bool Sources::setCorrectedFrame(qint32 targetVbiFrame,
+                                const SourceVideo::Data &firstFieldData, const SourceVideo::Data &secondFieldData,
+                                qint32 firstFieldNumber, qint32 secondFieldNumber,
+                                const DropOutCorrect::Statistics &statistics)
+{
+    QMutexLocker locker(&outputMutex);
+
+    // Every frame must have both of its fields, or the output would no longer
+    // line up with the first source's metadata
+    if (firstFieldNumber == -1 || secondFieldNumber == -1) {
+        qCritical() << "Corrected frame for VBI frame" << targetVbiFrame << "is missing its field numbers";
+        abort = true;
+        return false;
+    }
+
+    // A frame that's already been written, or is already waiting, can't be
+    // written again without the output going out of step
+    const qint32 sequentialFrame = convertVbiFrameNumberToSequential(targetVbiFrame, 0);
+    if (sequentialFrame < correctedFrameNumber || pendingCorrectedFrames.contains(sequentialFrame)) {
+        qCritical() << "Corrected frame for VBI frame" << targetVbiFrame << "maps to frame" << sequentialFrame <<
+                       "of source #0, which has already been corrected";
+        abort = true;
+        return false;
+    }
+
+    CorrectedFrame pendingFrame;
+    pendingFrame.firstFieldData = firstFieldData;
+    pendingFrame.secondFieldData = secondFieldData;
+    pendingFrame.firstFieldNumber = firstFieldNumber;
+    pendingFrame.secondFieldNumber = secondFieldNumber;
+    pendingFrame.statistics = statistics;
+    pendingCorrectedFrames[sequentialFrame] = pendingFrame;
+
+    // Write out as many frames as possible
+    while (pendingCorrectedFrames.contains(correctedFrameNumber)) {
+        const CorrectedFrame &outputFrame = pendingCorrectedFrames.value(correctedFrameNumber);
+
+        // Save the frame data to the output file (with the fields in the correct order)
+        bool writeFail = false;
+        if (outputFrame.firstFieldNumber < outputFrame.secondFieldNumber) {
+            if (!writeCorrectedField(outputFrame.firstFieldData)) writeFail = true;
+            if (!writeCorrectedField(outputFrame.secondFieldData)) writeFail = true;
+        } else {
+            if (!writeCorrectedField(outputFrame.secondFieldData)) writeFail = true;
+            if (!writeCorrectedField(outputFrame.firstFieldData)) writeFail = true;
+        }
+
+        if (writeFail) {
+            // Could not write to target TBC file
+            qCritical() << "Writing fields to the corrected TBC file failed";
+            abort = true;
+            return false;
+        }
+
+        qDebug() << "Corrected frame" << correctedFrameNumber << "- Replacements" << outputFrame.statistics.sameSourceReplacement <<
+                    "same source," << outputFrame.statistics.multiSourceReplacement << "multi-source";
+
+        pendingCorrectedFrames.remove(correctedFrameNumber);
+        correctedFrameNumber++;
+    }
+
+    return true;
+}
+
+// Open the corrected output TBC file for the combined mode.
+// Returns false if the output can't be created for the range of frames being processed.
+bool Sources::openCorrectedOutput(qint32 vbiStartFrame, qint32 vbiEndFrame)
+{
+    // The corrected output must contain every frame of the first source, so that
+    // it matches the first source's metadata
+    if (vbiStartFrame > sourceVideos[0]->vbiFrameIndex.getMinimumVbiFrameNumber() ||
+            vbiEndFrame < sourceVideos[0]->vbiFrameIndex.getMaximumVbiFrameNumber()) {
+        qCritical() << "Correcting dropouts requires every frame of source #0 to be processed - cannot continue!";
+        return false;
+    }
+
+    // Each frame of the first source must also have its own VBI frame number;
+    // otherwise it would never be corrected, and the output would stall
+    // waiting for it
+    const qint32 numberOfFrames = sourceVideos[0]->ldDecodeMetaData.getNumberOfFrames();
+    QVector<bool> frameMapped(numberOfFrames + 1, false);
+    for (qint32 vbiFrame = vbiStartFrame; vbiFrame <= vbiEndFrame; vbiFrame++) {
+        const qint32 sequentialFrame = convertVbiFrameNumberToSequential(vbiFrame, 0);
+        if (sequentialFrame < 1 || sequentialFrame > numberOfFrames) continue;
+        if (frameMapped[sequentialFrame]) {
+            qCritical() << "Frame" << sequentialFrame << "of source #0 has more than one VBI frame number - cannot continue!";
+            return false;
+        }
+        frameMapped[sequentialFrame] = true;
+    }
+    const qint32 unmappedFrame = frameMapped.indexOf(false, 1);
+    if (unmappedFrame != -1) {
+        qCritical() << "Frame" << unmappedFrame << "of source #0 has no VBI frame number, so cannot be corrected - cannot continue!";
+        return false;
+    }
+
+    correctedVideo.setFileName(m_correctedFilename);
+    if (!correctedVideo.open(QIODevice::WriteOnly)) {
+        qCritical() << "Unable to open corrected output video file" << m_correctedFilename;
+        return false;
+    }
+
+    // If there is a leading field in the TBC which is out of field order, we need to copy it
+    // to ensure the JSON metadata files match up
+    qint32 firstFieldNumber = sourceVideos[0]->ldDecodeMetaData.getFirstFieldNumber(1);
+    qint32 secondFieldNumber = sourceVideos[0]->ldDecodeMetaData.getSecondFieldNumber(1);
+
+    if (firstFieldNumber != 1 && secondFieldNumber != 1) {
+        if (!writeCorrectedField(sourceVideos[0]->sourceVideo.getVideoField(1))) {
+            qCritical() << "Writing first field to the corrected TBC file failed";
+            correctedVideo.close();
+            return false;
+        }
+    }
+
+    correctedFrameNumber = 1;
+    pendingCorrectedFrames.clear();
+
+    return true;
+}
+
+// Write a field to the corrected output file.
+// Returns true on success, false on failure (including if the field isn't the
+// right size, as the output would then be out of step with the metadata).
+bool Sources::writeCorrectedField(const SourceVideo::Data &fieldData)
+{
+    const LdDecodeMetaData::VideoParameters videoParameters = sourceVideos[0]->ldDecodeMetaData.getVideoParameters();
+    if (fieldData.size() != videoParameters.fieldWidth * videoParameters.fieldHeight) {
+        qCritical() << "Corrected field has" << fieldData.size() << "samples, expected" <<
+                       videoParameters.fieldWidth * videoParameters.fieldHeight;
+        return false;
+    }
+
+    qint64 length = 2 * static_cast<qint64>(fieldData.size());
+    return correctedVideo.write(reinterpret_cast<const char *>(fieldData.data()), length) == length;
+}
+
 // Load all available input sources
 bool Sources::loadInputTbcFiles(QVector<QString> inputFilenames, bool reverse)
 {
+    // Check that no source file has been given more than once
+    for (qint32 i = 0; i < inputFilenames.size(); i++) {
+        for (qint32 j = 0; j < i; j++) {
+            if (inputFilenames[i] == inputFilenames[j]) {
+                qCritical() << "Cannot load source" << inputFilenames[i] << "- source is already loaded!";
+                return false;
+            }
+        }
+    }
+
+    // Load the sources in parallel, as reading and checking the metadata of
+    // each source is slow and the sources are often on different drives
+    sourceVideos.resize(inputFilenames.size());
+    QVector<QFuture<bool>> loadResults(inputFilenames.size());
     for (qint32 i = 0; i < inputFilenames.size(); i++) {
         qInfo().nospace() << "Loading TBC input source #" << i << " - Filename: " << inputFilenames[i];
-        if (!loadSource(inputFilenames[i], reverse)) {
-            return false;
+        sourceVideos[i] = new Source;
+        loadResults[i] = QtConcurrent::run(this, &Sources::loadSource, i, inputFilenames[i], reverse);
+    }
+
+    bool loadSuccessful = true;
+    for (qint32 i = 0; i < inputFilenames.size(); i++) {
+        if (!loadResults[i].result()) loadSuccessful = false;
+    }
+
+    // Ensure that the video standards of the sources match
+    if (loadSuccessful) {
+        for (qint32 i = 1; i < sourceVideos.size(); i++) {
+            if (sourceVideos[0]->ldDecodeMetaData.getVideoParameters().isSourcePal
+                    != sourceVideos[i]->ldDecodeMetaData.getVideoParameters().isSourcePal) {
+                qWarning().nospace() << "Source #" << i << " video standard does not match existing source(s)!";
+                qCritical() << "Cannot load source - Mixing PAL and NTSC sources is not supported!";
+                loadSuccessful = false;
+                break;
+            }
         }
     }
 
+    if (!loadSuccessful) {
+        // Remove all of the sources
+        for (qint32 i = 0; i < sourceVideos.size(); i++) {
+            sourceVideos[i]->sourceVideo.close();
+            delete sourceVideos[i];
+        }
+        sourceVideos.clear();
+        currentSource = 0;
+        return false;
+    }
+
+    // Select the last source
+    currentSource = sourceVideos.size() - 1;
+
     return true;
 }
 
@@ -228,211 +487,103 @@ void Sources::unloadInputTbcFiles()
     }
 }
 
-// Load a TBC source video; returns false on failure
-bool Sources::loadSource(QString filename, bool reverse)
+// Load a TBC source video; returns false on failure.
+// This is called for all of the sources at once, so it must only use its own source.
+bool Sources::loadSource(qint32 sourceNumber, QString filename, bool reverse)
 {
-    // Check that source file isn't already loaded
-    for (qint32 i = 0; i < sourceVideos.size(); i++) {
-        if (filename == sourceVideos[i]->filename) {
-            qCritical() << "Cannot load source - source is already loaded!";
-            return false;
-        }
-    }
-
-    bool loadSuccessful = true;
-    sourceVideos.resize(sourceVideos.size() + 1);
-    qint32 newSourceNumber = sourceVideos.size() - 1;
-    sourceVideos[newSourceNumber] = new Source;
+    Source *source = sourceVideos[sourceNumber];
     LdDecodeMetaData::VideoParameters videoParameters;
 
     // Open the TBC metadata file
-    qInfo() << "Processing input TBC JSON metadata...";
-    if (!sourceVideos[newSourceNumber]->ldDecodeMetaData.read(filename + ".json")) {
+    qInfo().nospace() << "Source #" << sourceNumber << ": Processing input TBC JSON metadata...";
+    if (!source->ldDecodeMetaData.read(filename + ".json")) {
         // Open failed
         qWarning() << "Open TBC JSON metadata failed for filename" << filename;
         qCritical() << "Cannot load source - JSON metadata could not be read!";
-
-        delete sourceVideos[newSourceNumber];
-        sourceVideos.remove(newSourceNumber);
-        currentSource = 0;
         return false;
     }
 
     // Set the source as reverse field order if required
-    if (reverse) sourceVideos[newSourceNumber]->ldDecodeMetaData.setIsFirstFieldFirst(false);
+    if (reverse) source->ldDecodeMetaData.setIsFirstFieldFirst(false);
 
     // Get the video parameters from the metadata
-    videoParameters = sourceVideos[newSourceNumber]->ldDecodeMetaData.getVideoParameters();
+    videoParameters = source->ldDecodeMetaData.getVideoParameters();
 
     // Ensure that the TBC file has been mapped
     if (!videoParameters.isMapped) {
-        qWarning() << "New source video has not been mapped!";
+        qWarning().nospace() << "Source #" << sourceNumber << " video has not been mapped!";
         qCritical() << "Cannot load source - The TBC has not been mapped (please run ld-discmap on the source)!";
-        loadSuccessful = false;
-    }
-
-    // Ensure that the video standard matches any existing sources
-    if (loadSuccessful) {
-        if ((sourceVideos.size() - 1 > 0) && (sourceVideos[0]->ldDecodeMetaData.getVideoParameters().isSourcePal
-                                              != videoParameters.isSourcePal)) {
-            qWarning() << "New source video standard does not match existing source(s)!";
-            qCritical() << "Cannot load source - Mixing PAL and NTSC sources is not supported!";
-            loadSuccessful = false;
-        }
+        return false;
     }
 
-    if (videoParameters.isSourcePal) qInfo() << "Video format is PAL"; else qInfo() << "Video format is NTSC";
+    if (videoParameters.isSourcePal) qInfo().nospace() << "Source #" << sourceNumber << ": Video format is PAL";
+    else qInfo().nospace() << "Source #" << sourceNumber << ": Video format is NTSC";
 
     // Ensure that the video has VBI data
-    if (loadSuccessful) {
-        if (!sourceVideos[newSourceNumber]->ldDecodeMetaData.getFieldVbi(1).inUse) {
-            qWarning() << "New source video does not contain VBI data!";
-            qCritical() << "Cannot load source - No VBI data available. Please run ld-process-vbi before loading source!";
-            loadSuccessful = false;
-        }
+    if (!source->ldDecodeMetaData.getFieldVbi(1).inUse) {
+        qWarning().nospace() << "Source #" << sourceNumber << " video does not contain VBI data!";
+        qCritical() << "Cannot load source - No VBI data available. Please run ld-process-vbi before loading source!";
+        return false;
     }
 
     // Determine the minimum and maximum VBI frame number and the disc type
-    if (loadSuccessful) {
-        qInfo() << "Determining input TBC disc type and VBI frame range...";
-        if (!setDiscTypeAndMaxMinFrameVbi(newSourceNumber)) {
-            // Failed
-            qCritical() << "Cannot load source - Could not determine disc type and/or VBI frame range!";
-            loadSuccessful = false;
-        }
+    qInfo().nospace() << "Source #" << sourceNumber << ": Determining input TBC disc type and VBI frame range...";
+    if (!setDiscTypeAndMaxMinFrameVbi(sourceNumber, filename)) {
+        // Failed
+        qCritical() << "Cannot load source - Could not determine disc type and/or VBI frame range!";
+        return false;
     }
 
     // Show the 0 and 100IRE points for the source
-    qInfo() << "Source has 0IRE at" << videoParameters.black16bIre << "and 100IRE at" << videoParameters.white16bIre;
+    qInfo().nospace() << "Source #" << sourceNumber << ": Source has 0IRE at " << videoParameters.black16bIre <<
+                         " and 100IRE at " << videoParameters.white16bIre;
 
     // Open the new source TBC video
-    if (loadSuccessful) {
-        qInfo() << "Loading input TBC video data...";
-        if (!sourceVideos[newSourceNumber]->sourceVideo.open(filename, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
-           // Open failed
-           qWarning() << "Open TBC file failed for filename" << filename;
-           qCritical() << "Cannot load source - Error reading source TBC data file!";
-           loadSuccessful = false;
-        }
+    qInfo().nospace() << "Source #" << sourceNumber << ": Loading input TBC video data...";
+    if (!source->sourceVideo.open(filename, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
+       // Open failed
+       qWarning() << "Open TBC file failed for filename" << filename;
+       qCritical() << "Cannot load source - Error reading source TBC data file!";
+       return false;
     }
 
-    // Finish up
-    if (loadSuccessful) {
-        // Loading successful
-        sourceVideos[newSourceNumber]->filename = filename;
-        loadSuccessful = true;
-    } else {
-        // Loading unsuccessful - Remove the new source entry and default the current source
-        sourceVideos[newSourceNumber]->sourceVideo.close();
-        delete sourceVideos[newSourceNumber];
-        sourceVideos.remove(newSourceNumber);
-        currentSource = 0;
-        return false;
-    }
+    // Use a single, persistent I/O thread for reading the source
+    source->readerPool.setMaxThreadCount(1);
+    source->readerPool.setExpiryTimeout(-1);
 
-    // Select the new source
-    currentSource = newSourceNumber;
+    // Loading successful
+    source->filename = filename;
 
     return true;
 }
 
 // Method to work out the disc type (CAV or CLV) and the maximum and minimum
 // VBI frame numbers for the source
-bool Sources::setDiscTypeAndMaxMinFrameVbi(qint32 sourceNumber)
+bool Sources::setDiscTypeAndMaxMinFrameVbi(qint32 sourceNumber, QString filename)
 {
-    sourceVideos[sourceNumber]->isSourceCav = false;
-
-    // Determine the disc type
-    VbiDecoder vbiDecoder;
-    qint32 cavCount = 0;
-    qint32 clvCount = 0;
-
-    qint32 typeCountMax = 100;
-    if (sourceVideos[sourceNumber]->ldDecodeMetaData.getNumberOfFrames() < typeCountMax)
-        typeCountMax = sourceVideos[sourceNumber]->ldDecodeMetaData.getNumberOfFrames();
+    VbiFrameIndex &vbiFrameIndex = sourceVideos[sourceNumber]->vbiFrameIndex;
 
-    // Using sequential frame numbering starting from 1
-    for (qint32 seqFrame = 1; seqFrame <= typeCountMax; seqFrame++) {
-        // Get the VBI data and then decode
-        QVector<qint32> vbi1 = sourceVideos[sourceNumber]->ldDecodeMetaData.getFieldVbi(sourceVideos[sourceNumber]->
-                                                                                        ldDecodeMetaData.getFirstFieldNumber(seqFrame)).vbiData;
-        QVector<qint32> vbi2 = sourceVideos[sourceNumber]->ldDecodeMetaData.getFieldVbi(sourceVideos[sourceNumber]->
-                                                                                        ldDecodeMetaData.getSecondFieldNumber(seqFrame)).vbiData;
-        VbiDecoder::Vbi vbi = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
-
-        // Look for a complete, valid CAV picture number or CLV time-code
-        if (vbi.picNo > 0) cavCount++;
-
-        if (vbi.clvHr != -1 && vbi.clvMin != -1 &&
-                vbi.clvSec != -1 && vbi.clvPicNo != -1) clvCount++;
-    }
-    qDebug() << "Got" << cavCount << "CAV picture codes and" << clvCount << "CLV timecodes";
-
-    // If the metadata has no picture numbers or time-codes, we cannot use the source
-    if (cavCount == 0 && clvCount == 0) {
+    // Build the VBI frame index for the source (this uses the cached index if
+    // it's up to date with the metadata)
+    if (!vbiFrameIndex.build(sourceVideos[sourceNumber]->ldDecodeMetaData, filename + ".json")) {
+        // If the metadata has no picture numbers or time-codes, we cannot use the source
         qDebug() << "Source does not seem to contain valid CAV picture numbers or CLV time-codes - cannot process";
         return false;
     }
+    qDebug() << "Got" << vbiFrameIndex.getCavCount() << "CAV picture codes and" << vbiFrameIndex.getClvCount() << "CLV timecodes";
 
     // Determine disc type
-    if (cavCount > clvCount) {
-        sourceVideos[sourceNumber]->isSourceCav = true;
-        qDebug() << "Got" << cavCount << "valid CAV picture numbers - source disc type is CAV";
-        qInfo() << "Disc type is CAV";
+    if (vbiFrameIndex.isDiscCav()) {
+        qDebug() << "Got" << vbiFrameIndex.getCavCount() << "valid CAV picture numbers - source disc type is CAV";
+        qInfo().nospace() << "Source #" << sourceNumber << ": Disc type is CAV";
     } else {
-        sourceVideos[sourceNumber]->isSourceCav = false;
-        qDebug() << "Got" << clvCount << "valid CLV picture numbers - source disc type is CLV";
-        qInfo() << "Disc type is CLV";
-
+        qDebug() << "Got" << vbiFrameIndex.getClvCount() << "valid CLV picture numbers - source disc type is CLV";
+        qInfo().nospace() << "Source #" << sourceNumber << ": Disc type is CLV";
     }
 
-    // Disc has been mapped, so we can use the first and last frame numbers as the
-    // min and max range of VBI frame numbers in the input source
-    QVector<qint32> vbi1 = sourceVideos[sourceNumber]->ldDecodeMetaData.getFieldVbi(sourceVideos[sourceNumber]->
-                                                                                    ldDecodeMetaData.getFirstFieldNumber(1)).vbiData;
-    QVector<qint32> vbi2 = sourceVideos[sourceNumber]->ldDecodeMetaData.getFieldVbi(sourceVideos[sourceNumber]->
-                                                                                    ldDecodeMetaData.getSecondFieldNumber(1)).vbiData;
-    VbiDecoder::Vbi vbi = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
-
-    if (sourceVideos[sourceNumber]->isSourceCav) {
-        sourceVideos[sourceNumber]->minimumVbiFrameNumber = vbi.picNo;
-    } else {
-        LdDecodeMetaData::ClvTimecode timecode;
-        timecode.hours = vbi.clvHr;
-        timecode.minutes = vbi.clvMin;
-        timecode.seconds = vbi.clvSec;
-        timecode.pictureNumber = vbi.clvPicNo;
-        sourceVideos[sourceNumber]->minimumVbiFrameNumber = sourceVideos[sourceNumber]->ldDecodeMetaData.convertClvTimecodeToFrameNumber(timecode);
-    }
-
-    vbi1 = sourceVideos[sourceNumber]->ldDecodeMetaData.getFieldVbi(sourceVideos[sourceNumber]->
-                       ldDecodeMetaData.getFirstFieldNumber(sourceVideos[sourceNumber]->ldDecodeMetaData.getNumberOfFrames())).vbiData;
-    vbi2 = sourceVideos[sourceNumber]->ldDecodeMetaData.getFieldVbi(sourceVideos[sourceNumber]->
-                       ldDecodeMetaData.getSecondFieldNumber(sourceVideos[sourceNumber]->ldDecodeMetaData.getNumberOfFrames())).vbiData;
-    vbi = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
-
-    if (sourceVideos[sourceNumber]->isSourceCav) {
-        sourceVideos[sourceNumber]->maximumVbiFrameNumber = vbi.picNo;
-    } else {
-        LdDecodeMetaData::ClvTimecode timecode;
-        timecode.hours = vbi.clvHr;
-        timecode.minutes = vbi.clvMin;
-        timecode.seconds = vbi.clvSec;
-        timecode.pictureNumber = vbi.clvPicNo;
-        sourceVideos[sourceNumber]->maximumVbiFrameNumber = sourceVideos[sourceNumber]->ldDecodeMetaData.convertClvTimecodeToFrameNumber(timecode);
-    }
-
-    if (sourceVideos[sourceNumber]->isSourceCav) {
-        // If the source is CAV frame numbering should be a minimum of 1 (it
-        // can be 0 for CLV sources)
-        if (sourceVideos[sourceNumber]->minimumVbiFrameNumber < 1) {
-            qCritical() << "CAV start frame of" << sourceVideos[sourceNumber]->minimumVbiFrameNumber << "is out of bounds (should be 1 or above)";
-            return false;
-        }
-    }
-
-    qInfo() << "VBI frame number range is" << sourceVideos[sourceNumber]->minimumVbiFrameNumber << "to" <<
-        sourceVideos[sourceNumber]->maximumVbiFrameNumber;
+    qInfo().nospace() << "Source #" << sourceNumber << ": VBI frame number range is " <<
+        vbiFrameIndex.getMinimumVbiFrameNumber() << " to " <<
+        vbiFrameIndex.getMaximumVbiFrameNumber();
 
     return true;
 }
@@ -442,8 +593,8 @@ qint32 Sources::getMinimumVbiFrameNumber()
 {
     qint32 minimumFrameNumber = 1000000;
     for (qint32 i = 0; i < sourceVideos.size(); i++) {
-        if (sourceVideos[i]->minimumVbiFrameNumber < minimumFrameNumber)
-            minimumFrameNumber = sourceVideos[i]->minimumVbiFrameNumber;
+        if (sourceVideos[i]->vbiFrameIndex.getMinimumVbiFrameNumber() < minimumFrameNumber)
+            minimumFrameNumber = sourceVideos[i]->vbiFrameIndex.getMinimumVbiFrameNumber();
     }
 
     return minimumFrameNumber;
@@ -454,8 +605,8 @@ qint32 Sources::getMaximumVbiFrameNumber()
 {
     qint32 maximumFrameNumber = 0;
     for (qint32 i = 0; i < sourceVideos.size(); i++) {
-        if (sourceVideos[i]->maximumVbiFrameNumber > maximumFrameNumber)
-            maximumFrameNumber = sourceVideos[i]->maximumVbiFrameNumber;
+        if (sourceVideos[i]->vbiFrameIndex.getMaximumVbiFrameNumber() > maximumFrameNumber)
+            maximumFrameNumber = sourceVideos[i]->vbiFrameIndex.getMaximumVbiFrameNumber();
     }
 
     return maximumFrameNumber;
@@ -492,16 +643,11 @@ QVector<qint32> Sources::getAvailableSourcesForFrame(qint32 vbiFrameNumber)
 {
     QVector<qint32> availableSourcesForFrame;
     for (qint32 sourceNo = 0; sourceNo < sourceVideos.size(); sourceNo++) {
-        if (vbiFrameNumber >= sourceVideos[sourceNo]->minimumVbiFrameNumber && vbiFrameNumber <= sourceVideos[sourceNo]->maximumVbiFrameNumber) {
-            // Get the field numbers for the frame
-            qint32 firstFieldNumber = sourceVideos[sourceNo]->ldDecodeMetaData.getFirstFieldNumber(convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo));
-            qint32 secondFieldNumber = sourceVideos[sourceNo]->ldDecodeMetaData.getSecondFieldNumber(convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo));
-
-            // Ensure the frame is not a padded field (i.e. missing)
-            if (!(sourceVideos[sourceNo]->ldDecodeMetaData.getField(firstFieldNumber).pad &&
-                  sourceVideos[sourceNo]->ldDecodeMetaData.getField(secondFieldNumber).pad)) {
-                availableSourcesForFrame.append(sourceNo);
-            }
+        qint32 sequentialFrameNumber = convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo);
+
+        // Ensure the frame is not a padded field (i.e. missing)
+        if (sequentialFrameNumber != -1 && !sourceVideos[sourceNo]->vbiFrameIndex.isPadded(sequentialFrameNumber)) {
+            availableSourcesForFrame.append(sourceNo);
         }
     }
 
@@ -511,8 +657,7 @@ QVector<qint32> Sources::getAvailableSourcesForFrame(qint32 vbiFrameNumber)
 // Method to convert a VBI frame number to a sequential frame number
 qint32 Sources::convertVbiFrameNumberToSequential(qint32 vbiFrameNumber, qint32 sourceNumber)
 {
-    // Offset the VBI frame number to get the sequential source frame number
-    return vbiFrameNumber - sourceVideos[sourceNumber]->minimumVbiFrameNumber + 1;
+    return sourceVideos[sourceNumber]->vbiFrameIndex.getSequentialFrameNumber(vbiFrameNumber);
 }
 
 // Get the number of available sources
@@ -529,33 +674,52 @@ void Sources::saveSources()
         // Write the JSON metadata
         qInfo() << "Writing JSON metadata file for TBC file" << sourceNo;
         sourceVideos[sourceNo]->ldDecodeMetaData.write(sourceVideos[sourceNo]->filename + ".json");
+
+        // Only the dropouts have changed, so keep the VBI frame index cache valid
+        sourceVideos[sourceNo]->vbiFrameIndex.saveCache(sourceVideos[sourceNo]->filename + ".json");
     }
 }
 
-// Get the field data for the specified frame
-QVector<SourceVideo::Data> Sources::getFieldData(qint32 targetVbiFrame, bool isFirstField,
-                                                 QVector<qint32> &availableSourcesForFrame)
+// Get the field data for the specified fields from each source (sources with a
+// field number of -1 are skipped). The reads for each source are queued on that
+// source's I/O thread, so all of the sources are read at the same time.
+void Sources::getFieldData(const QVector<qint32> &firstFieldNumbers, const QVector<qint32> &secondFieldNumbers,
+                           QVector<SourceVideo::Data> &firstFields, QVector<SourceVideo::Data> &secondFields)
 {
-    // Only display on first field (otherwise we will get 2 of the same debug)
-    if (isFirstField) qDebug() << "Processing VBI Frame" << targetVbiFrame << "-" << availableSourcesForFrame.size() << "sources available";
+    QVector<QFuture<QPair<SourceVideo::Data, SourceVideo::Data>>> reads(getNumberOfAvailableSources());
+    for (qint32 sourceNo = 0; sourceNo < getNumberOfAvailableSources(); sourceNo++) {
+        if (firstFieldNumbers[sourceNo] == -1) continue;
+        reads[sourceNo] = QtConcurrent::run(&sourceVideos[sourceNo]->readerPool, this, &Sources::readFrameFields,
+                                            sourceNo, firstFieldNumbers[sourceNo], secondFieldNumbers[sourceNo]);
+    }
 
-    // Get the field data for the frame from all of the available sources and copy locally
-    QVector<SourceVideo::Data> fields;
-    fields.resize(getNumberOfAvailableSources());
+    // Collect the data as the reads complete
+    firstFields.clear();
+    secondFields.clear();
+    firstFields.resize(getNumberOfAvailableSources());
+    secondFields.resize(getNumberOfAvailableSources());
 
-    QVector<SourceVideo::Data*> sourceFirstFieldPointer;
-    sourceFirstFieldPointer.resize(getNumberOfAvailableSources());
+    for (qint32 sourceNo = 0; sourceNo < getNumberOfAvailableSources(); sourceNo++) {
+        if (firstFieldNumbers[sourceNo] == -1) continue;
+        const QPair<SourceVideo::Data, SourceVideo::Data> fields = reads[sourceNo].result();
+        firstFields[sourceNo] = fields.first;
+        secondFields[sourceNo] = fields.second;
+    }
+}
 
-    for (qint32 sourcePointer = 0; sourcePointer < availableSourcesForFrame.size(); sourcePointer++) {
-        qint32 sourceNo = availableSourcesForFrame[sourcePointer]; // Get the actual source
-        qint32 fieldNumber = -1;
-        if (isFirstField) fieldNumber = sourceVideos[sourceNo]->
-                ldDecodeMetaData.getFirstFieldNumber(convertVbiFrameNumberToSequential(targetVbiFrame, sourceNo));
-        else fieldNumber = sourceVideos[sourceNo]->
-                ldDecodeMetaData.getSecondFieldNumber(convertVbiFrameNumberToSequential(targetVbiFrame, sourceNo));
+// Read both fields of a frame from a source (called on the source's I/O thread)
+QPair<SourceVideo::Data, SourceVideo::Data> Sources::readFrameFields(qint32 sourceNo, qint32 firstFieldNumber,
+                                                                     qint32 secondFieldNumber)
+{
+    QPair<SourceVideo::Data, SourceVideo::Data> fields;
 
-        // Copy the data locally
-        fields[sourceNo] = (sourceVideos[sourceNo]->sourceVideo.getVideoField(fieldNumber));
+    // Get the fields in TBC sequence order to save seeking
+    if (firstFieldNumber < secondFieldNumber) {
+        fields.first = sourceVideos[sourceNo]->sourceVideo.getVideoField(firstFieldNumber);
+        fields.second = sourceVideos[sourceNo]->sourceVideo.getVideoField(secondFieldNumber);
+    } else {
+        fields.second = sourceVideos[sourceNo]->sourceVideo.getVideoField(secondFieldNumber);
+        fields.first = sourceVideos[sourceNo]->sourceVideo.getVideoField(firstFieldNumber);
     }
 
     return fields;
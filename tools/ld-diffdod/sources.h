@@ -33,7 +33,11 @@
 #include <QElapsedTimer>
 #include <QMutex>
 #include <QThread>
+#include <QThreadPool>
+#include <QPair>
+#include <QMap>
 
+#include "vbiframeindex.h"
 #include "diffdod.h"
 
 class Sources : public QObject
@@ -44,6 +48,7 @@ public:
     explicit Sources(QVector<QString> inputFilenames, bool reverse,
                      qint32 dodThreshold, bool lumaClip,
                      qint32 startVbi, qint32 lengthVbi,
+                     QString correctedFilename, bool intraField, bool overCorrect,
                      qint32 maxThreads, QObject *parent = nullptr);
 
     bool process();
@@ -53,22 +58,32 @@ public:
                         QVector<SourceVideo::Data>& firstFields, QVector<SourceVideo::Data>& secondFields,
                         LdDecodeMetaData::VideoParameters& videoParameters,
                         QVector<qint32>& availableSourcesForFrame,
-                        qint32& dodThreshold, bool& signalClip);
+                        qint32& dodThreshold, bool& signalClip,
+                        QVector<qint32>& firstFieldNumbers, QVector<qint32>& secondFieldNumbers,
+                        QVector<LdDecodeMetaData::Field>& firstFieldMetadata,
+                        QVector<LdDecodeMetaData::Field>& secondFieldMetadata,
+                        bool& correctFrame, bool& intraField, bool& overCorrect);
 
     bool setOutputFrame(qint32 targetVbiFrame,
                          QVector<LdDecodeMetaData::DropOuts> firstFieldDropouts,
                          QVector<LdDecodeMetaData::DropOuts> secondFieldDropouts,
                          QVector<qint32> availableSourcesForFrame);
 
+    bool setCorrectedFrame(qint32 targetVbiFrame,
+                           const SourceVideo::Data &firstFieldData, const SourceVideo::Data &secondFieldData,
+                           qint32 firstFieldNumber, qint32 secondFieldNumber,
+                           const DropOutCorrect::Statistics &statistics);
+
 private:
     // Source definition
     struct Source {
         SourceVideo sourceVideo;
         LdDecodeMetaData ldDecodeMetaData;
         QString filename;
-        qint32 minimumVbiFrameNumber;
-        qint32 maximumVbiFrameNumber;
-        bool isSourceCav;
+        VbiFrameIndex vbiFrameIndex;
+
+        // Each source has its own I/O thread, so fields can be read from all sources at once
+        QThreadPool readerPool;
     };
 
     QVector<Source*> sourceVideos;
@@ -84,6 +99,9 @@ private:
     qint32 m_startVbi;
     qint32 m_lengthVbi;
     qint32 m_maxThreads;
+    QString m_correctedFilename;
+    bool m_intraField;
+    bool m_overCorrect;
 
     // Input stream variables (all guarded by inputMutex while threads are running)
     QMutex inputMutex;
@@ -93,14 +111,29 @@ private:
     // Output stream variables (all guarded by outputMutex while threads are running)
     QMutex outputMutex;
 
+    // Corrected output for the combined mode (also guarded by outputMutex)
+    struct CorrectedFrame {
+        SourceVideo::Data firstFieldData;
+        SourceVideo::Data secondFieldData;
+        qint32 firstFieldNumber;
+        qint32 secondFieldNumber;
+        DropOutCorrect::Statistics statistics;
+    };
+
+    QFile correctedVideo;
+    qint32 correctedFrameNumber;
+    QMap<qint32, CorrectedFrame> pendingCorrectedFrames;
+
     // Atomic abort flag shared by worker threads; workers watch this, and shut
     // down as soon as possible if it becomes true
     QAtomicInt abort;
 
+    bool openCorrectedOutput(qint32 vbiStartFrame, qint32 vbiEndFrame);
+    bool writeCorrectedField(const SourceVideo::Data &fieldData);
     bool loadInputTbcFiles(QVector<QString> inputFilenames, bool reverse);
     void unloadInputTbcFiles();
-    bool loadSource(QString filename, bool reverse);
-    bool setDiscTypeAndMaxMinFrameVbi(qint32 sourceNumber);
+    bool loadSource(qint32 sourceNumber, QString filename, bool reverse);
+    bool setDiscTypeAndMaxMinFrameVbi(qint32 sourceNumber, QString filename);
     qint32 getMinimumVbiFrameNumber();
     qint32 getMaximumVbiFrameNumber();
     void verifySources(qint32 vbiStartFrame, qint32 length);
@@ -109,8 +142,10 @@ private:
     qint32 getNumberOfAvailableSources();
     //void processSources(qint32 vbiStartFrame, qint32 length, qint32 dodThreshold, bool lumaClip);
     void saveSources();
-    QVector<SourceVideo::Data> getFieldData(qint32 targetVbiFrame, bool isFirstField,
-                                                     QVector<qint32> &availableSourcesForFrame);
+    void getFieldData(const QVector<qint32> &firstFieldNumbers, const QVector<qint32> &secondFieldNumbers,
+                      QVector<SourceVideo::Data> &firstFields, QVector<SourceVideo::Data> &secondFields);
+    QPair<SourceVideo::Data, SourceVideo::Data> readFrameFields(qint32 sourceNo, qint32 firstFieldNumber,
+                                                                qint32 secondFieldNumber);
 };
 
 #endif // SOURCES_H
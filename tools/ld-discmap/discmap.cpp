@@ -66,22 +66,18 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
     // Resize the frame store
     m_frames.resize(m_numberOfFrames);
 
-    // Decode the VBI information for the TBC and initialise the frame object
-    VbiDecoder vbiDecoder;
-    QVector<VbiDecoder::Vbi> vbiData(m_numberOfFrames);
+    // Decode the VBI information for the TBC (using the cached index if it's
+    // up to date with the metadata) and initialise the frame object
+    VbiFrameIndex vbiFrameIndex;
+    vbiFrameIndex.build(*ldDecodeMetaData, metadataFileInfo.filePath());
     for (qint32 frameNumber = 0; frameNumber < m_numberOfFrames; frameNumber++) {
         // Store the original sequential frame number and the fields
         m_frames[frameNumber].seqFrameNumber(frameNumber + 1);
         m_frames[frameNumber].firstField(ldDecodeMetaData->getFirstFieldNumber(frameNumber + 1));
         m_frames[frameNumber].secondField(ldDecodeMetaData->getSecondFieldNumber(frameNumber + 1));
 
-        // Get the VBI data and then decode (frames are indexed from 1)
-        QVector<qint32> vbi1 = ldDecodeMetaData->getFieldVbi(ldDecodeMetaData->getFirstFieldNumber(frameNumber + 1)).vbiData;
-        QVector<qint32> vbi2 = ldDecodeMetaData->getFieldVbi(ldDecodeMetaData->getSecondFieldNumber(frameNumber + 1)).vbiData;
-        vbiData[frameNumber] = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
-
-        if (vbiData[frameNumber].leadIn || vbiData[frameNumber].leadOut) m_frames[frameNumber].isLeadInOrOut(true);
-        else m_frames[frameNumber].isLeadInOrOut(false);
+        // Frames are indexed from 1
+        m_frames[frameNumber].isLeadInOrOut(vbiFrameIndex.isLeadInOrOut(frameNumber + 1));
     }
 
     // Get the source format (PAL/NTSC)
@@ -98,9 +94,8 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
     // Count how many frames are marked as CAV or CLV in the metadata
     for (qint32 frameNumber = 0; frameNumber < framesToCheck; frameNumber++) {
         // Look for a complete, valid CAV picture number or CLV time-code
-        if (vbiData[frameNumber].picNo > 0) cavCount++;
-        if (vbiData[frameNumber].clvHr != -1 && vbiData[frameNumber].clvMin != -1 &&
-                vbiData[frameNumber].clvSec != -1 && vbiData[frameNumber].clvPicNo != -1) clvCount++;
+        if (vbiFrameIndex.getPictureNumber(frameNumber + 1) != -1) cavCount++;
+        if (vbiFrameIndex.getClvFrameNumber(frameNumber + 1) != -1) clvCount++;
     }
 
     // If the metadata has no picture numbers or time-codes, we cannot use the source
@@ -126,13 +121,8 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
     qint32 iecOffset = -1;
     for (qint32 frameNumber = 0; frameNumber < m_numberOfFrames; frameNumber++) {
         if (!m_isDiscCav) {
-            // Attempt to translate the CLV timecode into a frame number
-            LdDecodeMetaData::ClvTimecode clvTimecode;
-            clvTimecode.hours = vbiData[frameNumber].clvHr;
-            clvTimecode.minutes = vbiData[frameNumber].clvMin;
-            clvTimecode.seconds = vbiData[frameNumber].clvSec;
-            clvTimecode.pictureNumber = vbiData[frameNumber].clvPicNo;
-            m_frames[frameNumber].vbiFrameNumber(ldDecodeMetaData->convertClvTimecodeToFrameNumber(clvTimecode));
+            // Use the CLV timecode translated into a frame number
+            m_frames[frameNumber].vbiFrameNumber(vbiFrameIndex.getClvFrameNumber(frameNumber + 1));
 
             // Check for CLV timecode offset frame (actually, this marks the frame
             // that preceeds the jump)
@@ -146,7 +136,7 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
                 }
             }
         } else {
-            m_frames[frameNumber].vbiFrameNumber(vbiData[frameNumber].picNo);
+            m_frames[frameNumber].vbiFrameNumber(vbiFrameIndex.getPictureNumber(frameNumber + 1));
         }
     }
 
@@ -230,10 +220,10 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
                     // and after the current frame...
                     qint32 doubleCheckCounter = 0;
                     if (frameNumber > 5) {
-                        if (vbiData[frameNumber - 5].picNo == -1) doubleCheckCounter++;
+                        if (vbiFrameIndex.getPictureNumber(frameNumber - 4) == -1) doubleCheckCounter++;
                     }
                     if (frameNumber < m_numberOfFrames - 5) {
-                        if (vbiData[frameNumber + 5].picNo == -1) doubleCheckCounter++;
+                        if (vbiFrameIndex.getPictureNumber(frameNumber + 6) == -1) doubleCheckCounter++;
                     }
 
                     if (doubleCheckCounter < 1) {
@@ -266,7 +256,7 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
         // frame a quality penalty as the likelyhood the player skipped is higher
         qreal penaltyPercent = 0;
         if (frameNumber < m_numberOfFrames - 1) {
-            if (vbiData[frameNumber + 1].picNo < vbiData[frameNumber].picNo) penaltyPercent = 80.0;
+            if (vbiFrameIndex.getPictureNumber(frameNumber + 2) < vbiFrameIndex.getPictureNumber(frameNumber + 1)) penaltyPercent = 80.0;
             else penaltyPercent = 100.0;
         }
 
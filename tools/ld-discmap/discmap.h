@@ -32,6 +32,7 @@
 // TBC library includes
 #include "lddecodemetadata.h"
 #include "vbidecoder.h"
+#include "vbiframeindex.h"
 
 #include "frame.h"
 
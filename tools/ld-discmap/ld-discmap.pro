@@ -18,6 +18,8 @@ SOURCES += \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/sourcevideo.cpp \
     ../library/tbc/vbidecoder.cpp \
+    ../library/tbc/sidecarcache.cpp \
+    ../library/tbc/vbiframeindex.cpp \
     ../library/tbc/logging.cpp \
     discmap.cpp \
     discmapper.cpp \
@@ -28,6 +30,8 @@ HEADERS += \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/sourcevideo.h \
     ../library/tbc/vbidecoder.h \
+    ../library/tbc/sidecarcache.h \
+    ../library/tbc/vbiframeindex.h \
     ../library/tbc/logging.h \
     discmap.h \
     discmapper.h \
@@ -28,16 +28,39 @@
 
 CorrectorPool::CorrectorPool(QString _outputFilename, QString _outputJsonFilename,
                              qint32 _maxThreads, QVector<LdDecodeMetaData *> &_ldDecodeMetaData, QVector<SourceVideo *> &_sourceVideos,
-                             bool _reverse, bool _intraField, bool _overCorrect, QObject *parent)
+                             QVector<QString> _inputJsonFilenames, bool _reverse, bool _intraField, bool _overCorrect, QObject *parent)
     : QObject(parent), outputFilename(_outputFilename), outputJsonFilename(_outputJsonFilename),
       maxThreads(_maxThreads), reverse(_reverse), intraField(_intraField), overCorrect(_overCorrect),
-      abort(false), ldDecodeMetaData(_ldDecodeMetaData), sourceVideos(_sourceVideos)
+      resume(false), abort(false), ldDecodeMetaData(_ldDecodeMetaData), sourceVideos(_sourceVideos),
+      inputJsonFilenames(_inputJsonFilenames), sourceMutexes(new QMutex[_sourceVideos.size()])
 {
 }
 
+void CorrectorPool::setCheckpoint(const QByteArray &runKey, bool _resume)
+{
+    checkpoint.enable(outputFilename, runKey);
+    resume = _resume;
+}
+
 bool CorrectorPool::process()
 {
     qInfo() << "Performing final sanity checks...";
+
+    // If we're resuming, find the last frame written before the interruption
+    qint32 firstFrameNumber = 1;
+    outputBytes = 0;
+    if (resume) {
+        qint32 lastWrittenFrame;
+        if (!checkpoint.read(lastWrittenFrame, outputBytes)) {
+            return false;
+        }
+        if (lastWrittenFrame > ldDecodeMetaData[0]->getNumberOfFrames()) {
+            qCritical() << "Cannot resume - checkpoint frame" << lastWrittenFrame << "is beyond the end of the input";
+            return false;
+        }
+        firstFrameNumber = lastWrittenFrame + 1;
+    }
+
     // Open the target video
     targetVideo.setFileName(outputFilename);
     if (outputFilename == "-") {
@@ -46,6 +69,20 @@ bool CorrectorPool::process()
                 qInfo() << "Unable to open stdout";
                 return false;
         }
+    } else if (resume) {
+        // Reopen the existing output file, discarding anything that was
+        // written after the checkpoint, and append to it
+        if (!targetVideo.open(QIODevice::WriteOnly | QIODevice::Append)) {
+                // Could not open target video file
+                qInfo() << "Unable to open output video file";
+                return false;
+        }
+        if (targetVideo.size() < outputBytes || !targetVideo.resize(outputBytes)) {
+            qCritical() << "Cannot resume - output file is shorter than the checkpoint expects, or could not be truncated";
+            targetVideo.close();
+            return false;
+        }
+        qInfo() << "Resuming after frame #" << firstFrameNumber - 1 << "with" << outputBytes << "bytes already written";
     } else {
         if (!targetVideo.open(QIODevice::WriteOnly)) {
                 // Could not open target video file
@@ -60,7 +97,8 @@ bool CorrectorPool::process()
     qint32 firstFieldNumber = ldDecodeMetaData[0]->getFirstFieldNumber(1);
     qint32 secondFieldNumber = ldDecodeMetaData[0]->getSecondFieldNumber(1);
 
-    if (firstFieldNumber != 1 && secondFieldNumber != 1) {
+    // (If we're resuming, it was written before the checkpoint.)
+    if (firstFieldNumber != 1 && secondFieldNumber != 1 && !resume) {
         SourceVideo::Data sourceField = sourceVideos[0]->getVideoField(1);
         if (!writeOutputField(sourceField)) {
             // Could not write to target TBC file
@@ -84,17 +122,19 @@ bool CorrectorPool::process()
     qInfo() << "Using" << maxThreads << "threads to process" << ldDecodeMetaData[0]->getNumberOfFrames() << "frames";
 
     // Initialise processing state
-    inputFrameNumber = 1;
-    outputFrameNumber = 1;
+    inputFrameNumber = firstFrameNumber;
+    outputFrameNumber = firstFrameNumber;
     lastFrameNumber = ldDecodeMetaData[0]->getNumberOfFrames();
     totalTimer.start();
+    statistics.start(maxThreads);
+    checkpoint.start();
 
     // Start a vector of decoding threads to process the video
     qInfo() << "Beginning multi-threaded dropout correction process...";
     QVector<QThread *> threads;
     threads.resize(maxThreads);
     for (qint32 i = 0; i < maxThreads; i++) {
-        threads[i] = new DropOutCorrect(abort, *this);
+        threads[i] = new CorrectorThread(abort, *this);
         threads[i]->start(QThread::LowPriority);
     }
 
@@ -111,9 +151,11 @@ bool CorrectorPool::process()
     }
 
     // Show the processing speed to the user
+    const qint32 processedFrames = lastFrameNumber + 1 - firstFrameNumber;
     qreal totalSecs = (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
-    qInfo() << "Dropout correction complete -" << lastFrameNumber << "frames in" << totalSecs << "seconds (" <<
-               lastFrameNumber / totalSecs << "FPS )";
+    qInfo() << "Dropout correction complete -" << processedFrames << "frames in" << totalSecs << "seconds (" <<
+               processedFrames / totalSecs << "FPS )";
+    statistics.finish("frames");
 
     qInfo() << "Creating JSON metadata file for drop-out corrected TBC...";
     ldDecodeMetaData[0]->write(outputJsonFilename);
@@ -121,21 +163,34 @@ bool CorrectorPool::process()
     // Close the target video
     targetVideo.close();
 
+    // The output is complete, so the checkpoint is no longer needed
+    checkpoint.remove();
+
     return true;
 }
 
+PoolStatistics &CorrectorPool::getStatistics()
+{
+    return statistics;
+}
+
 // Get the next frame that needs processing from the input.
 //
+// Only the video data for the first source is returned; the other sources are
+// only read (a line at a time, using getInputFieldLine) if a dropout needs them.
+//
 // Returns true if a frame was returned, false if the end of the input has been
 // reached.
 bool CorrectorPool::getInputFrame(qint32& frameNumber,
-                                  QVector<qint32>& firstFieldNumber, QVector<SourceVideo::Data>& firstFieldVideoData, QVector<LdDecodeMetaData::Field>& firstFieldMetadata,
-                                  QVector<qint32>& secondFieldNumber, QVector<SourceVideo::Data>& secondFieldVideoData, QVector<LdDecodeMetaData::Field>& secondFieldMetadata,
+                                  QVector<qint32>& firstFieldNumber, SourceVideo::Data& firstFieldVideoData, QVector<LdDecodeMetaData::Field>& firstFieldMetadata,
+                                  QVector<qint32>& secondFieldNumber, SourceVideo::Data& secondFieldVideoData, QVector<LdDecodeMetaData::Field>& secondFieldMetadata,
                                   QVector<LdDecodeMetaData::VideoParameters>& videoParameters,
                                   bool& _reverse, bool& _intraField, bool& _overCorrect,
                                   QVector<qint32>& availableSourcesForFrame, QVector<qreal>& sourceFrameQuality)
 {
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::inputWaitStage);
     QMutexLocker locker(&inputMutex);
+    waitTimer.stop();
 
     if (inputFrameNumber > lastFrameNumber) {
         // No more input frames
@@ -145,6 +200,8 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
     frameNumber = inputFrameNumber;
     inputFrameNumber++;
 
+    PoolStatistics::Timer readTimer(statistics, PoolStatistics::readStage);
+
     // Determine the number of sources available
     qint32 numberOfSources = sourceVideos.size();
 
@@ -153,10 +210,8 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
 
     // Prepare the vectors
     firstFieldNumber.resize(numberOfSources);
-    firstFieldVideoData.resize(numberOfSources);
     firstFieldMetadata.resize(numberOfSources);
     secondFieldNumber.resize(numberOfSources);
-    secondFieldVideoData.resize(numberOfSources);
     secondFieldMetadata.resize(numberOfSources);
     videoParameters.resize(numberOfSources);
     sourceFrameQuality.resize(numberOfSources);
@@ -183,7 +238,7 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
             qDebug().nospace() << "CorrectorPool::getInputFrame(): Source #0 fields are " <<
                                   firstFieldNumber[sourceNo] << "/" << secondFieldNumber[sourceNo] <<
                                   " (quality is " << sourceFrameQuality[sourceNo] << ")";
-        } else if (currentVbiFrame >= sourceMinimumVbiFrame[sourceNo] && currentVbiFrame <= sourceMaximumVbiFrame[sourceNo]) {
+        } else if (convertVbiFrameNumberToSequential(currentVbiFrame, sourceNo) != -1) {
             // Use VBI frame number mapping to get the same frame from the
             // current additional source
             qint32 currentSourceFrameNumber = convertVbiFrameNumberToSequential(currentVbiFrame, sourceNo);
@@ -204,13 +259,16 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
 
         // If the field numbers are valid - get the rest of the required data
         if (firstFieldNumber[sourceNo] != -1 && secondFieldNumber[sourceNo] != -1) {
-            // Fetch the input data (get the fields in TBC sequence order to save seeking)
-            if (firstFieldNumber[sourceNo] < secondFieldNumber[sourceNo]) {
-                firstFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
-                secondFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
-            } else {
-                secondFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
-                firstFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
+            // Fetch the input data for the first source (get the fields in TBC sequence order to save seeking)
+            if (sourceNo == 0) {
+                QMutexLocker sourceLocker(&sourceMutexes[sourceNo]);
+                if (firstFieldNumber[sourceNo] < secondFieldNumber[sourceNo]) {
+                    firstFieldVideoData = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
+                    secondFieldVideoData = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
+                } else {
+                    secondFieldVideoData = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
+                    firstFieldVideoData = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
+                }
             }
 
             firstFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(firstFieldNumber[sourceNo]);
@@ -235,6 +293,22 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
     return true;
 }
 
+// Get a single field line from one of the input sources.
+//
+// This is used by the worker threads to read replacement data from the
+// additional sources, so only the lines that are actually needed are read.
+// Only the lock for the requested source is held, not inputMutex.
+SourceVideo::Data CorrectorPool::getInputFieldLine(qint32 sourceNo, qint32 fieldNumber, qint32 fieldLine)
+{
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::inputWaitStage);
+    QMutexLocker locker(&sourceMutexes[sourceNo]);
+    waitTimer.stop();
+
+    PoolStatistics::Timer readTimer(statistics, PoolStatistics::readStage);
+
+    return sourceVideos[sourceNo]->getVideoField(fieldNumber, fieldLine, fieldLine);
+}
+
 // Put a corrected frame into the output stream.
 //
 // The worker threads will complete frames in an arbitrary order, so we can't
@@ -248,7 +322,9 @@ bool CorrectorPool::setOutputFrame(qint32 frameNumber,
                                    qint32 firstFieldSeqNo, qint32 secondFieldSeqNo,
                                    qint32 sameSourceReplacement, qint32 multiSourceReplacement, qint32 totalReplacementDistance)
 {
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::outputWaitStage);
     QMutexLocker locker(&outputMutex);
+    waitTimer.stop();
 
     // Put the output frame into the map
     OutputFrame pendingFrame;
@@ -265,10 +341,12 @@ bool CorrectorPool::setOutputFrame(qint32 frameNumber,
     pendingOutputFrames[frameNumber] = pendingFrame;
 
     // Write out as many frames as possible
+    const qint32 firstOutputFrameNumber = outputFrameNumber;
     while (pendingOutputFrames.contains(outputFrameNumber)) {
         const OutputFrame &outputFrame = pendingOutputFrames.value(outputFrameNumber);
 
         // Save the frame data to the output file (with the fields in the correct order)
+        PoolStatistics::Timer writeTimer(statistics, PoolStatistics::writeStage);
         bool writeFail = false;
         if (outputFrame.firstFieldSeqNo < outputFrame.secondFieldSeqNo) {
             // Save the first field and then second field to the output file
@@ -279,6 +357,7 @@ bool CorrectorPool::setOutputFrame(qint32 frameNumber,
             if (!writeOutputField(outputFrame.secondTargetFieldData)) writeFail = true;
             if (!writeOutputField(outputFrame.firstTargetFieldData)) writeFail = true;
         }
+        writeTimer.stop();
 
         // Was the write successful?
         if (writeFail) {
@@ -304,6 +383,12 @@ bool CorrectorPool::setOutputFrame(qint32 frameNumber,
         pendingOutputFrames.remove(outputFrameNumber);
         outputFrameNumber++;
     }
+    statistics.recordOutput(outputFrameNumber - firstOutputFrameNumber, pendingOutputFrames.size());
+
+    // Write a checkpoint if one is due
+    if (checkpoint.isDue()) {
+        checkpoint.write(targetVideo, outputFrameNumber - 1, outputBytes);
+    }
 
     return true;
 }
@@ -317,82 +402,27 @@ bool CorrectorPool::setMinAndMaxVbiFrames()
     // Determine the number of sources available
     qint32 numberOfSources = sourceVideos.size();
 
-    // Resize vectors
-    sourceDiscTypeCav.resize(numberOfSources);
-    sourceMaximumVbiFrame.resize(numberOfSources);
-    sourceMinimumVbiFrame.resize(numberOfSources);
+    vbiFrameIndex.resize(numberOfSources);
 
     for (qint32 sourceNumber = 0; sourceNumber < numberOfSources; sourceNumber++) {
-        // Determine the disc type and max/min VBI frame numbers
-        VbiDecoder vbiDecoder;
-        qint32 cavCount = 0;
-        qint32 clvCount = 0;
-        qint32 cavMin = 1000000;
-        qint32 cavMax = 0;
-        qint32 clvMin = 1000000;
-        qint32 clvMax = 0;
-
-        sourceMinimumVbiFrame[sourceNumber] = 0;
-        sourceMaximumVbiFrame[sourceNumber] = 0;
-        sourceDiscTypeCav[sourceNumber] = false;
-
-        // Using sequential frame numbering starting from 1
-        for (qint32 seqFrame = 1; seqFrame <= ldDecodeMetaData[sourceNumber]->getNumberOfFrames(); seqFrame++) {
-            // Get the VBI data and then decode
-            QVector<qint32> vbi1 = ldDecodeMetaData[sourceNumber]->getFieldVbi(ldDecodeMetaData[sourceNumber]->getFirstFieldNumber(seqFrame)).vbiData;
-            QVector<qint32> vbi2 = ldDecodeMetaData[sourceNumber]->getFieldVbi(ldDecodeMetaData[sourceNumber]->getSecondFieldNumber(seqFrame)).vbiData;
-            VbiDecoder::Vbi vbi = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
-
-            // Look for a complete, valid CAV picture number or CLV time-code
-            if (vbi.picNo > 0) {
-                cavCount++;
-
-                if (vbi.picNo < cavMin) cavMin = vbi.picNo;
-                if (vbi.picNo > cavMax) cavMax = vbi.picNo;
-            }
-
-            if (vbi.clvHr != -1 && vbi.clvMin != -1 &&
-                    vbi.clvSec != -1 && vbi.clvPicNo != -1) {
-                clvCount++;
-
-                LdDecodeMetaData::ClvTimecode timecode;
-                timecode.hours = vbi.clvHr;
-                timecode.minutes = vbi.clvMin;
-                timecode.seconds = vbi.clvSec;
-                timecode.pictureNumber = vbi.clvPicNo;
-                qint32 cvFrameNumber = ldDecodeMetaData[sourceNumber]->convertClvTimecodeToFrameNumber(timecode);
-
-                if (cvFrameNumber < clvMin) clvMin = cvFrameNumber;
-                if (cvFrameNumber > clvMax) clvMax = cvFrameNumber;
-            }
-        }
-        qDebug() << "CorrectorPool::setMinAndMaxVbiFrames(): Got" << cavCount << "CAV picture codes and" << clvCount << "CLV timecodes";
-
-        // If the metadata has no picture numbers or time-codes, we cannot use the source
-        if (cavCount == 0 && clvCount == 0) {
+        // Determine the disc type and max/min VBI frame numbers (this uses
+        // the cached index for the source if it's up to date)
+        if (!vbiFrameIndex[sourceNumber].build(*ldDecodeMetaData[sourceNumber], inputJsonFilenames[sourceNumber])) {
+            // If the metadata has no picture numbers or time-codes, we cannot use the source
             qDebug() << "CorrectorPool::setMinAndMaxVbiFrames(): Source does not seem to contain valid CAV picture numbers or CLV time-codes - cannot process";
             return false;
         }
 
-        // Determine disc type
-        if (cavCount > clvCount) {
-            sourceDiscTypeCav[sourceNumber] = true;
-            qDebug() << "CorrectorPool::setMinAndMaxVbiFrames(): Got" << cavCount << "valid CAV picture numbers - source disc type is CAV";
+        if (vbiFrameIndex[sourceNumber].isDiscCav()) {
+            qDebug() << "CorrectorPool::setMinAndMaxVbiFrames(): Got" << vbiFrameIndex[sourceNumber].getCavCount() << "valid CAV picture numbers - source disc type is CAV";
             qInfo().nospace() << "Source #" << sourceNumber << " has a disc type of CAV (uses VBI frame numbers)";
-
-            sourceMaximumVbiFrame[sourceNumber] = cavMax;
-            sourceMinimumVbiFrame[sourceNumber] = cavMin;
         } else {
-            sourceDiscTypeCav[sourceNumber] = false;
-            qDebug() << "CorrectorPool::setMinAndMaxVbiFrames(): Got" << clvCount << "valid CLV picture numbers - source disc type is CLV";
+            qDebug() << "CorrectorPool::setMinAndMaxVbiFrames(): Got" << vbiFrameIndex[sourceNumber].getClvCount() << "valid CLV picture numbers - source disc type is CLV";
             qInfo().nospace() << "Source #" << sourceNumber << " has a disc type of CLV (uses VBI time codes)";
-
-            sourceMaximumVbiFrame[sourceNumber] = clvMax;
-            sourceMinimumVbiFrame[sourceNumber] = clvMin;
         }
 
-        qInfo().nospace() << "Source #" << sourceNumber << " has a VBI frame number range of " << sourceMinimumVbiFrame[sourceNumber] << " to " <<
-            sourceMaximumVbiFrame[sourceNumber];
+        qInfo().nospace() << "Source #" << sourceNumber << " has a VBI frame number range of " << vbiFrameIndex[sourceNumber].getMinimumVbiFrameNumber() << " to " <<
+            vbiFrameIndex[sourceNumber].getMaximumVbiFrameNumber();
     }
 
     return true;
@@ -401,14 +431,13 @@ bool CorrectorPool::setMinAndMaxVbiFrames()
 // Method to convert the first source sequential frame number to a VBI frame number
 qint32 CorrectorPool::convertSequentialFrameNumberToVbi(qint32 sequentialFrameNumber, qint32 sourceNumber)
 {
-    return (sourceMinimumVbiFrame[sourceNumber] - 1) + sequentialFrameNumber;
+    return vbiFrameIndex[sourceNumber].getVbiFrameNumber(sequentialFrameNumber);
 }
 
 // Method to convert a VBI frame number to a sequential frame number
 qint32 CorrectorPool::convertVbiFrameNumberToSequential(qint32 vbiFrameNumber, qint32 sourceNumber)
 {
-    // Offset the VBI frame number to get the sequential source frame number
-    return vbiFrameNumber - sourceMinimumVbiFrame[sourceNumber] + 1;
+    return vbiFrameIndex[sourceNumber].getSequentialFrameNumber(vbiFrameNumber);
 }
 
 // Method that returns a vector of the sources that contain data for the required VBI frame number
@@ -416,16 +445,11 @@ QVector<qint32> CorrectorPool::getAvailableSourcesForFrame(qint32 vbiFrameNumber
 {
     QVector<qint32> availableSourcesForFrame;
     for (qint32 sourceNo = 0; sourceNo < sourceVideos.size(); sourceNo++) {
-        if (vbiFrameNumber >= sourceMinimumVbiFrame[sourceNo] && vbiFrameNumber <= sourceMaximumVbiFrame[sourceNo]) {
-            // Get the field numbers for the frame
-            qint32 firstFieldNumber = ldDecodeMetaData[sourceNo]->getFirstFieldNumber(convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo));
-            qint32 secondFieldNumber = ldDecodeMetaData[sourceNo]->getSecondFieldNumber(convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo));
-
-            // Ensure the frame is not a padded field (i.e. missing)
-            if (!(ldDecodeMetaData[sourceNo]->getField(firstFieldNumber).pad &&
-                  ldDecodeMetaData[sourceNo]->getField(secondFieldNumber).pad)) {
-                availableSourcesForFrame.append(sourceNo);
-            }
+        qint32 sequentialFrameNumber = convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo);
+
+        // Ensure the frame is not a padded field (i.e. missing)
+        if (sequentialFrameNumber != -1 && !vbiFrameIndex[sourceNo].isPadded(sequentialFrameNumber)) {
+            availableSourcesForFrame.append(sourceNo);
         }
     }
 
@@ -436,5 +460,11 @@ QVector<qint32> CorrectorPool::getAvailableSourcesForFrame(qint32 vbiFrameNumber
 // Returns true on success, false on failure.
 bool CorrectorPool::writeOutputField(const SourceVideo::Data &fieldData)
 {
-    return targetVideo.write(reinterpret_cast<const char *>(fieldData.data()), 2 * fieldData.size());
+    const qint64 fieldBytes = 2 * fieldData.size();
+    if (targetVideo.write(reinterpret_cast<const char *>(fieldData.data()), fieldBytes) != fieldBytes) {
+        return false;
+    }
+
+    outputBytes += fieldBytes;
+    return true;
 }
@@ -29,11 +29,15 @@
 #include <QAtomicInt>
 #include <QElapsedTimer>
 #include <QMutex>
+#include <QScopedArrayPointer>
 #include <QThread>
 
+#include "checkpoint.h"
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
-#include "dropoutcorrect.h"
+#include "poolstatistics.h"
+#include "vbiframeindex.h"
+#include "correctorthread.h"
 
 class CorrectorPool : public QObject
 {
@@ -41,16 +45,28 @@ class CorrectorPool : public QObject
 public:
     explicit CorrectorPool(QString _outputFilename, QString _outputJsonFilename,
                            qint32 _maxThreads, QVector<LdDecodeMetaData *> &_ldDecodeMetaData, QVector<SourceVideo *> &_sourceVideos,
+                           QVector<QString> _inputJsonFilenames,
                            bool _reverse, bool _intraField, bool _overCorrect, QObject *parent = nullptr);
 
     bool process();
 
+    // Get the timing statistics for this pool. These are disabled unless
+    // enabled before process() is called.
+    PoolStatistics &getStatistics();
+
+    // Write checkpoints while processing, so an interrupted run can be
+    // resumed. runKey identifies the settings for the run. If resume is true,
+    // verify the existing checkpoint and output file, then continue after the
+    // last frame written. Call before process().
+    void setCheckpoint(const QByteArray &runKey, bool resume);
+
     // Member functions used by worker threads
     bool getInputFrame(qint32& frameNumber,
-                       QVector<qint32> &firstFieldNumber, QVector<SourceVideo::Data> &firstFieldVideoData, QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
-                       QVector<qint32> &secondFieldNumber, QVector<SourceVideo::Data> &secondFieldVideoData, QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
+                       QVector<qint32> &firstFieldNumber, SourceVideo::Data &firstFieldVideoData, QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
+                       QVector<qint32> &secondFieldNumber, SourceVideo::Data &secondFieldVideoData, QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
                        QVector<LdDecodeMetaData::VideoParameters> &videoParameters,
                        bool& _reverse, bool& _intraField, bool& _overCorrect, QVector<qint32> &availableSourcesForFrame, QVector<qreal> &sourceFrameQuality);
+    SourceVideo::Data getInputFieldLine(qint32 sourceNo, qint32 fieldNumber, qint32 fieldLine);
 
     bool setOutputFrame(qint32 frameNumber,
                         SourceVideo::Data firstTargetFieldData, SourceVideo::Data secondTargetFieldData,
@@ -66,6 +82,10 @@ private:
     bool overCorrect;
     QElapsedTimer totalTimer;
 
+    // Checkpoint/resume state
+    Checkpoint checkpoint;
+    bool resume;
+
     // Atomic abort flag shared by worker threads; workers watch this, and shut
     // down as soon as possible if it becomes true
     QAtomicInt abort;
@@ -76,6 +96,12 @@ private:
     qint32 lastFrameNumber;
     QVector<LdDecodeMetaData *> &ldDecodeMetaData;
     QVector<SourceVideo *> &sourceVideos;
+    QVector<QString> inputJsonFilenames;
+
+    // One lock per source, guarding its SourceVideo. Workers reading single
+    // lines with getInputFieldLine only take the lock for that source, so
+    // reads from different sources can proceed in parallel.
+    QScopedArrayPointer<QMutex> sourceMutexes;
 
     // Output stream information (all guarded by outputMutex while threads are running)
     QMutex outputMutex;
@@ -95,11 +121,13 @@ private:
     qint32 outputFrameNumber;
     QMap<qint32, OutputFrame> pendingOutputFrames;
     QFile targetVideo;
+    qint64 outputBytes;
 
     // Local source information
-    QVector<bool> sourceDiscTypeCav;
-    QVector<qint32> sourceMinimumVbiFrame;
-    QVector<qint32> sourceMaximumVbiFrame;
+    QVector<VbiFrameIndex> vbiFrameIndex;
+
+    // Timing statistics
+    PoolStatistics statistics;
 
     bool setMinAndMaxVbiFrames();
     qint32 convertSequentialFrameNumberToVbi(qint32 sequentialFrameNumber, qint32 sourceNumber);
@@ -0,0 +1,81 @@
+/************************************************************************
+
+    correctorthread.cpp
+
+    ld-dropout-correct - Dropout correction for ld-decode
+    Copyright (C) 2018-2020 Simon Inns
+    Copyright (C) 2019-2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-dropout-correct is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "correctorthread.h"
+#include "correctorpool.h"
+
+CorrectorThread::CorrectorThread(QAtomicInt &_abort, CorrectorPool &_correctorPool, QObject *parent)
+    : QThread(parent), abort(_abort), correctorPool(_correctorPool),
+      dropOutCorrect([this](qint32 sourceNo, qint32 fieldNumber, qint32 fieldLine) {
+          return correctorPool.getInputFieldLine(sourceNo, fieldNumber, fieldLine);
+      })
+{
+}
+
+void CorrectorThread::run()
+{
+    // Variables for getInputFrame
+    qint32 frameNumber;
+    QVector<qint32> firstFieldSeqNo;
+    QVector<qint32> secondFieldSeqNo;
+    SourceVideo::Data firstFieldData;
+    SourceVideo::Data secondFieldData;
+    QVector<LdDecodeMetaData::Field> firstFieldMetadata;
+    QVector<LdDecodeMetaData::Field> secondFieldMetadata;
+    QVector<LdDecodeMetaData::VideoParameters> videoParameters;
+    bool reverse, intraField, overCorrect;
+    QVector<qint32> availableSourcesForFrame;
+    QVector<qreal> sourceFrameQuality;
+
+    // Statistics
+    DropOutCorrect::Statistics statistics;
+
+    while(!abort) {
+        // Get the next field to process from the input file
+        if (!correctorPool.getInputFrame(frameNumber, firstFieldSeqNo, firstFieldData, firstFieldMetadata,
+                                         secondFieldSeqNo, secondFieldData, secondFieldMetadata,
+                                         videoParameters, reverse, intraField, overCorrect,
+                                         availableSourcesForFrame, sourceFrameQuality)) {
+            // No more input fields -- exit
+            break;
+        }
+
+        qDebug().nospace() << "CorrectorThread::run(): Frame #" << frameNumber << " - There are " << firstFieldSeqNo.size() <<
+                              " sources available of which " << availableSourcesForFrame.size() << " contain the required frame";
+
+        // Time the correction. This includes fetching lines from the other
+        // sources, which the pool also counts as waiting for and reading input.
+        PoolStatistics::Timer processTimer(correctorPool.getStatistics(), PoolStatistics::processStage);
+        dropOutCorrect.correctFrame(firstFieldData, secondFieldData, firstFieldSeqNo, secondFieldSeqNo,
+                                    firstFieldMetadata, secondFieldMetadata, videoParameters, intraField, overCorrect,
+                                    availableSourcesForFrame, sourceFrameQuality, statistics);
+        processTimer.stop();
+
+        // Return the processed fields
+        correctorPool.setOutputFrame(frameNumber, firstFieldData, secondFieldData,
+                                     firstFieldSeqNo[0], secondFieldSeqNo[0],
+                statistics.sameSourceReplacement, statistics.multiSourceReplacement, statistics.totalReplacementDistance);
+    }
+}
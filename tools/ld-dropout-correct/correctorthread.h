@@ -0,0 +1,54 @@
+/************************************************************************
+
+    correctorthread.h
+
+    ld-dropout-correct - Dropout correction for ld-decode
+    Copyright (C) 2018-2020 Simon Inns
+    Copyright (C) 2019-2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-dropout-correct is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef CORRECTORTHREAD_H
+#define CORRECTORTHREAD_H
+
+#include <QAtomicInt>
+#include <QThread>
+
+#include "dropoutcorrect.h"
+
+class CorrectorPool;
+
+// Worker thread for CorrectorPool, which corrects frames until there are none left
+class CorrectorThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit CorrectorThread(QAtomicInt &_abort, CorrectorPool &_correctorPool, QObject *parent = nullptr);
+
+protected:
+    void run() override;
+
+private:
+    // Decoder pool
+    QAtomicInt &abort;
+    CorrectorPool &correctorPool;
+
+    DropOutCorrect dropOutCorrect;
+};
+
+#endif // CORRECTORTHREAD_H
@@ -24,132 +24,185 @@
 ************************************************************************/
 
 #include "dropoutcorrect.h"
-#include "correctorpool.h"
 #include "filters.h"
 
-DropOutCorrect::DropOutCorrect(QAtomicInt& _abort, CorrectorPool& _correctorPool, QObject *parent)
-    : QThread(parent), abort(_abort), correctorPool(_correctorPool)
+#include <algorithm>
+
+DropOutCorrect::DropOutCorrect(LineReader _lineReader)
+    : lineReader(_lineReader)
 {
 }
 
-void DropOutCorrect::run()
+// Correct a frame, when only the first source's fields are in memory. Lines
+// from the other sources are read with the line reader as replacements need
+// them, and cached for the rest of the frame.
+//
+// The first source's fields are corrected in place. They're used both as
+// source and target during correction, which is OK because we're careful not
+// to copy data from another dropout. The data is shared with the caller's
+// copy until it's first written to, so fields without dropouts are never
+// copied. The first write copies the whole field, rather than keeping an
+// overlay of the corrected lines: the output is written as whole fields, and a
+// field copy is cheap next to reading it.
+void DropOutCorrect::correctFrame(SourceVideo::Data &firstTargetField, SourceVideo::Data &secondTargetField,
+                                  const QVector<qint32> &firstFieldSeqNo, const QVector<qint32> &secondFieldSeqNo,
+                                  const QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
+                                  const QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
+                                  const QVector<LdDecodeMetaData::VideoParameters> &_videoParameters, bool intraField, bool overCorrect,
+                                  const QVector<qint32> &availableSourcesForFrame, const QVector<qreal> &sourceFrameQuality,
+                                  Statistics &statistics)
 {
-    // Variables for getInputFrame
-    qint32 frameNumber;
-    QVector<qint32> firstFieldSeqNo;
-    QVector<qint32> secondFieldSeqNo;
-    QVector<SourceVideo::Data> firstSourceField;
-    QVector<SourceVideo::Data> secondSourceField;
-    QVector<LdDecodeMetaData::Field> firstFieldMetadata;
-    QVector<LdDecodeMetaData::Field> secondFieldMetadata;
-    bool reverse, intraField, overCorrect;
-    QVector<qint32> availableSourcesForFrame;
-    QVector<qreal> sourceFrameQuality;
+    videoParameters = _videoParameters;
 
-    // Statistics
-    Statistics statistics;
-
-    while(!abort) {
-        // Get the next field to process from the input file
-        if (!correctorPool.getInputFrame(frameNumber, firstFieldSeqNo, firstSourceField, firstFieldMetadata,
-                                       secondFieldSeqNo, secondSourceField, secondFieldMetadata,
-                                       videoParameters, reverse, intraField, overCorrect,
-                                       availableSourcesForFrame, sourceFrameQuality)) {
-            // No more input fields -- exit
-            break;
-        }
+    FieldData firstFieldData;
+    firstFieldData.target = firstTargetField;
+    firstFieldData.seqNo = firstFieldSeqNo;
 
-        // Reset statistics
-        statistics.sameSourceReplacement = 0;
-        statistics.multiSourceReplacement = 0;
-        statistics.totalReplacementDistance = 0;
-
-        qint32 totalAvailableSources = firstFieldSeqNo.size();
-        qDebug().nospace() << "DropOutCorrect::process(): Frame #" << frameNumber << " - There are " << totalAvailableSources << " sources available of which " <<
-                              availableSourcesForFrame.size() << " contain the required frame";
-
-        // Copy the input frames' data to the target frames.
-        // We'll use these both as source and target during correction, which
-        // is OK because we're careful not to copy data from another dropout.
-        QVector<SourceVideo::Data> firstFieldData = firstSourceField;
-        QVector<SourceVideo::Data> secondFieldData = secondSourceField;
-
-        // Check if the frame contains drop-outs
-        if (firstFieldMetadata[0].dropOuts.startx.empty() && secondFieldMetadata[0].dropOuts.startx.empty()) {
-            // No correction required...
-            qDebug() << "DropOutCorrect::process(): Skipping fields [" <<
-                        firstFieldSeqNo[0] << "/" << secondFieldSeqNo[0] << "]";
-        } else {
-            // Perform correction...
-            qDebug().nospace() << "DropOutCorrect::process(): Correcting fields [" <<
-                        firstFieldSeqNo[0] << "/" << secondFieldSeqNo[0] << "] containing " <<
-                        firstFieldMetadata[0].dropOuts.startx.size() + secondFieldMetadata[0].dropOuts.startx.size() <<
-                        " drop-outs";
-
-            // Analyse the drop out locations in the first field
-            QVector<QVector<DropOutLocation>> firstFieldDropouts(totalAvailableSources);
-            for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
-                qint32 currentSource = availableSourcesForFrame[i];
-                if (firstFieldMetadata[currentSource].dropOuts.startx.size() > 0)
-                    firstFieldDropouts[currentSource] = setDropOutLocations(populateDropoutsVector(firstFieldMetadata[currentSource], overCorrect));
-            }
+    FieldData secondFieldData;
+    secondFieldData.target = secondTargetField;
+    secondFieldData.seqNo = secondFieldSeqNo;
 
-            // Analyse the drop out locations in the second field
-            QVector<QVector<DropOutLocation>> secondFieldDropouts(totalAvailableSources);
-            for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
-                qint32 currentSource = availableSourcesForFrame[i];
-                if (secondFieldMetadata[currentSource].dropOuts.startx.size() > 0)
-                    secondFieldDropouts[currentSource] = setDropOutLocations(populateDropoutsVector(secondFieldMetadata[currentSource], overCorrect));
-            }
+    correctFields(firstFieldData, secondFieldData, firstFieldMetadata, secondFieldMetadata,
+                  intraField, overCorrect, availableSourcesForFrame, sourceFrameQuality, statistics);
 
-            // Correct the first field
-            correctField(firstFieldDropouts, secondFieldDropouts, firstFieldData, secondFieldData, true, intraField, availableSourcesForFrame, sourceFrameQuality,
-                         statistics);
+    firstTargetField = firstFieldData.target;
+    secondTargetField = secondFieldData.target;
+}
 
-            // Correct the second field
-            correctField(secondFieldDropouts, firstFieldDropouts, secondFieldData, firstFieldData, false, intraField, availableSourcesForFrame, sourceFrameQuality,
-                         statistics);
-        }
+// Correct a frame, when the fields of all the sources are already in memory
+// (this is used by ld-diffdod's combined mode).
+// The fields, metadata and field numbers are indexed by source number; the
+// first source's fields are corrected in place.
+void DropOutCorrect::correctFrame(QVector<SourceVideo::Data> &firstFields, QVector<SourceVideo::Data> &secondFields,
+                                  const QVector<qint32> &firstFieldSeqNo, const QVector<qint32> &secondFieldSeqNo,
+                                  const QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
+                                  const QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
+                                  const LdDecodeMetaData::VideoParameters &_videoParameters, bool intraField, bool overCorrect,
+                                  const QVector<qint32> &availableSourcesForFrame, Statistics &statistics)
+{
+    qint32 numberOfSources = firstFields.size();
+    videoParameters.fill(_videoParameters, numberOfSources);
+
+    // Determine the frame quality (currently this is based on frame average black SNR)
+    QVector<qreal> sourceFrameQuality(numberOfSources, -1);
+    for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
+        qint32 currentSource = availableSourcesForFrame[i];
+        sourceFrameQuality[currentSource] = (firstFieldMetadata[currentSource].vitsMetrics.bPSNR +
+                                             secondFieldMetadata[currentSource].vitsMetrics.bPSNR) / 2.0;
+    }
+
+    FieldData firstFieldData;
+    firstFieldData.target = firstFields[0];
+    firstFieldData.seqNo = firstFieldSeqNo;
+    firstFieldData.sources = firstFields;
+
+    FieldData secondFieldData;
+    secondFieldData.target = secondFields[0];
+    secondFieldData.seqNo = secondFieldSeqNo;
+    secondFieldData.sources = secondFields;
+
+    correctFields(firstFieldData, secondFieldData, firstFieldMetadata, secondFieldMetadata,
+                  intraField, overCorrect, availableSourcesForFrame, sourceFrameQuality, statistics);
 
-        // Return the processed fields
-        correctorPool.setOutputFrame(frameNumber, firstFieldData[0], secondFieldData[0], firstFieldSeqNo[0], secondFieldSeqNo[0],
-                statistics.sameSourceReplacement, statistics.multiSourceReplacement, statistics.totalReplacementDistance);
+    firstFields[0] = firstFieldData.target;
+    secondFields[0] = secondFieldData.target;
+}
+
+// Correct the dropouts in both fields of the first source's frame
+void DropOutCorrect::correctFields(FieldData &firstFieldData, FieldData &secondFieldData,
+                                   const QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
+                                   const QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
+                                   bool intraField, bool overCorrect, const QVector<qint32> &availableSourcesForFrame,
+                                   const QVector<qreal> &sourceFrameQuality, Statistics &statistics)
+{
+    // Reset statistics
+    statistics.sameSourceReplacement = 0;
+    statistics.multiSourceReplacement = 0;
+    statistics.totalReplacementDistance = 0;
+
+    qint32 totalAvailableSources = firstFieldData.seqNo.size();
+
+    // Check if the frame contains drop-outs
+    if (firstFieldMetadata[0].dropOuts.startx.empty() && secondFieldMetadata[0].dropOuts.startx.empty()) {
+        // No correction required...
+        qDebug() << "DropOutCorrect::process(): Skipping fields [" <<
+                    firstFieldData.seqNo[0] << "/" << secondFieldData.seqNo[0] << "]";
+        return;
+    }
+
+    // Perform correction...
+    qDebug().nospace() << "DropOutCorrect::process(): Correcting fields [" <<
+                firstFieldData.seqNo[0] << "/" << secondFieldData.seqNo[0] << "] containing " <<
+                firstFieldMetadata[0].dropOuts.startx.size() + secondFieldMetadata[0].dropOuts.startx.size() <<
+                " drop-outs";
+
+    // Analyse the drop out locations in the first field
+    QVector<QVector<DropOutLocation>> firstFieldDropouts(totalAvailableSources);
+    for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
+        qint32 currentSource = availableSourcesForFrame[i];
+        if (firstFieldMetadata[currentSource].dropOuts.startx.size() > 0)
+            firstFieldDropouts[currentSource] = setDropOutLocations(populateDropoutsVector(firstFieldMetadata[currentSource], overCorrect));
+    }
+
+    // Analyse the drop out locations in the second field
+    QVector<QVector<DropOutLocation>> secondFieldDropouts(totalAvailableSources);
+    for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
+        qint32 currentSource = availableSourcesForFrame[i];
+        if (secondFieldMetadata[currentSource].dropOuts.startx.size() > 0)
+            secondFieldDropouts[currentSource] = setDropOutLocations(populateDropoutsVector(secondFieldMetadata[currentSource], overCorrect));
+    }
+
+    // Index the drop outs of both fields by line, for finding replacement lines
+    QVector<DropOutIndex> firstFieldIndex(totalAvailableSources);
+    QVector<DropOutIndex> secondFieldIndex(totalAvailableSources);
+    for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
+        qint32 currentSource = availableSourcesForFrame[i];
+        firstFieldIndex[currentSource].build(firstFieldDropouts[currentSource], videoParameters[0].fieldHeight);
+        secondFieldIndex[currentSource].build(secondFieldDropouts[currentSource], videoParameters[0].fieldHeight);
     }
+
+    // Correct the first field
+    correctField(firstFieldDropouts[0], firstFieldIndex, secondFieldIndex, firstFieldData, secondFieldData, true, intraField,
+                 availableSourcesForFrame, sourceFrameQuality, statistics);
+
+    // Correct the second field
+    correctField(secondFieldDropouts[0], secondFieldIndex, firstFieldIndex, secondFieldData, firstFieldData, false, intraField,
+                 availableSourcesForFrame, sourceFrameQuality, statistics);
 }
 
 // Correct dropouts within one field
-void DropOutCorrect::correctField(const QVector<QVector<DropOutLocation>> &thisFieldDropouts,
-                                  const QVector<QVector<DropOutLocation>> &otherFieldDropouts,
-                                  QVector<SourceVideo::Data> &thisFieldData, const QVector<SourceVideo::Data> &otherFieldData,
+void DropOutCorrect::correctField(const QVector<DropOutLocation> &thisFieldDropouts,
+                                  const QVector<DropOutIndex> &thisFieldIndex, const QVector<DropOutIndex> &otherFieldIndex,
+                                  FieldData &thisFieldData, FieldData &otherFieldData,
                                   bool thisFieldIsFirst, bool intraField, const QVector<qint32> &availableSourcesForFrame,
                                   const QVector<qreal> &sourceFrameQuality, Statistics &statistics)
 {
-    for (qint32 dropoutIndex = 0; dropoutIndex < thisFieldDropouts[0].size(); dropoutIndex++) {
+    for (qint32 dropoutIndex = 0; dropoutIndex < thisFieldDropouts.size(); dropoutIndex++) {
         Replacement replacement, chromaReplacement;
 
         // Is the current dropout in the colour burst?
-        if (thisFieldDropouts[0][dropoutIndex].location == Location::colourBurst) {
-            replacement = findReplacementLine(thisFieldDropouts, otherFieldDropouts,
+        if (thisFieldDropouts[dropoutIndex].location == Location::colourBurst) {
+            replacement = findReplacementLine(thisFieldDropouts, thisFieldIndex, otherFieldIndex,
                                               dropoutIndex, thisFieldIsFirst, true,
                                               true, intraField, availableSourcesForFrame,
                                               sourceFrameQuality);
         }
 
         // Is the current dropout in the visible video line?
-        if (thisFieldDropouts[0][dropoutIndex].location == Location::visibleLine) {
+        if (thisFieldDropouts[dropoutIndex].location == Location::visibleLine) {
             // Find separate replacements for luma and chroma
-            replacement = findReplacementLine(thisFieldDropouts, otherFieldDropouts,
+            replacement = findReplacementLine(thisFieldDropouts, thisFieldIndex, otherFieldIndex,
                                               dropoutIndex, thisFieldIsFirst, false,
                                               false, intraField, availableSourcesForFrame,
                                               sourceFrameQuality);
-            chromaReplacement = findReplacementLine(thisFieldDropouts, otherFieldDropouts,
+            chromaReplacement = findReplacementLine(thisFieldDropouts, thisFieldIndex, otherFieldIndex,
                                                     dropoutIndex, thisFieldIsFirst, true,
                                                     false, intraField, availableSourcesForFrame,
                                                     sourceFrameQuality);
         }
 
         // Correct the data
-        correctDropOut(thisFieldDropouts[0][dropoutIndex], replacement, chromaReplacement, thisFieldData, otherFieldData, statistics);
+        correctDropOut(thisFieldDropouts[dropoutIndex], replacement, chromaReplacement, thisFieldData, otherFieldData, statistics);
     }
 }
 
@@ -251,8 +304,9 @@ QVector<DropOutCorrect::DropOutLocation> DropOutCorrect::setDropOutLocations(QVe
 // Find a replacement line to take replacement data from.  This method looks both up and down the field
 // for the nearest replacement line that doesn't contain a drop-out itself (to prevent copying bad data
 // over bad data).
-DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QVector<DropOutLocation>> &thisFieldDropouts,
-                                                                const QVector<QVector<DropOutLocation>> &otherFieldDropouts,
+DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<DropOutLocation> &thisFieldDropouts,
+                                                                const QVector<DropOutIndex> &thisFieldIndex,
+                                                                const QVector<DropOutIndex> &otherFieldIndex,
                                                                 qint32 dropOutIndex, bool thisFieldIsFirst, bool matchChromaPhase,
                                                                 bool isColourBurst, bool intraField,
                                                                 const QVector<qint32> &availableSourcesForFrame,
@@ -319,13 +373,13 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
 
         // Look up the field for a replacement
         findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                     thisFieldDropouts, true, 0, -stepAmount,
+                                     thisFieldIndex, true, 0, -stepAmount,
                                      currentSource, sourceFrameQuality,
                                      candidates);
 
         // Look down the field for a replacement
         findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                     thisFieldDropouts, true, stepAmount, stepAmount,
+                                     thisFieldIndex, true, stepAmount, stepAmount,
                                      currentSource, sourceFrameQuality,
                                      candidates);
 
@@ -335,20 +389,20 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
 
             // Look up the field for a replacement
             findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                         otherFieldDropouts, false, otherFieldOffset, -stepAmount,
+                                         otherFieldIndex, false, otherFieldOffset, -stepAmount,
                                          currentSource, sourceFrameQuality,
                                          candidates);
 
             // Look down the field for a replacement
             findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                         otherFieldDropouts, false, otherFieldOffset + stepAmount, stepAmount,
+                                         otherFieldIndex, false, otherFieldOffset + stepAmount, stepAmount,
                                          currentSource, sourceFrameQuality,
                                          candidates);
         }
     }
 
     qDebug() << (isColourBurst ? "Colourburst" : "Visible video") << "dropout on line"
-             << thisFieldDropouts[0][dropOutIndex].fieldLine << "of" << (thisFieldIsFirst ? "first" : "second") << "field";
+             << thisFieldDropouts[dropOutIndex].fieldLine << "of" << (thisFieldIsFirst ? "first" : "second") << "field";
 
     // If no candidate is found, return no replacement
     Replacement replacement;
@@ -363,13 +417,13 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
         for (const Replacement &candidate: candidates) {
             // Work out the corresponding output frame line numbers.
             // The first field (in a .tbc, for both PAL and NTSC) contains the top frame line.
-            const qint32 dropoutFrameLine = (2 * thisFieldDropouts[0][dropOutIndex].fieldLine) + (thisFieldIsFirst ? 0 : 1);
+            const qint32 dropoutFrameLine = (2 * thisFieldDropouts[dropOutIndex].fieldLine) + (thisFieldIsFirst ? 0 : 1);
             const qint32 sourceFrameLine = (2 * candidate.fieldLine) + (candidate.isSameField ? (thisFieldIsFirst ? 0 : 1)
                                                                                               : (thisFieldIsFirst ? 1 : 0));
 
             const qint32 distance = qAbs(dropoutFrameLine - sourceFrameLine);
             qDebug() << (candidate.isSameField ? "This" : "Other") << "field replacement candidate for line" <<
-                        thisFieldDropouts[0][dropOutIndex].fieldLine << "is line" <<
+                        thisFieldDropouts[dropOutIndex].fieldLine << "is line" <<
                         candidate.fieldLine << "distance" << distance << "of source" << candidate.sourceNumber <<
                         "with a quality of" << candidate.quality;
 
@@ -393,7 +447,7 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
                     replacement.fieldLine << "of source" << replacement.sourceNumber << (matchChromaPhase ? "(chroma phase matched)" : "(whole signal)") <<
                     "with a quality of" << replacement.quality;
     } else {
-        qDebug() << "No viable replacement selected for" << thisFieldDropouts[0][dropOutIndex].fieldLine;
+        qDebug() << "No viable replacement selected for" << thisFieldDropouts[dropOutIndex].fieldLine;
     }
 
 
@@ -402,14 +456,14 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
 
 // Given a dropout, scan through a source field for the nearest replacement line that doesn't have overlapping dropouts.
 // Adds a Replacement to candidates if one was found.
-void DropOutCorrect::findPotentialReplacementLine(const QVector<QVector<DropOutLocation>> &targetDropouts, qint32 targetIndex,
-                                                  const QVector<QVector<DropOutLocation>> &sourceDropouts, bool isSameField,
+void DropOutCorrect::findPotentialReplacementLine(const QVector<DropOutLocation> &targetDropouts, qint32 targetIndex,
+                                                  const QVector<DropOutIndex> &sourceIndex, bool isSameField,
                                                   qint32 sourceOffset, qint32 stepAmount,
                                                   qint32 sourceNo, const QVector<qreal> &sourceFrameQuality,
                                                   QVector<Replacement> &candidates)
 {    
     // Calculate the start source line (which is the same line as the dropout unless the source number is 0
-    qint32 sourceLine = targetDropouts[0][targetIndex].fieldLine;
+    qint32 sourceLine = targetDropouts[targetIndex].fieldLine;
     if (sourceNo == 0) sourceLine += sourceOffset;
 
     // Is the line within the active range?
@@ -421,18 +475,10 @@ void DropOutCorrect::findPotentialReplacementLine(const QVector<QVector<DropOutL
     // Hunt for a replacement
     while (sourceLine >= videoParameters[sourceNo].firstActiveFieldLine && sourceLine < videoParameters[sourceNo].lastActiveFieldLine) {
         // Is there a dropout that overlaps the one we're trying to replace?
-        bool hasOverlap = false;
-        for (qint32 sourceIndex = 0; sourceIndex < sourceDropouts[sourceNo].size(); sourceIndex++) {
-            if (sourceDropouts[sourceNo][sourceIndex].fieldLine == sourceLine &&
-                (targetDropouts[0][targetIndex].endx - sourceDropouts[sourceNo][sourceIndex].startx) >= 0 &&
-                (sourceDropouts[sourceNo][sourceIndex].endx - targetDropouts[0][targetIndex].startx) >= 0) {
-                // Overlap -- can't use this line
-                sourceLine += stepAmount;
-                hasOverlap = true;
-                break;
-            }
-        }
-        if (!hasOverlap) {
+        if (sourceIndex[sourceNo].overlaps(sourceLine, targetDropouts[targetIndex].startx, targetDropouts[targetIndex].endx)) {
+            // Overlap -- can't use this line
+            sourceLine += stepAmount;
+        } else {
             // No overlaps -- we can use this line
             Replacement replacement;
             replacement.isSameField = isSameField;
@@ -453,7 +499,7 @@ void DropOutCorrect::findPotentialReplacementLine(const QVector<QVector<DropOutL
 // Correct a dropout by copying data from a replacement line.
 void DropOutCorrect::correctDropOut(const DropOutLocation &dropOut,
                                     const Replacement &replacement, const Replacement &chromaReplacement,
-                                    QVector<SourceVideo::Data> &thisFieldData, const QVector<SourceVideo::Data> &otherFieldData,
+                                    FieldData &thisFieldData, FieldData &otherFieldData,
                                     Statistics &statistics)
 {
     if (replacement.fieldLine == -1) {
@@ -461,10 +507,10 @@ void DropOutCorrect::correctDropOut(const DropOutLocation &dropOut,
         return;
     }
 
-    const quint16 *sourceLine = (replacement.isSameField ? thisFieldData[replacement.sourceNumber].data()
-                                                         : otherFieldData[replacement.sourceNumber].data())
-                                + ((replacement.fieldLine - 1) * videoParameters[0].fieldWidth);
-    quint16 *targetLine = thisFieldData[0].data() + ((dropOut.fieldLine - 1) * videoParameters[0].fieldWidth);
+    // Get the target line first, as writing to the target field may detach it from the source data
+    quint16 *targetLine = thisFieldData.target.data() + ((dropOut.fieldLine - 1) * videoParameters[0].fieldWidth);
+    const quint16 *sourceLine = getReplacementLine(replacement.sourceNumber, replacement.fieldLine,
+                                                   replacement.isSameField ? thisFieldData : otherFieldData);
 
     // Choose whole signal or just chroma replacement
     // Don't use chroma if the source of the replacement is > 0 and coming from the same line in another source
@@ -502,9 +548,8 @@ void DropOutCorrect::correctDropOut(const DropOutLocation &dropOut,
         }
 
         // Extract HF from chromaReplacement (by extracting LF, then subtracting from the original)
-        const quint16 *chromaLine = (chromaReplacement.isSameField ? thisFieldData[replacement.sourceNumber].data()
-                                                                   : otherFieldData[replacement.sourceNumber].data())
-                                    + ((chromaReplacement.fieldLine - 1) * videoParameters[0].fieldWidth);
+        const quint16 *chromaLine = getReplacementLine(replacement.sourceNumber, chromaReplacement.fieldLine,
+                                                       chromaReplacement.isSameField ? thisFieldData : otherFieldData);
         for (qint32 pixel = 0; pixel < videoParameters[0].fieldWidth; pixel++) {
             lineBuf[pixel] = chromaLine[pixel];
         }
@@ -519,3 +564,67 @@ void DropOutCorrect::correctDropOut(const DropOutLocation &dropOut,
     else statistics.multiSourceReplacement++;
     statistics.totalReplacementDistance += replacement.distance;
 }
+
+// Get a pointer to a replacement line from one of the sources.
+// Lines from the first source come from the (partially corrected) target field;
+// lines from other sources come from their fields if they're in memory, or are
+// read with the line reader the first time they're used.
+const quint16 *DropOutCorrect::getReplacementLine(qint32 sourceNo, qint32 fieldLine, FieldData &fieldData)
+{
+    if (sourceNo == 0) {
+        return fieldData.target.constData() + ((fieldLine - 1) * videoParameters[0].fieldWidth);
+    }
+
+    if (sourceNo < fieldData.sources.size() && !fieldData.sources[sourceNo].isEmpty()) {
+        return fieldData.sources[sourceNo].constData() + ((fieldLine - 1) * videoParameters[0].fieldWidth);
+    }
+
+    const QPair<qint32, qint32> key(sourceNo, fieldLine);
+    if (!fieldData.sourceLines.contains(key)) {
+        fieldData.sourceLines.insert(key, lineReader(sourceNo, fieldData.seqNo[sourceNo], fieldLine));
+    }
+
+    return fieldData.sourceLines[key].constData();
+}
+
+// Build the index from a list of drop outs in a field
+void DropOutCorrect::DropOutIndex::build(const QVector<DropOutLocation> &dropOuts, qint32 fieldHeight)
+{
+    lines.clear();
+    lines.resize(fieldHeight + 1);
+
+    for (const DropOutLocation &dropOut : dropOuts) {
+        if (dropOut.fieldLine < 0 || dropOut.fieldLine > fieldHeight) continue;
+        lines[dropOut.fieldLine].append({dropOut.startx, dropOut.endx});
+    }
+
+    // Sort the ranges on each line, and merge any that overlap
+    for (QVector<Range> &ranges : lines) {
+        if (ranges.size() < 2) continue;
+
+        std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) { return a.startx < b.startx; });
+
+        qint32 merged = 0;
+        for (qint32 i = 1; i < ranges.size(); i++) {
+            if (ranges[i].startx <= ranges[merged].endx) {
+                ranges[merged].endx = qMax(ranges[merged].endx, ranges[i].endx);
+            } else {
+                ranges[++merged] = ranges[i];
+            }
+        }
+        ranges.resize(merged + 1);
+    }
+}
+
+// Return true if any drop out on the field line overlaps the range startx to endx (inclusive)
+bool DropOutCorrect::DropOutIndex::overlaps(qint32 fieldLine, qint32 startx, qint32 endx) const
+{
+    if (fieldLine < 0 || fieldLine >= lines.size()) return false;
+
+    // The ranges don't overlap, so their ends are sorted too; find the first one ending at or after startx
+    const QVector<Range> &ranges = lines[fieldLine];
+    auto it = std::lower_bound(ranges.begin(), ranges.end(), startx,
+                               [](const Range &range, qint32 x) { return range.endx < x; });
+
+    return it != ranges.end() && it->startx <= endx;
+}
@@ -25,25 +25,45 @@
 #ifndef DROPOUTCORRECT_H
 #define DROPOUTCORRECT_H
 
-#include <QObject>
-#include <QElapsedTimer>
-#include <QAtomicInt>
-#include <QThread>
+#include <QHash>
+#include <QPair>
 #include <QDebug>
+#include <functional>
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
 
-class CorrectorPool;
-
-class DropOutCorrect : public QThread
+// Dropout correction for one frame at a time. This is used by ld-dropout-correct's
+// worker threads (CorrectorThread), and by ld-diffdod's combined mode.
+class DropOutCorrect
 {
-    Q_OBJECT
 public:
-    explicit DropOutCorrect(QAtomicInt& _abort, CorrectorPool& _correctorPool, QObject *parent = nullptr);
+    // Reads a single line of a field from one of the sources, for sources whose
+    // fields aren't already in memory
+    using LineReader = std::function<SourceVideo::Data(qint32 sourceNo, qint32 fieldNumber, qint32 fieldLine)>;
+
+    explicit DropOutCorrect(LineReader _lineReader = LineReader());
+
+    // Statistics
+    struct Statistics {
+        qint32 sameSourceReplacement;
+        qint32 multiSourceReplacement;
+        qint32 totalReplacementDistance;
+    };
 
-protected:
-    void run() override;
+    void correctFrame(SourceVideo::Data &firstTargetField, SourceVideo::Data &secondTargetField,
+                      const QVector<qint32> &firstFieldSeqNo, const QVector<qint32> &secondFieldSeqNo,
+                      const QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
+                      const QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
+                      const QVector<LdDecodeMetaData::VideoParameters> &_videoParameters, bool intraField, bool overCorrect,
+                      const QVector<qint32> &availableSourcesForFrame, const QVector<qreal> &sourceFrameQuality,
+                      Statistics &statistics);
+    void correctFrame(QVector<SourceVideo::Data> &firstFields, QVector<SourceVideo::Data> &secondFields,
+                      const QVector<qint32> &firstFieldSeqNo, const QVector<qint32> &secondFieldSeqNo,
+                      const QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
+                      const QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
+                      const LdDecodeMetaData::VideoParameters &_videoParameters, bool intraField, bool overCorrect,
+                      const QVector<qint32> &availableSourcesForFrame, Statistics &statistics);
 
 private:
     enum Location {
@@ -59,6 +79,23 @@ private:
         Location location;
     };
 
+    // The dropouts in one field of one source, indexed by field line. The dropouts
+    // on each line are merged into a sorted list of non-overlapping ranges, so
+    // checking whether a line is usable as a replacement is a binary search.
+    class DropOutIndex {
+    public:
+        void build(const QVector<DropOutLocation> &dropOuts, qint32 fieldHeight);
+        bool overlaps(qint32 fieldLine, qint32 startx, qint32 endx) const;
+
+    private:
+        struct Range {
+            qint32 startx;
+            qint32 endx;
+        };
+
+        QVector<QVector<Range>> lines;
+    };
+
     struct Replacement {
         // The default value is no replacement
         Replacement() : isSameField(true), fieldLine(-1) {}
@@ -72,40 +109,49 @@ private:
         qint32 distance;
     };
 
-    // Statistics
-    struct Statistics {
-        qint32 sameSourceReplacement;
-        qint32 multiSourceReplacement;
-        qint32 totalReplacementDistance;
+    // The video data for one field of the frame being corrected. Only the target
+    // field (from source 0) is loaded in full; lines from the other sources are
+    // read on demand when a replacement actually needs them (unless the whole
+    // fields are already in memory, in which case they're in sources).
+    struct FieldData {
+        SourceVideo::Data target;
+        QVector<qint32> seqNo;
+        QVector<SourceVideo::Data> sources;
+        QHash<QPair<qint32, qint32>, SourceVideo::Data> sourceLines;
     };
 
-    // Decoder pool
-    QAtomicInt& abort;
-    CorrectorPool& correctorPool;
+    // Source of lines that aren't in memory (empty if all the fields are)
+    LineReader lineReader;
 
     QVector<LdDecodeMetaData::VideoParameters> videoParameters;
 
-    void correctField(const QVector<QVector<DropOutLocation> > &thisFieldDropouts,
-                      const QVector<QVector<DropOutLocation> > &otherFieldDropouts,
-                      QVector<SourceVideo::Data> &thisFieldData, const QVector<SourceVideo::Data> &otherFieldData,
+    void correctFields(FieldData &firstFieldData, FieldData &secondFieldData,
+                       const QVector<LdDecodeMetaData::Field> &firstFieldMetadata,
+                       const QVector<LdDecodeMetaData::Field> &secondFieldMetadata,
+                       bool intraField, bool overCorrect, const QVector<qint32> &availableSourcesForFrame,
+                       const QVector<qreal> &sourceFrameQuality, Statistics &statistics);
+    void correctField(const QVector<DropOutLocation> &thisFieldDropouts,
+                      const QVector<DropOutIndex> &thisFieldIndex, const QVector<DropOutIndex> &otherFieldIndex,
+                      FieldData &thisFieldData, FieldData &otherFieldData,
                       bool thisFieldIsFirst, bool intraField, const QVector<qint32> &availableSourcesForFrame,
                       const QVector<qreal> &sourceFrameQuality, Statistics &statistics);
     QVector<DropOutLocation> populateDropoutsVector(LdDecodeMetaData::Field field, bool overCorrect);
     QVector<DropOutLocation> setDropOutLocations(QVector<DropOutLocation> dropOuts);
-    Replacement findReplacementLine(const QVector<QVector<DropOutLocation>> &thisFieldDropouts,
-                                    const QVector<QVector<DropOutLocation>> &otherFieldDropouts,
+    Replacement findReplacementLine(const QVector<DropOutLocation> &thisFieldDropouts,
+                                    const QVector<DropOutIndex> &thisFieldIndex, const QVector<DropOutIndex> &otherFieldIndex,
                                     qint32 dropOutIndex, bool thisFieldIsFirst, bool matchChromaPhase,
                                     bool isColourBurst, bool intraField, const QVector<qint32> &availableSourcesForFrame,
                                     const QVector<qreal> &sourceFrameQuality);
-    void findPotentialReplacementLine(const QVector<QVector<DropOutLocation>> &targetDropouts, qint32 targetIndex,
-                                      const QVector<QVector<DropOutLocation>> &sourceDropouts, bool isSameField,
+    void findPotentialReplacementLine(const QVector<DropOutLocation> &targetDropouts, qint32 targetIndex,
+                                      const QVector<DropOutIndex> &sourceIndex, bool isSameField,
                                       qint32 sourceOffset, qint32 stepAmount,
                                       qint32 sourceNo, const QVector<qreal> &sourceFrameQuality,
                                       QVector<Replacement> &candidates);
     void correctDropOut(const DropOutLocation &dropOut,
                         const Replacement &replacement, const Replacement &chromaReplacement,
-                        QVector<SourceVideo::Data> &thisFieldData, const QVector<SourceVideo::Data> &otherFieldData,
+                        FieldData &thisFieldData, FieldData &otherFieldData,
                         Statistics &statistics);
+    const quint16 *getReplacementLine(qint32 sourceNo, qint32 fieldLine, FieldData &fieldData);
 };
 
 #endif // DROPOUTCORRECT_H
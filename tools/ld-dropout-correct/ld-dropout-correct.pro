@@ -16,22 +16,32 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
     correctorpool.cpp \
+    correctorthread.cpp \
     main.cpp \
     dropoutcorrect.cpp \
     ../library/tbc/filters.cpp \
+    ../library/tbc/checkpoint.cpp \
     ../library/tbc/lddecodemetadata.cpp \
+    ../library/tbc/poolstatistics.cpp \
     ../library/tbc/sourcevideo.cpp \
     ../library/tbc/vbidecoder.cpp \
+    ../library/tbc/sidecarcache.cpp \
+    ../library/tbc/vbiframeindex.cpp \
     ../library/tbc/logging.cpp
 
 HEADERS += \
     correctorpool.h \
+    correctorthread.h \
     dropoutcorrect.h \
     ../library/filter/firfilter.h \
     ../library/tbc/filters.h \
+    ../library/tbc/checkpoint.h \
     ../library/tbc/lddecodemetadata.h \
+    ../library/tbc/poolstatistics.h \
     ../library/tbc/sourcevideo.h \
     ../library/tbc/vbidecoder.h \
+    ../library/tbc/sidecarcache.h \
+    ../library/tbc/vbiframeindex.h \
     ../library/tbc/logging.h
 
 # Add external includes to the include path
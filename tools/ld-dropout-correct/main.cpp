@@ -28,7 +28,9 @@
 #include <QCommandLineParser>
 #include <QThread>
 
+#include "checkpoint.h"
 #include "logging.h"
+#include "poolstatistics.h"
 #include "correctorpool.h"
 
 int main(int argc, char *argv[])
@@ -58,6 +60,9 @@ int main(int argc, char *argv[])
     // Add the standard debug options --debug and --quiet
     addStandardDebugOptions(parser);
 
+    // Add the standard statistics options --stats and --stats-json
+    addStandardStatisticsOptions(parser);
+
     // Option to specify a different JSON input file
     QCommandLineOption inputJsonOption(QStringList() << "input-json",
                                        QCoreApplication::translate("main", "Specify the input JSON file for the first input file (default input.json)"),
@@ -92,6 +97,12 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number"));
     parser.addOption(threadsOption);
 
+    // Option to resume an interrupted run from its checkpoint
+    QCommandLineOption resumeOption(QStringList() << "resume",
+                                    QCoreApplication::translate(
+                                        "main", "Resume an interrupted run, continuing the output file from its last checkpoint"));
+    parser.addOption(resumeOption);
+
     // Positional argument to specify input video file
     parser.addPositionalArgument("inputs", QCoreApplication::translate(
                                      "main", "Specify input TBC files (- as first source for piped input)"));
@@ -188,8 +199,16 @@ int main(int argc, char *argv[])
         }
     }
 
-    // Check that the output file does not already exist
-    if (outputFilename != "-") {
+    // Resuming needs to reopen the output and seek in the first input
+    const bool resume = parser.isSet(resumeOption);
+    if (resume && (inputFilenames[0] == "-" || outputFilename == "-")) {
+        // Quit with error
+        qCritical("Cannot resume with piped input or output");
+        return -1;
+    }
+
+    // Check that the output file does not already exist (unless we're resuming)
+    if (outputFilename != "-" && !resume) {
         QFileInfo outputFileInfo(outputFilename);
         if (outputFileInfo.exists()) {
             // Quit with error
@@ -210,7 +229,9 @@ int main(int argc, char *argv[])
     // Open the source video metadata
     qDebug() << "main(): Opening source video metadata files..";
     QVector<LdDecodeMetaData *> ldDecodeMetaData;
+    QVector<QString> inputJsonFilenames;
     ldDecodeMetaData.resize(totalNumberOfInputFiles);
+    inputJsonFilenames.resize(totalNumberOfInputFiles);
     for (qint32 i = 0; i < totalNumberOfInputFiles; i++) {
         // Create an object for the source video
         ldDecodeMetaData[i] = new LdDecodeMetaData;
@@ -220,6 +241,7 @@ int main(int argc, char *argv[])
         // Work out the metadata filename
         QString jsonFilename = inputFilenames[i] + ".json";
         if (parser.isSet(inputJsonOption) && i == 0) jsonFilename = parser.value(inputJsonOption);
+        inputJsonFilenames[i] = jsonFilename;
         qInfo().nospace().noquote() << "Reading input #" << i << " JSON metadata from " << jsonFilename;
 
         // Open it
@@ -262,7 +284,8 @@ int main(int argc, char *argv[])
                     " - input filename is " << inputFilenames[i];
 
         // Open the source TBC
-        if (!sourceVideos[i]->open(inputFilenames[i], videoParameters.fieldWidth * videoParameters.fieldHeight)) {
+        if (!sourceVideos[i]->open(inputFilenames[i], videoParameters.fieldWidth * videoParameters.fieldHeight,
+                                   videoParameters.fieldWidth)) {
             // Could not open source video file
             qInfo() << "Unable to open input source" << i;
             qInfo() << "Please verify that the specified source video files exist with the correct file permissions";
@@ -304,9 +327,17 @@ int main(int argc, char *argv[])
     qInfo() << "Initial source checks are ok and sources are loaded";
     qint32 result = 0;
     CorrectorPool correctorPool(outputFilename, outputJsonFilename, maxThreads,
-                                ldDecodeMetaData, sourceVideos,
+                                ldDecodeMetaData, sourceVideos, inputJsonFilenames,
                                 reverse, intraField, overCorrect);
-    if (!correctorPool.process()) result = 1;
+    if (outputFilename != "-") {
+        // Only options that affect the output need to match between runs
+        const QList<QCommandLineOption> outputOptions {
+            inputJsonOption, outputJsonOption, setReverseOption, setOverCorrectOption, setIntrafieldOption
+        };
+        correctorPool.setCheckpoint(Checkpoint::makeRunKey(parser, outputOptions), resume);
+    }
+    if (!processStandardStatisticsOptions(parser, correctorPool.getStatistics())) result = 1;
+    else if (!correctorPool.process()) result = 1;
 
     // Close open source video files
     for (qint32 i = 0; i < totalNumberOfInputFiles; i++) sourceVideos[i]->close();
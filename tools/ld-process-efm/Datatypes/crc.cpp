@@ -0,0 +1,238 @@
+/************************************************************************
+
+    crc.cpp
+
+    ld-process-efm - EFM data decoder
+    Copyright (C) 2019 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "crc.h"
+
+// The carry-less multiply version of the EDC is only built for x86 compilers
+// that support per-function target attributes; it's selected at runtime if
+// the CPU has PCLMULQDQ
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC_HAVE_CLMUL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+// EDC polynomial (x^32 + x^31 + x^16 + x^15 + x^4 + x^3 + x + 1), normal and bit-reversed
+static const quint32 EDC_POLY = 0x8001801B;
+static const quint32 EDC_POLY_REFLECTED = 0xD8018001;
+
+// Look-up tables for the EDC, generated on first use
+struct EdcTables {
+    // Slicing-by-8 tables; slice[0] is the conventional byte-at-a-time table
+    quint32 slice[8][256];
+
+    // Folding constants for the carry-less multiply version (see edcClmul)
+    quint64 k544, k480, k160, k96;
+
+    EdcTables();
+};
+
+// Compute x^exponent mod P, returned bit-reversed and shifted left by one
+// (the form needed to multiply by a bit-reversed 64-bit value)
+static quint64 edcFoldConstant(qint32 exponent)
+{
+    quint32 remainder = 1;
+    for (qint32 i = 0; i < exponent; i++) {
+        remainder = (remainder << 1) ^ ((remainder & 0x80000000) ? EDC_POLY : 0);
+    }
+
+    quint32 reflected = 0;
+    for (qint32 bit = 0; bit < 32; bit++) {
+        if (remainder & (1U << bit)) reflected |= 1U << (31 - bit);
+    }
+
+    return static_cast<quint64>(reflected) << 1;
+}
+
+EdcTables::EdcTables()
+{
+    for (quint32 i = 0; i < 256; i++) {
+        quint32 edc = i;
+        for (quint32 j = 0; j < 8; j++) {
+            edc = (edc >> 1) ^ ((edc & 1) ? EDC_POLY_REFLECTED : 0);
+        }
+        slice[0][i] = edc;
+    }
+
+    for (qint32 k = 1; k < 8; k++) {
+        for (qint32 i = 0; i < 256; i++) {
+            slice[k][i] = (slice[k - 1][i] >> 8) ^ slice[0][slice[k - 1][i] & 0xFF];
+        }
+    }
+
+    // Constants to fold 128 bits forwards by 512 bits (4 x 128) and by 128 bits
+    k544 = edcFoldConstant(512 + 32);
+    k480 = edcFoldConstant(512 - 32);
+    k160 = edcFoldConstant(128 + 32);
+    k96 = edcFoldConstant(128 - 32);
+}
+
+static const EdcTables &edcTables()
+{
+    static const EdcTables tables;
+    return tables;
+}
+
+// Table-driven EDC, processing 8 bytes per iteration
+static quint32 edcSlicing(const uchar *src, qint32 size, quint32 crc)
+{
+    const EdcTables &tables = edcTables();
+    const quint32 (*slice)[256] = tables.slice;
+
+    while (size >= 8) {
+        const quint32 one = crc ^ (static_cast<quint32>(src[0])
+                                   | (static_cast<quint32>(src[1]) << 8)
+                                   | (static_cast<quint32>(src[2]) << 16)
+                                   | (static_cast<quint32>(src[3]) << 24));
+        const quint32 two = static_cast<quint32>(src[4])
+                            | (static_cast<quint32>(src[5]) << 8)
+                            | (static_cast<quint32>(src[6]) << 16)
+                            | (static_cast<quint32>(src[7]) << 24);
+
+        crc = slice[7][one & 0xFF] ^ slice[6][(one >> 8) & 0xFF]
+              ^ slice[5][(one >> 16) & 0xFF] ^ slice[4][one >> 24]
+              ^ slice[3][two & 0xFF] ^ slice[2][(two >> 8) & 0xFF]
+              ^ slice[1][(two >> 16) & 0xFF] ^ slice[0][two >> 24];
+
+        src += 8;
+        size -= 8;
+    }
+
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ slice[0][(crc ^ *src++) & 0xFF];
+    }
+
+    return crc;
+}
+
+#ifdef CRC_HAVE_CLMUL
+// Multiply both halves of x by the corresponding constant in k, and add the result to next
+__attribute__((target("pclmul,sse2")))
+static inline __m128i edcFold(__m128i x, __m128i k, __m128i next)
+{
+    const __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+    const __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+
+// EDC using carry-less multiplication to fold the buffer down, 64 bytes at a
+// time, to a single 128-bit value with the same remainder. The remainder of
+// that (and any leftover bytes) is then found using the tables.
+__attribute__((target("pclmul,sse2")))
+static quint32 edcClmul(const uchar *src, qint32 size, quint32 crc)
+{
+    if (size < 64) return edcSlicing(src, size, crc);
+
+    const EdcTables &tables = edcTables();
+    const __m128i k512 = _mm_set_epi64x(static_cast<qint64>(tables.k480), static_cast<qint64>(tables.k544));
+    const __m128i k128 = _mm_set_epi64x(static_cast<qint64>(tables.k96), static_cast<qint64>(tables.k160));
+    const __m128i *in = reinterpret_cast<const __m128i *>(src);
+
+    // Starting with a non-zero CRC is equivalent to XORing it into the first 4 bytes
+    __m128i x0 = _mm_xor_si128(_mm_loadu_si128(in), _mm_cvtsi32_si128(static_cast<int>(crc)));
+    __m128i x1 = _mm_loadu_si128(in + 1);
+    __m128i x2 = _mm_loadu_si128(in + 2);
+    __m128i x3 = _mm_loadu_si128(in + 3);
+    in += 4;
+    size -= 64;
+
+    while (size >= 64) {
+        x0 = edcFold(x0, k512, _mm_loadu_si128(in));
+        x1 = edcFold(x1, k512, _mm_loadu_si128(in + 1));
+        x2 = edcFold(x2, k512, _mm_loadu_si128(in + 2));
+        x3 = edcFold(x3, k512, _mm_loadu_si128(in + 3));
+        in += 4;
+        size -= 64;
+    }
+
+    // Combine the four accumulators into one
+    x1 = edcFold(x0, k128, x1);
+    x2 = edcFold(x1, k128, x2);
+    x3 = edcFold(x2, k128, x3);
+
+    while (size >= 16) {
+        x3 = edcFold(x3, k128, _mm_loadu_si128(in));
+        in++;
+        size -= 16;
+    }
+
+    uchar folded[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(folded), x3);
+    crc = edcSlicing(folded, 16, 0);
+
+    return edcSlicing(reinterpret_cast<const uchar *>(in), size, crc);
+}
+#endif
+
+typedef quint32 (*EdcFunction)(const uchar *, qint32, quint32);
+
+// Pick the fastest EDC implementation the CPU supports
+static EdcFunction selectEdcFunction()
+{
+#ifdef CRC_HAVE_CLMUL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul")) return edcClmul;
+#endif
+
+    return edcSlicing;
+}
+
+// Public methods -----------------------------------------------------------------------------------------------------
+
+// CRC code adapted and used under GPLv3 from:
+// https://github.com/claunia/edccchk/blob/master/edccchk.c
+quint32 Crc::edc(const uchar *src, qint32 size, quint32 crc)
+{
+    static const EdcFunction edcFunction = selectEdcFunction();
+
+    return edcFunction(src, size, crc);
+}
+
+// Table-driven CRC16 (XMODEM)
+// Adapted from http://mdfs.net/Info/Comp/Comms/CRC16.htm
+quint16 Crc::crc16(const uchar *src, qint32 size)
+{
+    struct Crc16Table {
+        quint16 entries[256];
+
+        Crc16Table() {
+            for (quint32 i = 0; i < 256; i++) {
+                quint32 crc = i << 8;
+                for (qint32 j = 0; j < 8; j++) {
+                    crc = crc << 1;
+                    if (crc & 0x10000) crc = (crc ^ 0x1021) & 0xFFFF;
+                }
+                entries[i] = static_cast<quint16>(crc);
+            }
+        }
+    };
+    static const Crc16Table table;
+
+    quint16 crc = 0;
+    while (size-- > 0) {
+        crc = static_cast<quint16>((crc << 8) ^ table.entries[((crc >> 8) ^ *src++) & 0xFF]);
+    }
+
+    return crc;
+}
@@ -0,0 +1,42 @@
+/************************************************************************
+
+    crc.h
+
+    ld-process-efm - EFM data decoder
+    Copyright (C) 2019 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <QtGlobal>
+
+// Checksum functions shared by the Section (subcode Q) and Sector (EDC) decoders
+class Crc
+{
+public:
+    // Calculate the CD-ROM EDC (reflected CRC32, polynomial 0x8001801B) of a buffer.
+    // crc is the running value, so a checksum can be calculated over several calls.
+    static quint32 edc(const uchar *src, qint32 size, quint32 crc = 0);
+
+    // Calculate the CRC16 (XMODEM, polynomial 0x1021) used by the subcode Q channel
+    static quint16 crc16(const uchar *src, qint32 size);
+};
+
+#endif // CRC_H
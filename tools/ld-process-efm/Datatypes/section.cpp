@@ -131,10 +131,8 @@ Section::QMetadata Section::getQMetadata()
 bool Section::verifyQ()
 {
     // CRC check the Q-subcode - CRC is on control+mode+data 4+4+72 = 80 bits with 16-bit CRC (96 bits total)
-    char crcSource[10];
-    for (qint32 byteNo = 0; byteNo < 10; byteNo++) crcSource[byteNo] = static_cast<char>(qSubcode[byteNo]);
     quint16 crcChecksum = static_cast<quint16>(~((qSubcode[10] << 8) + qSubcode[11])); // Inverted on disc
-    quint16 calcChecksum = crc16(crcSource, 10);
+    quint16 calcChecksum = Crc::crc16(qSubcode, 10);
 
     // Is the Q subcode valid?
     if (crcChecksum != calcChecksum) {
@@ -145,24 +143,6 @@ bool Section::verifyQ()
     return true;
 }
 
-// Method to perform CRC16 (XMODEM)
-// Adapted from http://mdfs.net/Info/Comp/Comms/CRC16.htm
-quint16 Section::crc16(char *addr, quint16 num)
-{
-    qint32 i;
-    quint32 crc = 0;
-
-    for (; num > 0; num--) {
-        crc = crc ^ static_cast<quint32>(*addr++ << 8);
-        for (i = 0; i < 8; i++) {
-            crc = crc << 1;
-            if (crc & 0x10000) crc = (crc ^ 0x1021) & 0xFFFF;
-        }
-    }
-
-    return static_cast<quint16>(crc);
-}
-
 // Method to decode the Q subcode ADR field
 qint32 Section::decodeQAddress()
 {
@@ -29,6 +29,7 @@
 #include <QDebug>
 
 #include "Datatypes/tracktime.h"
+#include "Datatypes/crc.h"
 
 class Section
 {
@@ -87,7 +88,6 @@ private:
     uchar wSubcode[12];
 
     bool verifyQ();
-    quint16 crc16(char *addr, quint16 num);
     qint32 decodeQAddress();
     void decodeQControl();
     void decodeQDataMode1And4();
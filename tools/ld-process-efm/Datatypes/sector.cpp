@@ -106,7 +106,7 @@ void Sector::setData(QByteArray _sectorData, bool _isValid)
             ((static_cast<quint32>(uF1DataOut[2067])) << 24);
 
         // Perform a CRC32 on bytes 0 to 2063 of the F1 frame
-        if (edcWord != crc32(uF1DataOut, 2064)) {
+        if (edcWord != Crc::edc(uF1DataOut, 2064)) {
             //qDebug() << "Sector::setData(): Initial EDC failed (CRC32 checksum incorrect)";
 
             // Attempt Q and P error correction on sector
@@ -121,7 +121,7 @@ void Sector::setData(QByteArray _sectorData, bool _isValid)
                 ((static_cast<quint32>(uF1DataOut[2067])) << 24);
 
             // Perform EDC again to confirm correction
-            if (edcWord != crc32(uF1DataOut, 2064)) {
+            if (edcWord != Crc::edc(uF1DataOut, 2064)) {
                 qDebug() << "Sector::setData(): Sector contained errors, ECC error correction failed - Sector is corrupt!";
                 valid = false;
                 missingCount++;
@@ -378,16 +378,3 @@ QString Sector::dataToString(QByteArray data)
 
     return output;
 }
-
-// CRC code adapted and used under GPLv3 from:
-// https://github.com/claunia/edccchk/blob/master/edccchk.c
-quint32 Sector::crc32(uchar *src, qint32 size)
-{
-    quint32 crc = 0;
-
-    while(size--) {
-        crc = (crc >> 8) ^ crc32LUT[(crc ^ (*src++)) & 0xFF];
-    }
-
-    return crc;
-}
@@ -42,8 +42,9 @@ QByteArray F1ToAudio::process(QVector<F1Frame> f1FramesIn, bool _padInitialDiscT
     errorTreatment = _errorTreatment;
     concealType = _concealType;
 
-    // Clear the output buffer
+    // Clear the output buffers
     pcmOutputBuffer.clear();
+    errorRanges.clear();
 
     if (f1FramesIn.isEmpty()) return pcmOutputBuffer;
 
@@ -70,6 +71,12 @@ QByteArray F1ToAudio::process(QVector<F1Frame> f1FramesIn, bool _padInitialDiscT
     return pcmOutputBuffer;
 }
 
+// Get method - retrieve the error ranges for the output of the last call to process()
+QVector<F1ToAudio::ErrorRange> F1ToAudio::getErrorRanges()
+{
+    return errorRanges;
+}
+
 // Get method - retrieve statistics
 F1ToAudio::Statistics F1ToAudio::getStatistics()
 {
@@ -97,6 +104,7 @@ void F1ToAudio::reset()
 {
     f1FrameBuffer.clear();
     pcmOutputBuffer.clear();
+    errorRanges.clear();
     waitingForData = false;
     currentState = state_initial;
     nextState = currentState;
@@ -169,16 +177,13 @@ F1ToAudio::StateMachine F1ToAudio::sm_state_processFrame()
             }
 
             // Append the F1 frame data to the PCM output buffer
-            if (padInitialDiscTime) {
-                // Padding to initial disc time
+            if (padInitialDiscTime || gotFirstSample) {
+                // Padding to initial disc time, or only pad after first good sample
+                if (f1FrameBuffer[bufferPosition].isCorrupt()) addErrorRange(ErrorType::silenced, 6);
+                else if (f1FrameBuffer[bufferPosition].isMissing()) addErrorRange(ErrorType::missing, 6);
+
                 pcmOutputBuffer.append(QByteArray(reinterpret_cast<char*>(f1FrameData), 24));
                 statistics.totalSamples += 6;
-            } else {
-                // Only pad after first good sample
-                if (gotFirstSample) {
-                    pcmOutputBuffer.append(QByteArray(reinterpret_cast<char*>(f1FrameData), 24));
-                    statistics.totalSamples += 6;
-                }
             }
 
             statistics.currentTime = f1FrameBuffer[bufferPosition].getDiscTime();
@@ -215,6 +220,7 @@ F1ToAudio::StateMachine F1ToAudio::sm_state_processFrame()
                 if (padInitialDiscTime) {
                     // Append silent frame data to the output buffer
                     for (qint32 j = 0; j < 24; j++) f1FrameData[j] = 0;
+                    addErrorRange(ErrorType::missing, 6);
                     pcmOutputBuffer.append(QByteArray(reinterpret_cast<char*>(f1FrameData), 24));
                     statistics.missingSamples += 6;
                     statistics.totalSamples += 6;
@@ -223,6 +229,7 @@ F1ToAudio::StateMachine F1ToAudio::sm_state_processFrame()
                     if (gotFirstSample) {
                         // Append silent frame data to the output buffer
                         for (qint32 j = 0; j < 24; j++) f1FrameData[j] = 0;
+                        addErrorRange(ErrorType::missing, 6);
                         pcmOutputBuffer.append(QByteArray(reinterpret_cast<char*>(f1FrameData), 24));
                         statistics.missingSamples += 6;
                         statistics.totalSamples += 6;
@@ -352,6 +359,7 @@ void F1ToAudio::linearInterpolationConceal()
             samplePointer++;
         }
         outputSample.setSampleValues(sampleValues);
+        addErrorRange(ErrorType::concealed, 6);
         pcmOutputBuffer.append(QByteArray(reinterpret_cast<char*>(outputSample.getSampleFrame()), 24));
         statistics.concealedSamples += 6;
         statistics.totalSamples += 6;
@@ -421,8 +429,26 @@ void F1ToAudio::predictiveInterpolationConceal()
             samplePointer++;
         }
         outputSample.setSampleValues(sampleValues);
+        addErrorRange(ErrorType::concealed, 6);
         pcmOutputBuffer.append(QByteArray(reinterpret_cast<char*>(outputSample.getSampleFrame()), 24));
         statistics.concealedSamples += 6;
         statistics.totalSamples += 6;
     }
 }
+
+// Record that the next samples appended to the output buffer are an error of the
+// specified type (extending the previous range if it's contiguous and of the same type)
+void F1ToAudio::addErrorRange(ErrorType type, qint32 samples)
+{
+    const qint64 startSample = statistics.totalSamples;
+
+    if (!errorRanges.isEmpty()) {
+        ErrorRange &lastRange = errorRanges.last();
+        if (lastRange.type == type && lastRange.startSample + lastRange.sampleCount == startSample) {
+            lastRange.sampleCount += samples;
+            return;
+        }
+    }
+
+    errorRanges.append({startSample, samples, type});
+}
@@ -49,6 +49,20 @@ public:
         prediction
     };
 
+    // Types of error recorded in the error map
+    enum ErrorType {
+        concealed,
+        silenced,
+        missing
+    };
+
+    // A run of output samples that did not come from good F1 frames
+    struct ErrorRange {
+        qint64 startSample;
+        qint64 sampleCount;
+        ErrorType type;
+    };
+
     struct Statistics {
         qint32 audioSamples;
         qint32 corruptSamples;
@@ -63,6 +77,7 @@ public:
 
     QByteArray process(QVector<F1Frame> f1FramesIn, bool _padInitialDiscTime,
                        ErrorTreatment _errorTreatment, ConcealType _concealType, bool debugState);
+    QVector<ErrorRange> getErrorRanges();
     Statistics getStatistics();
     void reportStatistics();
     void reset();
@@ -83,6 +98,7 @@ private:
     StateMachine currentState;
     StateMachine nextState;
     QByteArray pcmOutputBuffer;
+    QVector<ErrorRange> errorRanges;
     QVector<F1Frame> f1FrameBuffer;
     bool waitingForData;
     ErrorTreatment errorTreatment;
@@ -99,6 +115,8 @@ private:
     StateMachine sm_state_processFrame();
     StateMachine sm_state_findEndOfError();
 
+    void addErrorRange(ErrorType type, qint32 samples);
+
     // Concealment methods
     void linearInterpolationConceal();
     void predictiveInterpolationConceal();
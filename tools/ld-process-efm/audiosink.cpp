@@ -0,0 +1,420 @@
+/************************************************************************
+
+    audiosink.cpp
+
+    ld-process-efm - EFM data decoder
+    Copyright (C) 2019 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "audiosink.h"
+
+#include <QDataStream>
+#include <QFileInfo>
+
+// The audio produced by F1ToAudio is always 44.1kHz 16-bit stereo
+static const qint32 SAMPLE_RATE = 44100;
+static const qint32 CHANNELS = 2;
+static const qint32 BITS_PER_SAMPLE = 16;
+
+// Maximum amount of PCM data waiting to be written before write() blocks
+static const qint64 MAX_PENDING_BYTES = 8 * 1024 * 1024;
+
+AudioSink::AudioSink(QObject *parent) : QThread(parent)
+{
+    closing = false;
+    pendingBytes = 0;
+    audioDevice = nullptr;
+    errorMapDevice = nullptr;
+    format = Format::pcm;
+    writeFailed = false;
+    dataBytesWritten = 0;
+    havePendingRange = false;
+
+#ifdef HAVE_FLAC
+    flacEncoder = nullptr;
+#endif
+}
+
+AudioSink::~AudioSink()
+{
+    close();
+}
+
+// Choose an output format based on the extension of a filename
+AudioSink::Format AudioSink::formatFromFilename(const QString &filename)
+{
+    const QString suffix = QFileInfo(filename).suffix().toLower();
+
+    if (suffix == "wav") return Format::wav;
+    if (suffix == "flac") return Format::flac;
+    return Format::pcm;
+}
+
+// Return true if this build can write the specified format
+bool AudioSink::isFormatSupported(Format format)
+{
+#ifdef HAVE_FLAC
+    Q_UNUSED(format);
+    return true;
+#else
+    return format != Format::flac;
+#endif
+}
+
+// Start writing output to the specified (open) devices.
+// The devices must not be used by anything else until close() has returned.
+bool AudioSink::open(QIODevice *_audioDevice, Format _format, QIODevice *_errorMapDevice)
+{
+    if (isOpen()) {
+        qCritical() << "AudioSink::open(): Sink is already open";
+        return false;
+    }
+
+    if (!isFormatSupported(_format)) {
+        qCritical() << "AudioSink::open(): This build of ld-process-efm does not support FLAC output";
+        return false;
+    }
+
+    audioDevice = _audioDevice;
+    errorMapDevice = _errorMapDevice;
+    format = _format;
+    writeFailed = false;
+    dataBytesWritten = 0;
+    havePendingRange = false;
+
+    if (errorMapDevice != nullptr) {
+        const QByteArray header = "start_sample,sample_count,type\n";
+        if (errorMapDevice->write(header) != header.size()) {
+            qCritical() << "AudioSink::open(): Could not write the error map header";
+            audioDevice = nullptr;
+            errorMapDevice = nullptr;
+            return false;
+        }
+    }
+
+    if (!startOutput()) {
+        audioDevice = nullptr;
+        errorMapDevice = nullptr;
+        return false;
+    }
+
+    mutex.lock();
+    pendingBuffers.clear();
+    pendingBytes = 0;
+    closing = false;
+    mutex.unlock();
+
+    start();
+
+    return true;
+}
+
+// Queue a batch of PCM data and its error ranges for writing. This only blocks
+// if the queue is full, i.e. the writer thread is more than MAX_PENDING_BYTES
+// behind.
+void AudioSink::write(const QByteArray &pcmData, const QVector<F1ToAudio::ErrorRange> &errorRanges)
+{
+    if (pcmData.isEmpty() && errorRanges.isEmpty()) return;
+
+    QMutexLocker locker(&mutex);
+    while (!pendingBuffers.isEmpty() && pendingBytes + pcmData.size() > MAX_PENDING_BYTES) {
+        bufferSpace.wait(&mutex);
+    }
+    pendingBuffers.enqueue({pcmData, errorRanges});
+    pendingBytes += pcmData.size();
+    bufferAvailable.wakeOne();
+}
+
+// Write any queued data, finish the output file and stop the writer thread.
+// Returns false if any writes to the audio output or error map failed.
+bool AudioSink::close()
+{
+    if (!isOpen()) return isOk();
+
+    mutex.lock();
+    closing = true;
+    bufferAvailable.wakeOne();
+    mutex.unlock();
+
+    wait();
+
+    // Make sure buffered writes to files have actually succeeded
+    if (!flushDevice(audioDevice) || !flushDevice(errorMapDevice)) writeFailed = true;
+
+    audioDevice = nullptr;
+    errorMapDevice = nullptr;
+
+    if (writeFailed) qWarning() << "AudioSink::close(): Writing audio output or error map failed";
+    return !writeFailed;
+}
+
+// Return false if any writes have failed since the sink was last opened
+bool AudioSink::isOk()
+{
+    return !writeFailed;
+}
+
+// Return true if the sink is accepting data
+bool AudioSink::isOpen()
+{
+    return audioDevice != nullptr;
+}
+
+// Thread handling methods --------------------------------------------------------------------------------------------
+
+// Writer thread - write buffers until the sink is closed and the queue is empty
+void AudioSink::run()
+{
+    while (true) {
+        mutex.lock();
+        while (pendingBuffers.isEmpty() && !closing) {
+            bufferAvailable.wait(&mutex);
+        }
+        if (pendingBuffers.isEmpty()) {
+            mutex.unlock();
+            break;
+        }
+        Buffer buffer = pendingBuffers.dequeue();
+        pendingBytes -= buffer.pcmData.size();
+        bufferSpace.wakeAll();
+        mutex.unlock();
+
+        // Once a write has failed, just discard the remaining data
+        if (writeFailed) continue;
+
+        if (!writeAudio(buffer.pcmData)) writeFailed = true;
+        if (!writeErrorRanges(buffer.errorRanges)) writeFailed = true;
+    }
+
+    if (havePendingRange && !writeFailed && !writeErrorRange(pendingRange)) writeFailed = true;
+    havePendingRange = false;
+
+    if (!finishOutput()) writeFailed = true;
+}
+
+// Private methods ----------------------------------------------------------------------------------------------------
+
+#ifdef HAVE_FLAC
+// libFLAC callbacks to write to a QIODevice
+static FLAC__StreamEncoderWriteStatus flacWriteCallback(const FLAC__StreamEncoder *, const FLAC__byte buffer[],
+                                                        size_t bytes, unsigned, unsigned, void *clientData)
+{
+    QIODevice *device = static_cast<QIODevice *>(clientData);
+    if (device->write(reinterpret_cast<const char *>(buffer), static_cast<qint64>(bytes)) != static_cast<qint64>(bytes)) {
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+    }
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+static FLAC__StreamEncoderSeekStatus flacSeekCallback(const FLAC__StreamEncoder *, FLAC__uint64 absoluteByteOffset,
+                                                      void *clientData)
+{
+    QIODevice *device = static_cast<QIODevice *>(clientData);
+    if (device->isSequential()) return FLAC__STREAM_ENCODER_SEEK_STATUS_UNSUPPORTED;
+    if (!device->seek(static_cast<qint64>(absoluteByteOffset))) return FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+    return FLAC__STREAM_ENCODER_SEEK_STATUS_OK;
+}
+
+static FLAC__StreamEncoderTellStatus flacTellCallback(const FLAC__StreamEncoder *, FLAC__uint64 *absoluteByteOffset,
+                                                      void *clientData)
+{
+    QIODevice *device = static_cast<QIODevice *>(clientData);
+    if (device->isSequential()) return FLAC__STREAM_ENCODER_TELL_STATUS_UNSUPPORTED;
+    *absoluteByteOffset = static_cast<FLAC__uint64>(device->pos());
+    return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+}
+#endif
+
+// Write any header needed before the audio data
+bool AudioSink::startOutput()
+{
+    switch (format) {
+    case Format::pcm:
+        return true;
+
+    case Format::wav:
+        // Write a placeholder header; the sizes are filled in by finishOutput()
+        return writeWavHeader();
+
+    case Format::flac:
+#ifdef HAVE_FLAC
+        flacEncoder = FLAC__stream_encoder_new();
+        if (flacEncoder == nullptr) return false;
+
+        FLAC__stream_encoder_set_channels(flacEncoder, CHANNELS);
+        FLAC__stream_encoder_set_bits_per_sample(flacEncoder, BITS_PER_SAMPLE);
+        FLAC__stream_encoder_set_sample_rate(flacEncoder, SAMPLE_RATE);
+        FLAC__stream_encoder_set_compression_level(flacEncoder, 5);
+
+        if (FLAC__stream_encoder_init_stream(flacEncoder, flacWriteCallback, flacSeekCallback, flacTellCallback,
+                                             nullptr, audioDevice) != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+            qCritical() << "AudioSink::startOutput(): Could not initialise the FLAC encoder";
+            FLAC__stream_encoder_delete(flacEncoder);
+            flacEncoder = nullptr;
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+// Write a block of 16-bit stereo PCM data to the output
+bool AudioSink::writeAudio(const QByteArray &pcmData)
+{
+    if (pcmData.isEmpty()) return true;
+
+    dataBytesWritten += pcmData.size();
+
+    if (format == Format::flac) {
+#ifdef HAVE_FLAC
+        const qint16 *samples = reinterpret_cast<const qint16 *>(pcmData.constData());
+        const qint32 sampleCount = pcmData.size() / 2;
+
+        flacBuffer.resize(sampleCount);
+        for (qint32 i = 0; i < sampleCount; i++) flacBuffer[i] = samples[i];
+
+        return FLAC__stream_encoder_process_interleaved(flacEncoder, flacBuffer.constData(),
+                                                        static_cast<unsigned>(sampleCount / CHANNELS));
+#else
+        return false;
+#endif
+    }
+
+    return audioDevice->write(pcmData) == pcmData.size();
+}
+
+// Complete the output after the last audio data has been written
+bool AudioSink::finishOutput()
+{
+    switch (format) {
+    case Format::pcm:
+        return true;
+
+    case Format::wav:
+        // Go back and fill in the sizes in the header
+        if (audioDevice->isSequential()) {
+            qWarning() << "AudioSink::finishOutput(): Cannot update WAV header on a sequential device";
+            return true;
+        }
+        if (!audioDevice->seek(0)) return false;
+        if (!writeWavHeader()) return false;
+        return audioDevice->seek(audioDevice->size());
+
+    case Format::flac:
+#ifdef HAVE_FLAC
+    {
+        const bool success = FLAC__stream_encoder_finish(flacEncoder);
+        FLAC__stream_encoder_delete(flacEncoder);
+        flacEncoder = nullptr;
+        flacBuffer.clear();
+        return success;
+    }
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+// Write a 44-byte WAV header for the amount of data written so far
+bool AudioSink::writeWavHeader()
+{
+    // The RIFF sizes are 32-bit, so clamp them for very long output
+    const quint32 dataSize = static_cast<quint32>(qMin(dataBytesWritten, static_cast<qint64>(0xFFFFFFFF - 36)));
+    const quint16 blockAlign = CHANNELS * (BITS_PER_SAMPLE / 8);
+
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    stream.writeRawData("RIFF", 4);
+    stream << static_cast<quint32>(36 + dataSize);
+    stream.writeRawData("WAVE", 4);
+
+    stream.writeRawData("fmt ", 4);
+    stream << static_cast<quint32>(16);
+    stream << static_cast<quint16>(1); // PCM
+    stream << static_cast<quint16>(CHANNELS);
+    stream << static_cast<quint32>(SAMPLE_RATE);
+    stream << static_cast<quint32>(SAMPLE_RATE * blockAlign);
+    stream << blockAlign;
+    stream << static_cast<quint16>(BITS_PER_SAMPLE);
+
+    stream.writeRawData("data", 4);
+    stream << dataSize;
+
+    return audioDevice->write(header) == header.size();
+}
+
+// Write error ranges to the error map, merging ranges that continue from the previous batch
+bool AudioSink::writeErrorRanges(const QVector<F1ToAudio::ErrorRange> &errorRanges)
+{
+    if (errorMapDevice == nullptr) return true;
+
+    for (const F1ToAudio::ErrorRange &errorRange : errorRanges) {
+        if (havePendingRange && pendingRange.type == errorRange.type
+                && pendingRange.startSample + pendingRange.sampleCount == errorRange.startSample) {
+            pendingRange.sampleCount += errorRange.sampleCount;
+            continue;
+        }
+
+        if (havePendingRange && !writeErrorRange(pendingRange)) return false;
+        pendingRange = errorRange;
+        havePendingRange = true;
+    }
+
+    return true;
+}
+
+// Write a single line to the error map
+bool AudioSink::writeErrorRange(const F1ToAudio::ErrorRange &errorRange)
+{
+    if (errorMapDevice == nullptr) return true;
+
+    QString typeName;
+    switch (errorRange.type) {
+    case F1ToAudio::ErrorType::concealed:
+        typeName = "concealed";
+        break;
+    case F1ToAudio::ErrorType::silenced:
+        typeName = "silenced";
+        break;
+    case F1ToAudio::ErrorType::missing:
+        typeName = "missing";
+        break;
+    }
+
+    const QByteArray line = QString("%1,%2,%3\n").arg(errorRange.startSample).arg(errorRange.sampleCount)
+                            .arg(typeName).toUtf8();
+    return errorMapDevice->write(line) == line.size();
+}
+
+// Flush a device's buffered data, if it's a file
+bool AudioSink::flushDevice(QIODevice *device)
+{
+    QFileDevice *fileDevice = qobject_cast<QFileDevice *>(device);
+    if (fileDevice == nullptr) return true;
+
+    return fileDevice->flush();
+}
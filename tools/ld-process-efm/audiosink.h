@@ -0,0 +1,113 @@
+/************************************************************************
+
+    audiosink.h
+
+    ld-process-efm - EFM data decoder
+    Copyright (C) 2019 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef AUDIOSINK_H
+#define AUDIOSINK_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QIODevice>
+#include <QFileDevice>
+#include <QDebug>
+
+#ifdef HAVE_FLAC
+#include <FLAC/stream_encoder.h>
+#endif
+
+#include "Decoders/f1toaudio.h"
+
+// Writes the PCM output of F1ToAudio to a file on a background thread, so that
+// the decoder doesn't wait for output unless the writer falls a long way
+// behind. The audio can be written as raw PCM, as a WAV file, or (if built
+// with libFLAC) as a FLAC file. The error ranges reported by F1ToAudio can
+// optionally be written to a CSV error map at the same time.
+class AudioSink : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit AudioSink(QObject *parent = nullptr);
+    ~AudioSink() override;
+
+    // Output formats
+    enum Format {
+        pcm,
+        wav,
+        flac
+    };
+
+    static Format formatFromFilename(const QString &filename);
+    static bool isFormatSupported(Format format);
+
+    bool open(QIODevice *_audioDevice, Format _format, QIODevice *_errorMapDevice = nullptr);
+    void write(const QByteArray &pcmData, const QVector<F1ToAudio::ErrorRange> &errorRanges);
+    bool close();
+    bool isOpen();
+    bool isOk();
+
+protected:
+    void run() override;
+
+private:
+    // A batch of output from F1ToAudio, waiting to be written
+    struct Buffer {
+        QByteArray pcmData;
+        QVector<F1ToAudio::ErrorRange> errorRanges;
+    };
+
+    // Thread control
+    QMutex mutex;
+    QWaitCondition bufferAvailable;
+    QWaitCondition bufferSpace;
+    QQueue<Buffer> pendingBuffers;
+    qint64 pendingBytes;
+    bool closing;
+
+    // Output state (only used by the writer thread while open)
+    QIODevice *audioDevice;
+    QIODevice *errorMapDevice;
+    Format format;
+    bool writeFailed;
+    qint64 dataBytesWritten;
+    bool havePendingRange;
+    F1ToAudio::ErrorRange pendingRange;
+
+#ifdef HAVE_FLAC
+    FLAC__StreamEncoder *flacEncoder;
+    QVector<FLAC__int32> flacBuffer;
+#endif
+
+    bool startOutput();
+    bool writeAudio(const QByteArray &pcmData);
+    bool finishOutput();
+    bool writeWavHeader();
+    bool writeErrorRanges(const QVector<F1ToAudio::ErrorRange> &errorRanges);
+    bool writeErrorRange(const F1ToAudio::ErrorRange &errorRange);
+    static bool flushDevice(QIODevice *device);
+};
+
+#endif // AUDIOSINK_H
@@ -0,0 +1,133 @@
+/************************************************************************
+
+    batchjob.cpp
+
+    ld-process-efm-batch - Headless batch EFM data decoder
+    Copyright (C) 2019-2020 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "batchjob.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+BatchJob::BatchJob(const QString &_inputFileName, const Options &_options, QAtomicInt &_failures)
+    : inputFileName(_inputFileName), options(_options), failures(_failures)
+{
+}
+
+void BatchJob::run()
+{
+    if (!decodeFile()) {
+        qWarning() << "Failed to process EFM file:" << inputFileName;
+        failures.ref();
+    }
+}
+
+// The outputs and statistics are written alongside the input file (or into
+// the output directory, if one was given)
+QString BatchJob::getOutputBaseName(const QString &inputFileName, const Options &options)
+{
+    QFileInfo inputFileInfo(inputFileName);
+    QDir outputDirectory(options.outputDirectory.isEmpty() ? inputFileInfo.absolutePath() : options.outputDirectory);
+    return QDir::cleanPath(QFileInfo(outputDirectory.filePath(inputFileInfo.completeBaseName())).absoluteFilePath());
+}
+
+// Decode the input file
+bool BatchJob::decodeFile()
+{
+    const QString baseName = getOutputBaseName(inputFileName, options);
+
+    QFile inputFileHandle(inputFileName);
+    if (!inputFileHandle.open(QIODevice::ReadOnly)) {
+        qCritical() << "Could not open input EFM file" << inputFileName;
+        return false;
+    }
+
+    qInfo() << "Processing EFM file:" << inputFileName;
+
+    // Set up the decoder
+    EfmProcess efmProcess;
+    efmProcess.setAudioErrorTreatment(options.errorTreatment, options.concealType);
+    efmProcess.setDecoderOptions(options.padInitialDiscTime, options.decodeAsAudio, options.decodeAsData, options.noTimeStamp);
+
+    // Open the audio output
+    QFile audioOutputFileHandle;
+    QFile errorMapFileHandle;
+    AudioSink audioOutputSink;
+    if (options.decodeAsAudio) {
+        QString extension;
+        switch (options.audioFormat) {
+        case AudioSink::Format::pcm:
+            extension = ".pcm";
+            break;
+        case AudioSink::Format::wav:
+            extension = ".wav";
+            break;
+        case AudioSink::Format::flac:
+            extension = ".flac";
+            break;
+        }
+
+        audioOutputFileHandle.setFileName(baseName + extension);
+        if (!audioOutputFileHandle.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+            qCritical() << "Could not open audio output file" << audioOutputFileHandle.fileName();
+            return false;
+        }
+
+        QIODevice *errorMapDevice = nullptr;
+        if (options.writeErrorMap) {
+            errorMapFileHandle.setFileName(baseName + ".errors.csv");
+            if (!errorMapFileHandle.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+                qCritical() << "Could not open error map output file" << errorMapFileHandle.fileName();
+                return false;
+            }
+            errorMapDevice = &errorMapFileHandle;
+        }
+
+        if (!audioOutputSink.open(&audioOutputFileHandle, options.audioFormat, errorMapDevice)) return false;
+    }
+
+    // Open the data output
+    QFile dataOutputFileHandle;
+    if (options.decodeAsData) {
+        dataOutputFileHandle.setFileName(baseName + ".dat");
+        if (!dataOutputFileHandle.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCritical() << "Could not open data output file" << dataOutputFileHandle.fileName();
+            audioOutputSink.close();
+            return false;
+        }
+    }
+
+    // Decode on this thread (the sink closes itself at the end of the decode)
+    const bool outputsWritten = efmProcess.decode(&inputFileHandle,
+                                                  options.decodeAsAudio ? &audioOutputSink : nullptr,
+                                                  options.decodeAsData ? &dataOutputFileHandle : nullptr);
+    if (!outputsWritten) {
+        qCritical() << "Writing the decoded output failed for EFM file:" << inputFileName;
+    }
+
+    qInfo() << "Finished processing EFM file:" << inputFileName;
+
+    // Write the statistics even if the output failed, as they may help explain why
+    const bool statisticsWritten = efmProcess.writeStatistics(baseName + ".stats.json");
+
+    return outputsWritten && statisticsWritten;
+}
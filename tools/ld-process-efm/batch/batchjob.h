@@ -0,0 +1,68 @@
+/************************************************************************
+
+    batchjob.h
+
+    ld-process-efm-batch - Headless batch EFM data decoder
+    Copyright (C) 2019-2020 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef BATCHJOB_H
+#define BATCHJOB_H
+
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QString>
+#include <QDebug>
+
+#include "efmprocess.h"
+#include "audiosink.h"
+
+// Decodes a single EFM file; run from a QThreadPool to decode several files at once
+class BatchJob : public QRunnable
+{
+public:
+    // Options shared by all the jobs in a batch
+    struct Options {
+        QString outputDirectory;
+        bool decodeAsAudio;
+        bool decodeAsData;
+        bool padInitialDiscTime;
+        bool noTimeStamp;
+        bool writeErrorMap;
+        AudioSink::Format audioFormat;
+        F1ToAudio::ErrorTreatment errorTreatment;
+        F1ToAudio::ConcealType concealType;
+    };
+
+    BatchJob(const QString &_inputFileName, const Options &_options, QAtomicInt &_failures);
+
+    void run() override;
+
+    // Return the path, without an extension, of the output files for inputFileName
+    static QString getOutputBaseName(const QString &inputFileName, const Options &options);
+
+private:
+    QString inputFileName;
+    Options options;
+    QAtomicInt &failures;
+
+    bool decodeFile();
+};
+
+#endif // BATCHJOB_H
@@ -0,0 +1,232 @@
+/************************************************************************
+
+    main.cpp
+
+    ld-process-efm-batch - Headless batch EFM data decoder
+    Copyright (C) 2019-2020 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QtGlobal>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QThreadPool>
+
+#include "logging.h"
+#include "batchjob.h"
+
+int main(int argc, char *argv[])
+{
+    // Install the local debug message handler
+    setDebug(true);
+    qInstallMessageHandler(debugOutputHandler);
+
+    QCoreApplication a(argc, argv);
+
+    // Set application name and version
+    QCoreApplication::setApplicationName("ld-process-efm-batch");
+    QCoreApplication::setApplicationVersion(QString("Branch: %1 / Commit: %2").arg(APP_BRANCH, APP_COMMIT));
+    QCoreApplication::setOrganizationDomain("domesday86.com");
+
+    // Set up the command line parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "ld-process-efm-batch - Headless batch EFM data decoder\n"
+                "\n"
+                "(c)2019-2020 Simon Inns\n"
+                "GPLv3 Open-Source - github: https://github.com/happycube/ld-decode");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    // Add the standard debug options --debug and --quiet
+    addStandardDebugOptions(parser);
+
+    // Option to specify the number of files to decode at once (-t / --threads)
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads",
+                                     QCoreApplication::translate("main", "Specify the number of files to process concurrently (default number of logical CPUs)"),
+                                     QCoreApplication::translate("main", "number"));
+    parser.addOption(threadsOption);
+
+    // Option to specify the output directory (-o / --output-dir)
+    QCommandLineOption outputDirectoryOption(QStringList() << "o" << "output-dir",
+                                             QCoreApplication::translate("main", "Write the output files to the specified directory (default alongside each input file)"),
+                                             QCoreApplication::translate("main", "directory"));
+    parser.addOption(outputDirectoryOption);
+
+    // Option to select the audio format (--audio-format)
+    QCommandLineOption audioFormatOption(QStringList() << "audio-format",
+                                         QCoreApplication::translate("main", "Audio output format (pcm, wav, flac; default pcm)"),
+                                         QCoreApplication::translate("main", "format"));
+    parser.addOption(audioFormatOption);
+
+    // Option to select the audio error treatment (--error-treatment)
+    QCommandLineOption errorTreatmentOption(QStringList() << "error-treatment",
+                                            QCoreApplication::translate("main", "Audio error treatment (conceal, silence, passthrough; default conceal)"),
+                                            QCoreApplication::translate("main", "treatment"));
+    parser.addOption(errorTreatmentOption);
+
+    // Option to select the concealment type (--conceal-type)
+    QCommandLineOption concealTypeOption(QStringList() << "conceal-type",
+                                         QCoreApplication::translate("main", "Audio concealment type (linear, prediction; default linear)"),
+                                         QCoreApplication::translate("main", "type"));
+    parser.addOption(concealTypeOption);
+
+    // Option to pad the audio to the initial disc time (-p / --pad)
+    QCommandLineOption padOption(QStringList() << "p" << "pad",
+                                 QCoreApplication::translate("main", "Pad the start of the audio to disc time 00:00.00"));
+    parser.addOption(padOption);
+
+    // Option to decode sector data (--data)
+    QCommandLineOption dataOption(QStringList() << "data",
+                                  QCoreApplication::translate("main", "Decode sector data to a .dat file"));
+    parser.addOption(dataOption);
+
+    // Option to disable audio decoding (--no-audio)
+    QCommandLineOption noAudioOption(QStringList() << "no-audio",
+                                     QCoreApplication::translate("main", "Do not decode audio"));
+    parser.addOption(noAudioOption);
+
+    // Option to ignore the time-stamps (--no-timestamp)
+    QCommandLineOption noTimeStampOption(QStringList() << "no-timestamp",
+                                         QCoreApplication::translate("main", "Decode without using the subcode time-stamps"));
+    parser.addOption(noTimeStampOption);
+
+    // Option to write error maps (--error-map)
+    QCommandLineOption errorMapOption(QStringList() << "error-map",
+                                      QCoreApplication::translate("main", "Write a CSV map of concealed/silenced audio samples for each file"));
+    parser.addOption(errorMapOption);
+
+    // -- Positional arguments --
+
+    // Positional argument to specify input EFM files
+    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input EFM files"), "input...");
+
+    // Process the command line options and arguments given by the user
+    parser.process(a);
+
+    // Standard logging options
+    processStandardDebugOptions(parser);
+
+    // Get the arguments from the parser
+    QStringList inputFileNames = parser.positionalArguments();
+    if (inputFileNames.isEmpty()) {
+        qCritical() << "You must specify at least one input EFM file";
+        return 1;
+    }
+
+    qint32 maxThreads = QThread::idealThreadCount();
+    if (parser.isSet(threadsOption)) {
+        maxThreads = parser.value(threadsOption).toInt();
+
+        if (maxThreads < 1) {
+            qCritical() << "Specified number of threads must be greater than zero";
+            return 1;
+        }
+    }
+
+    BatchJob::Options options;
+    options.outputDirectory = parser.value(outputDirectoryOption);
+    options.decodeAsAudio = !parser.isSet(noAudioOption);
+    options.decodeAsData = parser.isSet(dataOption);
+    options.padInitialDiscTime = parser.isSet(padOption);
+    options.noTimeStamp = parser.isSet(noTimeStampOption);
+    options.writeErrorMap = parser.isSet(errorMapOption);
+
+    options.audioFormat = AudioSink::Format::pcm;
+    if (parser.isSet(audioFormatOption)) {
+        const QString name = parser.value(audioFormatOption);
+        if (name == "pcm") {
+            options.audioFormat = AudioSink::Format::pcm;
+        } else if (name == "wav") {
+            options.audioFormat = AudioSink::Format::wav;
+        } else if (name == "flac") {
+            options.audioFormat = AudioSink::Format::flac;
+        } else {
+            qCritical() << "Unknown audio format" << name;
+            return 1;
+        }
+    }
+    if (!AudioSink::isFormatSupported(options.audioFormat)) {
+        qCritical() << "This build of ld-process-efm-batch does not support the selected audio format";
+        return 1;
+    }
+
+    options.errorTreatment = F1ToAudio::ErrorTreatment::conceal;
+    if (parser.isSet(errorTreatmentOption)) {
+        const QString name = parser.value(errorTreatmentOption);
+        if (name == "conceal") {
+            options.errorTreatment = F1ToAudio::ErrorTreatment::conceal;
+        } else if (name == "silence") {
+            options.errorTreatment = F1ToAudio::ErrorTreatment::silence;
+        } else if (name == "passthrough") {
+            options.errorTreatment = F1ToAudio::ErrorTreatment::passThrough;
+        } else {
+            qCritical() << "Unknown error treatment" << name;
+            return 1;
+        }
+    }
+
+    options.concealType = F1ToAudio::ConcealType::linear;
+    if (parser.isSet(concealTypeOption)) {
+        const QString name = parser.value(concealTypeOption);
+        if (name == "linear") {
+            options.concealType = F1ToAudio::ConcealType::linear;
+        } else if (name == "prediction") {
+            options.concealType = F1ToAudio::ConcealType::prediction;
+        } else {
+            qCritical() << "Unknown conceal type" << name;
+            return 1;
+        }
+    }
+
+    if (!options.outputDirectory.isEmpty() && !QDir(options.outputDirectory).exists()) {
+        qCritical() << "Output directory does not exist:" << options.outputDirectory;
+        return 1;
+    }
+
+    // The jobs run concurrently, so no two of them can write the same output files
+    QHash<QString, QString> outputBaseNames;
+    for (const QString &inputFileName : inputFileNames) {
+        const QString baseName = BatchJob::getOutputBaseName(inputFileName, options);
+        if (outputBaseNames.contains(baseName)) {
+            qCritical() << "Input files" << outputBaseNames.value(baseName) << "and" << inputFileName <<
+                           "would both be written to" << baseName;
+            return 1;
+        }
+        outputBaseNames.insert(baseName, inputFileName);
+    }
+
+    // Decode the files, up to maxThreads at once
+    QAtomicInt failures(0);
+    QThreadPool pool;
+    pool.setMaxThreadCount(maxThreads);
+    for (const QString &inputFileName : inputFileNames) {
+        pool.start(new BatchJob(inputFileName, options, failures));
+    }
+    pool.waitForDone();
+
+    const qint32 failureCount = failures.load();
+    qInfo() << "Processed" << inputFileNames.size() - failureCount << "of" << inputFileNames.size() << "EFM files successfully";
+
+    // Quit with success if all the files were processed
+    return (failureCount == 0) ? 0 : 1;
+}
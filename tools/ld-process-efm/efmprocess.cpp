@@ -24,6 +24,8 @@
 
 #include "efmprocess.h"
 
+#include "../library/JsonWax/JsonWax.h"
+
 EfmProcess::EfmProcess(QObject *parent) : QThread(parent)
 {
     // Thread control variables
@@ -38,6 +40,9 @@ EfmProcess::EfmProcess(QObject *parent) : QThread(parent)
     debug_f1ToAudio = false;
     debug_f1ToData = false;
 
+    errorTreatment = F1ToAudio::ErrorTreatment::conceal;
+    concealType = F1ToAudio::ConcealType::linear;
+
     padInitialDiscTime = false;
 
     decodeAsAudio = true;
@@ -126,13 +131,13 @@ void EfmProcess::reportStatistics()
 // Thread handling methods --------------------------------------------------------------------------------------------
 
 // Start processing the input EFM file
-void EfmProcess::startProcessing(QFile* _inputFileHandle, QFile* _audioOutputFileHandle, QFile* _dataOutputFileHandle)
+void EfmProcess::startProcessing(QFile* _inputFileHandle, AudioSink* _audioOutputSink, QFile* _dataOutputFileHandle)
 {
     QMutexLocker locker(&mutex);
 
     // Move all the parameters to be local
     efmInputFileHandle = _inputFileHandle;
-    audioOutputFileHandle = _audioOutputFileHandle;
+    audioOutputSink = _audioOutputSink;
     dataOutputFileHandle = _dataOutputFileHandle;
 
     // Is the run process already running?
@@ -175,6 +180,81 @@ EfmProcess::Statistics EfmProcess::getStatistics(void)
     return statistics;
 }
 
+// Write the statistics about the decoding process to a JSON file
+bool EfmProcess::writeStatistics(const QString &fileName)
+{
+    Statistics stats = getStatistics();
+    JsonWax json;
+
+    json.setValue({"efmToF3Frames", "validSyncs"}, stats.efmToF3Frames.validSyncs);
+    json.setValue({"efmToF3Frames", "undershootSyncs"}, stats.efmToF3Frames.undershootSyncs);
+    json.setValue({"efmToF3Frames", "overshootSyncs"}, stats.efmToF3Frames.overshootSyncs);
+    json.setValue({"efmToF3Frames", "syncLoss"}, stats.efmToF3Frames.syncLoss);
+    json.setValue({"efmToF3Frames", "validFrames"}, stats.efmToF3Frames.validFrames);
+    json.setValue({"efmToF3Frames", "undershootFrames"}, stats.efmToF3Frames.undershootFrames);
+    json.setValue({"efmToF3Frames", "overshootFrames"}, stats.efmToF3Frames.overshootFrames);
+    json.setValue({"efmToF3Frames", "inRangeTValues"}, stats.efmToF3Frames.inRangeTValues);
+    json.setValue({"efmToF3Frames", "outOfRangeTValues"}, stats.efmToF3Frames.outOfRangeTValues);
+    json.setValue({"efmToF3Frames", "validEfmSymbols"}, stats.efmToF3Frames.validEfmSymbols);
+    json.setValue({"efmToF3Frames", "invalidEfmSymbols"}, stats.efmToF3Frames.invalidEfmSymbols);
+
+    json.setValue({"syncF3Frames", "totalF3Frames"}, stats.syncF3Frames.totalF3Frames);
+    json.setValue({"syncF3Frames", "discardedFrames"}, stats.syncF3Frames.discardedFrames);
+    json.setValue({"syncF3Frames", "totalSections"}, stats.syncF3Frames.totalSections);
+
+    json.setValue({"f3ToF2Frames", "totalF3Frames"}, stats.f3ToF2Frames.totalF3Frames);
+    json.setValue({"f3ToF2Frames", "totalF2Frames"}, stats.f3ToF2Frames.totalF2Frames);
+    json.setValue({"f3ToF2Frames", "sequenceInterruptions"}, stats.f3ToF2Frames.sequenceInterruptions);
+    json.setValue({"f3ToF2Frames", "missingF3Frames"}, stats.f3ToF2Frames.missingF3Frames);
+    json.setValue({"f3ToF2Frames", "preempFrames"}, stats.f3ToF2Frames.preempFrames);
+    json.setValue({"f3ToF2Frames", "initialDiscTime"}, stats.f3ToF2Frames.initialDiscTime.getTimeAsQString());
+    json.setValue({"f3ToF2Frames", "currentDiscTime"}, stats.f3ToF2Frames.currentDiscTime.getTimeAsQString());
+    json.setValue({"f3ToF2Frames", "c1", "passed"}, stats.f3ToF2Frames.c1Circ_statistics.c1Passed);
+    json.setValue({"f3ToF2Frames", "c1", "corrected"}, stats.f3ToF2Frames.c1Circ_statistics.c1Corrected);
+    json.setValue({"f3ToF2Frames", "c1", "failed"}, stats.f3ToF2Frames.c1Circ_statistics.c1Failed);
+    json.setValue({"f3ToF2Frames", "c1", "flushed"}, stats.f3ToF2Frames.c1Circ_statistics.c1flushed);
+    json.setValue({"f3ToF2Frames", "c2", "passed"}, stats.f3ToF2Frames.c2Circ_statistics.c2Passed);
+    json.setValue({"f3ToF2Frames", "c2", "corrected"}, stats.f3ToF2Frames.c2Circ_statistics.c2Corrected);
+    json.setValue({"f3ToF2Frames", "c2", "failed"}, stats.f3ToF2Frames.c2Circ_statistics.c2Failed);
+    json.setValue({"f3ToF2Frames", "c2", "flushed"}, stats.f3ToF2Frames.c2Circ_statistics.c2flushed);
+    json.setValue({"f3ToF2Frames", "deinterleave", "valid"}, stats.f3ToF2Frames.c2Deinterleave_statistics.validDeinterleavedC2s);
+    json.setValue({"f3ToF2Frames", "deinterleave", "invalid"}, stats.f3ToF2Frames.c2Deinterleave_statistics.invalidDeinterleavedC2s);
+    json.setValue({"f3ToF2Frames", "deinterleave", "flushed"}, stats.f3ToF2Frames.c2Deinterleave_statistics.c2flushed);
+
+    json.setValue({"f2ToF1Frames", "totalFrames"}, stats.f2ToF1Frames.totalFrames);
+    json.setValue({"f2ToF1Frames", "validF2Frames"}, stats.f2ToF1Frames.validF2Frames);
+    json.setValue({"f2ToF1Frames", "invalidF2Frames"}, stats.f2ToF1Frames.invalidF2Frames);
+    json.setValue({"f2ToF1Frames", "initialPaddingFrames"}, stats.f2ToF1Frames.initialPaddingFrames);
+    json.setValue({"f2ToF1Frames", "missingSectionFrames"}, stats.f2ToF1Frames.missingSectionFrames);
+    json.setValue({"f2ToF1Frames", "encoderOffFrames"}, stats.f2ToF1Frames.encoderOffFrames);
+    json.setValue({"f2ToF1Frames", "framesStart"}, stats.f2ToF1Frames.framesStart.getTimeAsQString());
+    json.setValue({"f2ToF1Frames", "frameCurrent"}, stats.f2ToF1Frames.frameCurrent.getTimeAsQString());
+
+    json.setValue({"f1ToAudio", "audioSamples"}, stats.f1ToAudio.audioSamples);
+    json.setValue({"f1ToAudio", "corruptSamples"}, stats.f1ToAudio.corruptSamples);
+    json.setValue({"f1ToAudio", "missingSamples"}, stats.f1ToAudio.missingSamples);
+    json.setValue({"f1ToAudio", "concealedSamples"}, stats.f1ToAudio.concealedSamples);
+    json.setValue({"f1ToAudio", "totalSamples"}, stats.f1ToAudio.totalSamples);
+    json.setValue({"f1ToAudio", "startTime"}, stats.f1ToAudio.startTime.getTimeAsQString());
+    json.setValue({"f1ToAudio", "currentTime"}, stats.f1ToAudio.currentTime.getTimeAsQString());
+    json.setValue({"f1ToAudio", "duration"}, stats.f1ToAudio.duration.getTimeAsQString());
+
+    json.setValue({"f1ToData", "validSectors"}, stats.f1ToData.validSectors);
+    json.setValue({"f1ToData", "invalidSectors"}, stats.f1ToData.invalidSectors);
+    json.setValue({"f1ToData", "missingSectors"}, stats.f1ToData.missingSectors);
+    json.setValue({"f1ToData", "totalSectors"}, stats.f1ToData.totalSectors);
+    json.setValue({"f1ToData", "missingSync"}, stats.f1ToData.missingSync);
+    json.setValue({"f1ToData", "startAddress"}, stats.f1ToData.startAddress.getTimeAsQString());
+    json.setValue({"f1ToData", "currentAddress"}, stats.f1ToData.currentAddress.getTimeAsQString());
+
+    if (!json.saveAs(fileName, JsonWax::Readable)) {
+        qCritical() << "Writing JSON file failed:" << json.errorMsg();
+        return false;
+    }
+
+    return true;
+}
+
 // Method to reset decoding classes
 void EfmProcess::reset()
 {
@@ -200,45 +280,18 @@ void EfmProcess::run()
         // Lock and copy all parameters to 'thread-safe' variables
         mutex.lock();
         efmInputFileHandleTs = this->efmInputFileHandle;
-        audioOutputFileHandleTs = this->audioOutputFileHandle;
+        audioOutputSinkTs = this->audioOutputSink;
         dataOutputFileHandleTs = this->dataOutputFileHandle;
         mutex.unlock();
 
-        qint64 initialInputFileSize = efmInputFileHandleTs->bytesAvailable();
-        qint32 lastPercent = 0;
-        while(efmInputFileHandle->bytesAvailable() > 0 && !abort && !cancel) {
-            // Get a buffer of EFM data
-            QByteArray inputEfmBuffer;
-            inputEfmBuffer = readEfmData();
-
-            // Perform processing
-            QVector<F3Frame> initialF3Frames = efmToF3Frames.process(inputEfmBuffer, debug_efmToF3Frames);
-            QVector<F3Frame> syncedF3Frames = syncF3Frames.process(initialF3Frames, debug_syncF3Frames);
-            QVector<F2Frame> f2Frames = f3ToF2Frames.process(syncedF3Frames, debug_f3ToF2Frames, noTimeStamp);
-            QVector<F1Frame> f1Frames = f2ToF1Frames.process(f2Frames, debug_f2ToF1Frame, noTimeStamp);
-
-            if (decodeAsAudio) {
-                audioOutputFileHandle->write(f1ToAudio.process(f1Frames, padInitialDiscTime, errorTreatment, concealType, debug_f1ToAudio));
-            }
-
-            if (decodeAsData) {
-                dataOutputFileHandle->write(f1ToData.process(f1Frames, debug_f1ToData));
-            }
-
-            // Report progress to parent
-            qreal percent = 100 - (100.0 / static_cast<qreal>(initialInputFileSize)) * static_cast<qreal>(efmInputFileHandle->bytesAvailable());
-            if (static_cast<qint32>(percent) > lastPercent) {
-                emit percentProcessed(static_cast<qint32>(percent));
-            }
-            lastPercent = static_cast<qint32>(percent);
-        }
+        const bool success = decodeEfmFile();
 
         // Check if audio is available
         if (f1ToAudio.getStatistics().totalSamples > 0) audioAvailable = true;
         if (f1ToData.getStatistics().totalSectors > 0) dataAvailable = true;
 
         // Processing complete
-        emit processingComplete(audioAvailable, dataAvailable);
+        emit processingComplete(success, audioAvailable, dataAvailable);
 
         // Sleep the thread until we are restarted
         mutex.lock();
@@ -252,6 +305,74 @@ void EfmProcess::run()
     qDebug() << "EfmProcess::run(): Thread aborted";
 }
 
+// Decode an EFM file on the calling thread, rather than the processing thread.
+// This is used to run several decodes in parallel, with one EfmProcess for each.
+// Either output may be nullptr if it's not required.
+// Returns false if writing either output failed.
+bool EfmProcess::decode(QFile *_inputFileHandle, AudioSink *_audioOutputSink, QFile *_dataOutputFileHandle)
+{
+    reset();
+    cancel = false;
+
+    efmInputFileHandleTs = _inputFileHandle;
+    audioOutputSinkTs = _audioOutputSink;
+    dataOutputFileHandleTs = _dataOutputFileHandle;
+
+    return decodeEfmFile();
+}
+
+// Private methods ----------------------------------------------------------------------------------------------------
+
+// Run the input EFM file through the decoding pipeline.
+// Returns false if writing either output failed.
+bool EfmProcess::decodeEfmFile()
+{
+    bool success = true;
+
+    qint64 initialInputFileSize = efmInputFileHandleTs->bytesAvailable();
+    qint32 lastPercent = 0;
+    while(efmInputFileHandleTs->bytesAvailable() > 0 && !abort && !cancel) {
+        // Get a buffer of EFM data
+        QByteArray inputEfmBuffer;
+        inputEfmBuffer = readEfmData();
+
+        // Perform processing
+        QVector<F3Frame> initialF3Frames = efmToF3Frames.process(inputEfmBuffer, debug_efmToF3Frames);
+        QVector<F3Frame> syncedF3Frames = syncF3Frames.process(initialF3Frames, debug_syncF3Frames);
+        QVector<F2Frame> f2Frames = f3ToF2Frames.process(syncedF3Frames, debug_f3ToF2Frames, noTimeStamp);
+        QVector<F1Frame> f1Frames = f2ToF1Frames.process(f2Frames, debug_f2ToF1Frame, noTimeStamp);
+
+        if (decodeAsAudio && audioOutputSinkTs != nullptr) {
+            // The sink writes on its own thread, so this doesn't wait for the output
+            QByteArray pcmData = f1ToAudio.process(f1Frames, padInitialDiscTime, errorTreatment, concealType, debug_f1ToAudio);
+            audioOutputSinkTs->write(pcmData, f1ToAudio.getErrorRanges());
+        }
+
+        if (decodeAsData && dataOutputFileHandleTs != nullptr) {
+            const QByteArray sectorData = f1ToData.process(f1Frames, debug_f1ToData);
+            if (success && dataOutputFileHandleTs->write(sectorData) != sectorData.size()) {
+                qWarning() << "EfmProcess::decodeEfmFile(): Failed to write data output";
+                success = false;
+            }
+        }
+
+        // Report progress to parent
+        qreal percent = 100 - (100.0 / static_cast<qreal>(initialInputFileSize)) * static_cast<qreal>(efmInputFileHandleTs->bytesAvailable());
+        if (static_cast<qint32>(percent) > lastPercent) {
+            emit percentProcessed(static_cast<qint32>(percent));
+        }
+        lastPercent = static_cast<qint32>(percent);
+    }
+
+    // Write any remaining audio and finish the output file
+    if (audioOutputSinkTs != nullptr && !audioOutputSinkTs->close()) {
+        qWarning() << "EfmProcess::decodeEfmFile(): Failed to write audio output";
+        success = false;
+    }
+
+    return success;
+}
+
 // Method to read EFM T value data from the input file
 QByteArray EfmProcess::readEfmData(void)
 {
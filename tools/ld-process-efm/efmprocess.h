@@ -39,6 +39,7 @@
 #include "Decoders/f2tof1frames.h"
 #include "Decoders/f1toaudio.h"
 #include "Decoders/f1todata.h"
+#include "audiosink.h"
 
 class EfmProcess : public QThread
 {
@@ -64,14 +65,16 @@ public:
                                             F1ToAudio::ConcealType _concealType);
     void setDecoderOptions(bool _padInitialDiscTime, bool _decodeAsAudio, bool _decodeAsData, bool _noTimeStamp);
     void reportStatistics();
-    void startProcessing(QFile *_inputFilename, QFile *_audioOutputFilename, QFile *_dataOutputFilename);
+    void startProcessing(QFile *_inputFilename, AudioSink *_audioOutputSink, QFile *_dataOutputFilename);
     void stopProcessing();
     void quit();
+    bool decode(QFile *_inputFileHandle, AudioSink *_audioOutputSink, QFile *_dataOutputFileHandle);
     Statistics getStatistics();
+    bool writeStatistics(const QString &fileName);
     void reset();
 
 signals:
-    void processingComplete(bool audioAvailable, bool dataAvailable);
+    void processingComplete(bool success, bool audioAvailable, bool dataAvailable);
     void percentProcessed(qint32 percent);
 
 protected:
@@ -113,14 +116,15 @@ private:
 
     // Externally settable variables
     QFile* efmInputFileHandle;
-    QFile* audioOutputFileHandle;
+    AudioSink* audioOutputSink;
     QFile* dataOutputFileHandle;
 
     // Thread-safe variables
     QFile* efmInputFileHandleTs;
-    QFile* audioOutputFileHandleTs;
+    AudioSink* audioOutputSinkTs;
     QFile* dataOutputFileHandleTs;
 
+    bool decodeEfmFile();
     QByteArray readEfmData(void);
 };
 
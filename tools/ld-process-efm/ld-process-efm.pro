@@ -26,6 +26,7 @@ CONFIG += c++11
 
 SOURCES += \
         Datatypes/audio.cpp \
+        Datatypes/crc.cpp \
         Datatypes/f1frame.cpp \
         Datatypes/f2frame.cpp \
         Datatypes/f3frame.cpp \
@@ -42,6 +43,7 @@ SOURCES += \
         Decoders/f3tof2frames.cpp \
         Decoders/syncf3frames.cpp \
         aboutdialog.cpp \
+        audiosink.cpp \
         configuration.cpp \
         efmprocess.cpp \
         main.cpp \
@@ -50,6 +52,7 @@ SOURCES += \
 
 HEADERS += \
         Datatypes/audio.h \
+        Datatypes/crc.h \
         Datatypes/f1frame.h \
         Datatypes/f2frame.h \
         Datatypes/f3frame.h \
@@ -66,6 +69,7 @@ HEADERS += \
         Decoders/f3tof2frames.h \
         Decoders/syncf3frames.h \
         aboutdialog.h \
+        audiosink.h \
         configuration.h \
         efmprocess.h \
         ezpwd/asserter \
@@ -89,6 +93,13 @@ FORMS += \
 # Add external includes to the include path
 INCLUDEPATH += ../library/tbc
 
+# Use libFLAC for FLAC audio output, if it's available
+CONFIG += link_pkgconfig
+packagesExist(flac) {
+    PKGCONFIG += flac
+    DEFINES += HAVE_FLAC
+}
+
 # Include git information definitions
 isEmpty(BRANCH) {
     BRANCH = "unknown"
@@ -29,6 +29,7 @@
 #include <QCommandLineParser>
 
 #include "logging.h"
+#include "audiosink.h"
 
 int main(int argc, char *argv[])
 {
@@ -61,13 +62,19 @@ int main(int argc, char *argv[])
                                        QCoreApplication::translate("main", "Run in non-interactive mode"));
     parser.addOption(nonInteractiveOption);
 
+    // Option to write a map of concealed audio samples (--error-map)
+    QCommandLineOption errorMapOption(QStringList() << "error-map",
+                                      QCoreApplication::translate("main", "Write a CSV map of concealed/silenced audio samples to the specified file (non-interactive mode only)"),
+                                      QCoreApplication::translate("main", "filename"));
+    parser.addOption(errorMapOption);
+
     // -- Positional arguments --
 
     // Positional argument to specify input EFM file
     parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input EFM file"));
 
     // Positional argument to specify output audio file
-    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output audio file"));
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output audio file (.wav, .flac or raw .pcm)"));
 
     // Process the command line options and arguments given by the user
     parser.process(a);
@@ -77,6 +84,7 @@ int main(int argc, char *argv[])
 
     // Get the options from the parser
     bool isNonInteractiveOn = parser.isSet(nonInteractiveOption);
+    QString outputErrorMapFilename = parser.value(errorMapOption);
 
     // Get the arguments from the parser
     QString inputEfmFilename;
@@ -94,10 +102,15 @@ int main(int argc, char *argv[])
             qWarning() << "You must specify the input EFM filename and the output audio filename in non-interactive mode";
             return 1;
         }
+
+        if (!AudioSink::isFormatSupported(AudioSink::formatFromFilename(outputAudioFilename))) {
+            qWarning() << "This build of ld-process-efm does not support the output audio format";
+            return 1;
+        }
     }
 
     // Start the GUI application
-    MainWindow w(getDebugState(), isNonInteractiveOn, outputAudioFilename);
+    MainWindow w(getDebugState(), isNonInteractiveOn, outputAudioFilename, outputErrorMapFilename);
     if (!inputEfmFilename.isEmpty()) {
         // Load the file to decode
         if (!w.loadInputEfmFile(inputEfmFilename)) {
@@ -107,7 +120,7 @@ int main(int argc, char *argv[])
         } else {
             if (isNonInteractiveOn) {
                 // Start the decode
-                w.startDecodeNonInteractive();
+                if (!w.startDecodeNonInteractive()) return 1;
             }
         }
     }
@@ -25,12 +25,14 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
-MainWindow::MainWindow(bool debugOn, bool _nonInteractive, QString _outputAudioFilename, QWidget *parent) :
+MainWindow::MainWindow(bool debugOn, bool _nonInteractive, QString _outputAudioFilename,
+                       QString _outputErrorMapFilename, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
     nonInteractive = _nonInteractive;
     outputAudioFilename = _outputAudioFilename;
+    outputErrorMapFilename = _outputErrorMapFilename;
 
     // Initialise the GUI
     ui->setupUi(this);
@@ -88,9 +90,12 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
-void MainWindow::startDecodeNonInteractive()
+bool MainWindow::startDecodeNonInteractive()
 {
     on_decodePushButton_clicked();
+
+    // If the output couldn't be opened, processing won't have started
+    return audioOutputSink.isOpen();
 }
 
 // GUI update methods -------------------------------------------------------------------------------------------------
@@ -439,10 +444,14 @@ void MainWindow::on_actionSave_PCM_Audio_triggered()
 
     qDebug() << "MainWindow::on_actionSave_PCM_Audio_triggered(): filename suggestion is =" << filenameSuggestion;
 
+    QString fileTypes = tr("PCM raw audio (*.pcm);;WAV audio (*.wav)");
+    if (AudioSink::isFormatSupported(AudioSink::Format::flac)) fileTypes += tr(";;FLAC audio (*.flac)");
+    fileTypes += tr(";;All Files (*)");
+
     QString audioFilename = QFileDialog::getSaveFileName(this,
                 tr("Save PCM file"),
                 filenameSuggestion,
-                tr("PCM raw audio (*.pcm);;All Files (*)"));
+                fileTypes);
 
     // Was a filename specified?
     if (!audioFilename.isEmpty() && !audioFilename.isNull()) {
@@ -454,7 +463,7 @@ void MainWindow::on_actionSave_PCM_Audio_triggered()
         if (QFile::exists(audioFilename + tr(".json"))) QFile::remove(audioFilename + tr(".json"));
 
         // Copy the audio data from the temporary file to the destination
-        if (!audioOutputTemporaryFileHandle.copy(audioFilename)) {
+        if (!saveAudio(audioFilename)) {
             qDebug() << "MainWindow::on_actionSave_PCM_Audio_triggered(): Failed to save file as" << audioFilename;
 
             QMessageBox messageBox;
@@ -541,15 +550,8 @@ void MainWindow::on_decodePushButton_clicked()
         qDebug() << "MainWindow::on_decodePushButton_clicked(): Opened EFM input file";
     }
 
-    // Open temporary file for audio data
-    audioOutputTemporaryFileHandle.close();
-    if (audioOutputTemporaryFileHandle.exists()) audioOutputTemporaryFileHandle.remove();
-    if (!audioOutputTemporaryFileHandle.open()) {
-        // Failed to open file
-        qFatal("Could not open audio output temporary file - this is fatal!");
-    } else {
-        qDebug() << "MainWindow::on_decodePushButton_clicked(): Opened audio output temporary file";
-    }
+    // Open the audio output
+    if (!openAudioOutput()) return;
 
     // Open temporary file for data
     dataOutputTemporaryFileHandle.close();
@@ -587,7 +589,7 @@ void MainWindow::on_decodePushButton_clicked()
                                  ui->options_decodeAsData_checkbox->isChecked(), ui->options_noTimeStamp_checkBox->isChecked());
 
     // Start the processing of the EFM
-    efmProcess.startProcessing(&inputEfmFileHandle, &audioOutputTemporaryFileHandle,
+    efmProcess.startProcessing(&inputEfmFileHandle, &audioOutputSink,
                                &dataOutputTemporaryFileHandle);
 }
 
@@ -643,25 +645,15 @@ void MainWindow::on_options_decodeAsData_checkbox_clicked()
 // Local signal handling methods --------------------------------------------------------------------------------------
 
 // Handle processingComplete signal from EfmProcess class
-void MainWindow::processingCompleteSignalHandler(bool audioAvailable, bool dataAvailable)
+void MainWindow::processingCompleteSignalHandler(bool success, bool audioAvailable, bool dataAvailable)
 {
     if (audioAvailable) {
         qDebug() << "MainWindow::processingCompleteSignalHandler(): Processing complete - audio available";
         ui->actionSave_PCM_Audio->setEnabled(true);
 
-        // If in non-Interactive mode, autosave
+        // In non-interactive mode, the audio has been written directly to the output file
         if (nonInteractive) {
-            // Save the audio as PCM
-            qInfo() << "Saving audio as" << outputAudioFilename;
-
-            // Check if filename exists (and remove the file if it does)
-            if (QFile::exists(outputAudioFilename)) QFile::remove(outputAudioFilename);
-            if (QFile::exists(outputAudioFilename + tr(".json"))) QFile::remove(outputAudioFilename + tr(".json"));
-
-            // Copy the audio data from the temporary file to the destination
-            if (!audioOutputTemporaryFileHandle.copy(outputAudioFilename)) {
-                qWarning() << "MainWindow::processingCompleteSignalHandler(): Failed to save file as" << outputAudioFilename;
-            }
+            qInfo() << "Saved audio as" << outputAudioFilename;
         }
     }
 
@@ -674,12 +666,21 @@ void MainWindow::processingCompleteSignalHandler(bool audioAvailable, bool dataA
     efmProcess.reportStatistics();
 
     if (nonInteractive) {
-        // Quit the application
-        qApp->quit();
+        // Quit the application, failing if the output couldn't be written
+        if (!success) qCritical() << "Writing the output files failed";
+        qApp->exit(success ? 0 : 1);
+    } else if (!success) {
+        QMessageBox messageBox;
+        messageBox.warning(this, "Warning", "Writing the decoded output failed!");
+        messageBox.setFixedSize(500, 200);
     }
 
     // Update the GUI
     guiEfmProcessingStop();
+
+    // Close the non-interactive output files (the sink has finished with them)
+    audioOutputFileHandle.close();
+    errorMapFileHandle.close();
 }
 
 // Handle percent processed signal from EfmProcess class
@@ -747,5 +748,68 @@ bool MainWindow::loadInputEfmFile(QString filename)
     return true;
 }
 
+// Open the output for the audio data. In interactive mode this is written as raw
+// PCM to a temporary file, and converted when it is saved; in non-interactive mode
+// it's written directly to the output file in the format given by its extension.
+bool MainWindow::openAudioOutput()
+{
+    if (!nonInteractive) {
+        // Open temporary file for audio data
+        audioOutputTemporaryFileHandle.close();
+        if (audioOutputTemporaryFileHandle.exists()) audioOutputTemporaryFileHandle.remove();
+        if (!audioOutputTemporaryFileHandle.open()) {
+            // Failed to open file
+            qFatal("Could not open audio output temporary file - this is fatal!");
+        } else {
+            qDebug() << "MainWindow::openAudioOutput(): Opened audio output temporary file";
+        }
+
+        return audioOutputSink.open(&audioOutputTemporaryFileHandle, AudioSink::Format::pcm);
+    }
+
+    // Check if filename exists (and remove the file if it does)
+    if (QFile::exists(outputAudioFilename + tr(".json"))) QFile::remove(outputAudioFilename + tr(".json"));
+
+    audioOutputFileHandle.close();
+    audioOutputFileHandle.setFileName(outputAudioFilename);
+    if (!audioOutputFileHandle.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "Could not open audio output file" << outputAudioFilename;
+        return false;
+    }
+
+    QIODevice *errorMapDevice = nullptr;
+    if (!outputErrorMapFilename.isEmpty()) {
+        errorMapFileHandle.close();
+        errorMapFileHandle.setFileName(outputErrorMapFilename);
+        if (!errorMapFileHandle.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            qWarning() << "Could not open error map output file" << outputErrorMapFilename;
+            return false;
+        }
+        errorMapDevice = &errorMapFileHandle;
+    }
+
+    return audioOutputSink.open(&audioOutputFileHandle, AudioSink::formatFromFilename(outputAudioFilename), errorMapDevice);
+}
+
+// Save the audio from the temporary file, converting it to the format given by
+// the filename's extension
+bool MainWindow::saveAudio(QString audioFilename)
+{
+    AudioSink::Format format = AudioSink::formatFromFilename(audioFilename);
+    if (format == AudioSink::Format::pcm) return audioOutputTemporaryFileHandle.copy(audioFilename);
+
+    QFile inputFileHandle(audioOutputTemporaryFileHandle.fileName());
+    if (!inputFileHandle.open(QIODevice::ReadOnly)) return false;
+
+    QFile outputFileHandle(audioFilename);
+    if (!outputFileHandle.open(QIODevice::ReadWrite | QIODevice::Truncate)) return false;
 
+    AudioSink sink;
+    if (!sink.open(&outputFileHandle, format)) return false;
 
+    while (!inputFileHandle.atEnd()) {
+        sink.write(inputFileHandle.read(1024 * 1024), QVector<F1ToAudio::ErrorRange>());
+    }
+
+    return sink.close();
+}
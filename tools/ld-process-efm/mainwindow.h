@@ -50,14 +50,15 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(bool debugOn, bool _nonInteractive, QString _outputAudioFilename, QWidget *parent = nullptr);
+    explicit MainWindow(bool debugOn, bool _nonInteractive, QString _outputAudioFilename,
+                        QString _outputErrorMapFilename, QWidget *parent = nullptr);
     ~MainWindow();
 
     bool loadInputEfmFile(QString filename);
-    void startDecodeNonInteractive();
+    bool startDecodeNonInteractive();
 
 private slots:
-    void processingCompleteSignalHandler(bool audioAvailable, bool dataAvailable);
+    void processingCompleteSignalHandler(bool success, bool audioAvailable, bool dataAvailable);
     void percentProcessedSignalHandler(qint32 percent);
     void updateStatistics();
 
@@ -86,9 +87,13 @@ private:
     QFile inputEfmFileHandle;
     QTemporaryFile audioOutputTemporaryFileHandle;
     QTemporaryFile dataOutputTemporaryFileHandle;
+    QFile audioOutputFileHandle;
+    QFile errorMapFileHandle;
+    AudioSink audioOutputSink;
     QTimer statisticsUpdateTimer;
     bool nonInteractive;
     QString outputAudioFilename;
+    QString outputErrorMapFilename;
 
     // Method prototypes
     void guiNoEfmFileLoaded();
@@ -98,6 +103,8 @@ private:
 
     void resetStatistics();
     void resetDecoderOptions();
+    bool openAudioOutput();
+    bool saveAudio(QString audioFilename);
 };
 
 #endif // MAINWINDOW_H
@@ -59,6 +59,7 @@ bool DecoderPool::process()
     inputFieldNumber = 1;
     lastFieldNumber = ldDecodeMetaData.getNumberOfFields();
     totalTimer.start();
+    statistics.start(maxThreads);
 
     // Start a vector of decoding threads to process the video
     QVector<QThread *> threads;
@@ -84,6 +85,7 @@ bool DecoderPool::process()
     qreal totalSecs = (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
     qInfo() << "VBI Processing complete -" << lastFieldNumber << "fields in" << totalSecs << "seconds (" <<
                lastFieldNumber / totalSecs << "FPS )";
+    statistics.finish("fields");
 
     // Write the JSON metadata file
     qInfo() << "Writing JSON metadata file...";
@@ -96,6 +98,11 @@ bool DecoderPool::process()
     return true;
 }
 
+PoolStatistics &DecoderPool::getStatistics()
+{
+    return statistics;
+}
+
 // Get the next field that needs processing from the input.
 //
 // Returns true if a field was returned, false if the end of the input has been
@@ -103,7 +110,9 @@ bool DecoderPool::process()
 bool DecoderPool::getInputField(qint32 &fieldNumber, SourceVideo::Data &fieldVideoData,
                                 LdDecodeMetaData::Field &fieldMetadata, LdDecodeMetaData::VideoParameters &videoParameters)
 {
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::inputWaitStage);
     QMutexLocker locker(&inputMutex);
+    waitTimer.stop();
 
     if (inputFieldNumber > lastFieldNumber) {
         // No more input fields
@@ -117,6 +126,7 @@ bool DecoderPool::getInputField(qint32 &fieldNumber, SourceVideo::Data &fieldVid
     qDebug() << "DecoderPool::process(): Processing field number" << fieldNumber;
 
     // Fetch the input data
+    PoolStatistics::Timer readTimer(statistics, PoolStatistics::readStage);
     fieldVideoData = sourceVideo.getVideoField(fieldNumber, VbiLineDecoder::startFieldLine, VbiLineDecoder::endFieldLine);
     fieldMetadata = ldDecodeMetaData.getField(fieldNumber);
     videoParameters = ldDecodeMetaData.getVideoParameters();
@@ -129,11 +139,18 @@ bool DecoderPool::getInputField(qint32 &fieldNumber, SourceVideo::Data &fieldVid
 // Returns true on success, false on failure.
 bool DecoderPool::setOutputField(qint32 fieldNumber, LdDecodeMetaData::Field fieldMetadata)
 {
+    PoolStatistics::Timer waitTimer(statistics, PoolStatistics::outputWaitStage);
     QMutexLocker locker(&outputMutex);
+    waitTimer.stop();
 
     // Save the field data to the metadata (only VBI and NTSC metadata is affected)
+    PoolStatistics::Timer writeTimer(statistics, PoolStatistics::writeStage);
     ldDecodeMetaData.updateFieldVbi(fieldMetadata.vbi, fieldNumber);
     ldDecodeMetaData.updateFieldNtsc(fieldMetadata.ntsc, fieldNumber);
+    writeTimer.stop();
+
+    // Fields are stored directly into the metadata, so there's no reorder buffer
+    statistics.recordOutput(1, 0);
 
     return true;
 }
@@ -32,6 +32,7 @@
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "poolstatistics.h"
 #include "vbilinedecoder.h"
 
 class DecoderPool
@@ -42,6 +43,10 @@ public:
                         qint32 _maxThreads, LdDecodeMetaData &_ldDecodeMetaData);
     bool process();
 
+    // Get the timing statistics for this pool. These are disabled unless
+    // enabled before process() is called.
+    PoolStatistics &getStatistics();
+
     // Member functions used by worker threads
     bool getInputField(qint32 &fieldNumber, SourceVideo::Data &fieldVideoData, LdDecodeMetaData::Field &fieldMetadata, LdDecodeMetaData::VideoParameters &videoParameters);
     bool setOutputField(qint32 fieldNumber, LdDecodeMetaData::Field fieldMetadata);
@@ -66,6 +71,9 @@ private:
     // Output stream information (all guarded by outputMutex while threads are running)
     QMutex outputMutex;
     QFile targetJson;
+
+    // Timing statistics
+    PoolStatistics statistics;
 };
 
 #endif // DECODERPOOL_H
@@ -22,6 +22,7 @@ SOURCES += \
     vbilinedecoder.cpp \
     whiteflag.cpp \
     ../library/tbc/lddecodemetadata.cpp \
+    ../library/tbc/poolstatistics.cpp \
     ../library/tbc/sourcevideo.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp
@@ -33,6 +34,7 @@ HEADERS += \
     vbilinedecoder.h \
     whiteflag.h \
     ../library/tbc/lddecodemetadata.h \
+    ../library/tbc/poolstatistics.h \
     ../library/tbc/sourcevideo.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h
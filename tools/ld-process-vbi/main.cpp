@@ -29,6 +29,7 @@
 #include <QThread>
 
 #include "logging.h"
+#include "poolstatistics.h"
 #include "decoderpool.h"
 
 int main(int argc, char *argv[])
@@ -57,6 +58,9 @@ int main(int argc, char *argv[])
     // Add the standard debug options --debug and --quiet
     addStandardDebugOptions(parser);
 
+    // Add the standard statistics options --stats and --stats-json
+    addStandardStatisticsOptions(parser);
+
     // Option to specify a different JSON input file
     QCommandLineOption inputJsonOption(QStringList() << "input-json",
                                        QCoreApplication::translate("main", "Specify the input JSON file (default input.json)"),
@@ -144,6 +148,7 @@ int main(int argc, char *argv[])
     // Perform the processing
     qInfo() << "Beginning VBI processing...";
     DecoderPool decoderPool(inputFilename, outputJsonFilename, maxThreads, metaData);
+    if (!processStandardStatisticsOptions(parser, decoderPool.getStatistics())) return 1;
     if (!decoderPool.process()) return 1;
 
     // Quit with success
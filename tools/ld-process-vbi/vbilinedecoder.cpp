@@ -53,6 +53,8 @@ void VbiLineDecoder::run()
             break;
         }
 
+        PoolStatistics::Timer processTimer(decoderPool.getStatistics(), PoolStatistics::processStage);
+
         FmCode fmCode;
         FmCode::FmDecode fmDecode;
 
@@ -118,6 +120,7 @@ void VbiLineDecoder::run()
 
         // Update the metadata for the field
         fieldMetadata.vbi.inUse = true;
+        processTimer.stop();
 
         // Write the result to the output metadata
         if (!decoderPool.setOutputField(fieldNumber, fieldMetadata)) {
@@ -27,6 +27,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <vector>
+
+// The in-place filter uses SSE2 (which all x86-64 CPUs have) when the
+// compiler has it enabled
+#if defined(__SSE2__)
+#define FIRFILTER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
 
 // A FIR filter with arbitrary coefficients. The number of taps must be odd.
 //
@@ -109,15 +117,115 @@ public:
     template <typename Container>
     void apply(Container &data) const
     {
-        Container tmp(data.size());
-        apply(data, tmp);
-        data = tmp;
+        applyInPlace(data.data(), data.size());
+    }
+
+    // Apply the filter to a range of samples in data of length numSamples,
+    // writing the result back over the input.
+    //
+    // The data is filtered as one continuous signal, but it's processed in
+    // short blocks so only a block's worth of working space is needed.
+    // If the coefficients are symmetric (as for a linear-phase filter), pairs
+    // of input samples are added before multiplying, and if allowSimd is true
+    // double-precision filters are vectorised using SSE2 where available.
+    //
+    // Samples outside the range of the input are assumed to be 0. The result
+    // may differ from apply(input, output) by rounding error.
+    template <typename Sample>
+    void applyInPlace(Sample *data, int numSamples, bool allowSimd = true) const
+    {
+        typedef typename Coeffs::value_type Value;
+
+        const int numTaps = coeffs.size();
+        const int overlap = numTaps / 2;
+        assert((numTaps % 2) == 1);
+
+        const bool isSymmetric = std::equal(coeffs.begin(), coeffs.begin() + overlap, coeffs.rbegin());
+
+        // The buffer holds the unfiltered input for the current block, with
+        // overlap samples of history before it and lookahead after it
+        std::vector<Value> buffer(BLOCK_SIZE + 2 * overlap);
+        std::vector<Value> output(BLOCK_SIZE);
+
+        for (int start = 0; start < numSamples; start += BLOCK_SIZE) {
+            const int blockLength = std::min(BLOCK_SIZE, numSamples - start);
+
+            // Copy the block and the following overlap samples into the buffer
+            for (int i = 0; i < blockLength + overlap; i++) {
+                const int k = start + i;
+                buffer[overlap + i] = (k < numSamples) ? static_cast<Value>(data[k]) : 0;
+            }
+
+            int i = 0;
+            if (isSymmetric) {
+                if (allowSimd) i = applySymmetricSimd(buffer.data(), output.data(), blockLength);
+                for (; i < blockLength; i++) {
+                    const Value *in = buffer.data() + i;
+                    Value v = coeffs[overlap] * in[overlap];
+                    for (int j = 0; j < overlap; j++) {
+                        v += coeffs[j] * (in[j] + in[numTaps - 1 - j]);
+                    }
+                    output[i] = v;
+                }
+            } else {
+                for (; i < blockLength; i++) {
+                    const Value *in = buffer.data() + i;
+                    Value v = 0;
+                    for (int j = 0; j < numTaps; j++) {
+                        v += coeffs[j] * in[j];
+                    }
+                    output[i] = v;
+                }
+            }
+
+            // Keep the unfiltered input from the end of this block as the
+            // history for the next one, then write the output over the input
+            std::copy(buffer.begin() + blockLength, buffer.begin() + blockLength + overlap, buffer.begin());
+            for (i = 0; i < blockLength; i++) {
+                data[start + i] = output[i];
+            }
+        }
     }
 
 private:
     const Coeffs &coeffs;
+
+    // Number of samples processed at once by applyInPlace
+    static constexpr int BLOCK_SIZE = 256;
+
+    // Vectorised inner loop for applyInPlace with a symmetric filter.
+    // Returns the number of output samples computed.
+    template <typename Value>
+    int applySymmetricSimd(const Value *, Value *, int) const
+    {
+        return 0;
+    }
+
+#ifdef FIRFILTER_HAVE_SSE2
+    int applySymmetricSimd(const double *buffer, double *output, int numSamples) const
+    {
+        const int numTaps = coeffs.size();
+        const int overlap = numTaps / 2;
+
+        int i = 0;
+        for (; i + 2 <= numSamples; i += 2) {
+            const double *in = buffer + i;
+            __m128d v = _mm_mul_pd(_mm_set1_pd(coeffs[overlap]), _mm_loadu_pd(in + overlap));
+            for (int j = 0; j < overlap; j++) {
+                const __m128d pair = _mm_add_pd(_mm_loadu_pd(in + j), _mm_loadu_pd(in + numTaps - 1 - j));
+                v = _mm_add_pd(v, _mm_mul_pd(_mm_set1_pd(coeffs[j]), pair));
+            }
+            _mm_storeu_pd(output + i, v);
+        }
+
+        return i;
+    }
+#endif
 };
 
+template <typename Coeffs>
+constexpr int FIRFilter<Coeffs>::BLOCK_SIZE;
+
 // Helper for declaring FIRFilter instances with auto.
 // e.g. constexpr auto myFilter = makeFIRFilter(myFilterCoeffs);
 template <typename Coeffs>
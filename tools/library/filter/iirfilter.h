@@ -27,6 +27,7 @@
 #ifndef IIRFILTER_H
 #define IIRFILTER_H
 
+#include <algorithm>
 #include <cassert>
 #include <array>
 #include <vector>
@@ -80,7 +81,73 @@ public:
         return y[0];
     }
 
+    // Feed numSamples input values from inputData into the filter, writing
+    // the output values to outputData (which may be the same as inputData).
+    //
+    // This gives the same results as calling feed() for each value, and
+    // leaves the filter in the same state. For FIR filters, rather than
+    // shifting the input history for every sample, it works on blocks of
+    // samples with the history in front of them, computing several outputs
+    // at once so they can be pipelined or vectorised.
+    void apply(const double *inputData, double *outputData, int numSamples) {
+        if (aOrder > 1) {
+            // For recursive filters, the feedback has to be computed one
+            // sample at a time, and that dominates the cost -- so there is
+            // nothing to be gained over feed()
+            for (int i = 0; i < numSamples; i++) outputData[i] = feed(inputData[i]);
+            return;
+        }
+
+        // Input values, oldest first: the history followed by the current block
+        std::array<double, bOrder + BLOCK_SIZE> xs;
+        for (unsigned i = 0; i < bOrder; i++) xs[i] = x[bOrder - 1 - i];
+
+        for (int start = 0; start < numSamples; start += BLOCK_SIZE) {
+            const int blockLength = (numSamples - start < BLOCK_SIZE) ? (numSamples - start) : BLOCK_SIZE;
+
+            for (int i = 0; i < blockLength; i++) xs[bOrder + i] = inputData[start + i];
+
+            // Sum in the same order as feed(), computing four outputs at a time
+            const double *xBlock = xs.data() + bOrder;
+            double *out = outputData + start;
+            int i = 0;
+            for (; i + 4 <= blockLength; i += 4) {
+                double v0 = b[0] * xBlock[i];
+                double v1 = b[0] * xBlock[i + 1];
+                double v2 = b[0] * xBlock[i + 2];
+                double v3 = b[0] * xBlock[i + 3];
+                for (int j = bOrder - 1; j >= 1; j--) {
+                    const double *xj = xBlock + i - j;
+                    v0 += b[j] * xj[0];
+                    v1 += b[j] * xj[1];
+                    v2 += b[j] * xj[2];
+                    v3 += b[j] * xj[3];
+                }
+                out[i] = v0;
+                out[i + 1] = v1;
+                out[i + 2] = v2;
+                out[i + 3] = v3;
+            }
+            for (; i < blockLength; i++) {
+                double v = b[0] * xBlock[i];
+                for (int j = bOrder - 1; j >= 1; j--) {
+                    v += b[j] * xBlock[i - j];
+                }
+                out[i] = v;
+            }
+
+            // Move the end of the block to the front as the next block's history
+            std::copy(xs.begin() + blockLength, xs.begin() + blockLength + bOrder, xs.begin());
+        }
+
+        for (unsigned i = 0; i < bOrder; i++) x[i] = xs[bOrder - 1 - i];
+        if (numSamples > 0) y[0] = outputData[numSamples - 1];
+    }
+
 private:
+    // Number of samples processed at once by apply
+    enum { BLOCK_SIZE = 256 };
+
     // Feedforward (input) coefficients
     std::array<double, bOrder> b;
     // Feedback (output) coefficients
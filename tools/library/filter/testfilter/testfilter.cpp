@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
@@ -35,6 +36,8 @@
 
 using std::array;
 using std::cerr;
+using std::chrono::duration;
+using std::chrono::steady_clock;
 using std::fill;
 using std::string;
 using std::to_string;
@@ -117,6 +120,48 @@ void testIIRFilter(const char *name, FN& fn, FO& fo)
     }
 }
 
+// Check that IIRFilter's block apply gives the same results as feed, and
+// leaves the filter in the same state.
+template <typename F>
+void testIIRBlock(const char *name, const F &filter)
+{
+    cerr << "Testing IIRFilter block: " << name << "\n";
+
+    // Lengths either side of IIRFilter's block size, in a sequence of calls
+    // with some individual samples in between
+    const int lengths[] = {0, 1, 5, 255, 256, 257, 700};
+
+    F fn(filter), fo(filter);
+    vector<double> input, output;
+    int count = 0;
+
+    for (int length : lengths) {
+        input.resize(length);
+        output.resize(length);
+        for (int i = 0; i < length; i++) {
+            input[i] = ((count + i) * 37) % 101 - 50;
+        }
+
+        fn.apply(input.data(), output.data(), length);
+        for (int i = 0; i < length; i++) {
+            const double out_o = fo.feed(input[i]);
+            if (output[i] != out_o) {
+                cerr << "Mismatch on " << name << " at " << count + i << ": " << input[i] << " -> " << output[i] << ", " << out_o << "\n";
+                exit(1);
+            }
+        }
+        count += length;
+
+        const double out_n = fn.feed(count);
+        const double out_o = fo.feed(count);
+        if (out_n != out_o) {
+            cerr << "Mismatch on " << name << " after block at " << count << ": " << out_n << ", " << out_o << "\n";
+            exit(1);
+        }
+        count++;
+    }
+}
+
 // Test IIRFilter for the sets of coefficients used in the code
 void testIIRFilters()
 {
@@ -143,6 +188,13 @@ void testIIRFilters()
     auto f5(f_a40h_48k);
     SimpleFilter g5(c_a40h_48k_b, c_a40h_48k_a);
     testIIRFilter("a40h_48k", f5, g5);
+
+    testIIRBlock("colorlpi", f_colorlpi);
+    testIIRBlock("nrc", f_nrc);
+    testIIRBlock("nr", f_nr);
+    testIIRBlock("a500_48k", f_a500_48k);
+    testIIRBlock("boost", f_boost);
+    testIIRBlock("audioin", f_audioin);
 }
 
 // Check that FIRFilter's output matches SimpleFilter in FIR mode.
@@ -239,6 +291,31 @@ void testFIRCoeffs(const string &name, const Coeffs &coeffs)
     fill(output.begin(), output.end(), 0);
     f.apply(input16, output);
     testFIRFilter(name + " int16_t->double", input16, output, coeffs);
+
+    // In-place filtering of vectors longer than FIRFilter's block size, with
+    // and without SIMD
+
+    input.clear();
+    for (int i = 0; i < 1000; i++) {
+        input.push_back((i * 37) % 101);
+    }
+
+    output = input;
+    f.applyInPlace(output.data(), output.size(), false);
+    testFIRFilter(name + " long in-place scalar", input, output, coeffs);
+
+    output = input;
+    f.applyInPlace(output.data(), output.size(), true);
+    testFIRFilter(name + " long in-place SIMD", input, output, coeffs);
+
+    // uint16_t vectors (for filters that can't produce negative output from positive input)
+
+    if (std::all_of(coeffs.begin(), coeffs.end(), [](double c) { return c >= 0; })) {
+        vector<uint16_t> inputU16(input.begin(), input.end()), outputU16;
+        outputU16 = inputU16;
+        f.applyInPlace(outputU16.data(), outputU16.size());
+        testFIRFilter(name + " long uint16_t in-place", inputU16, outputU16, coeffs, 1);
+    }
 }
 
 // Test FIRFilter
@@ -255,12 +332,115 @@ void testFIRFilters()
 
     assert(c_a500_44k_a.size() == 1);
     testFIRCoeffs("a500_44k", c_a500_44k_b);
+
+    // Symmetric filters, as used for the luma filters in the TBC library
+    const array<double, 5> lumaCoeffs {0.03283437, 0.23959832, 0.45513461, 0.23959832, 0.03283437};
+    testFIRCoeffs("luma", lumaCoeffs);
 }
 
-int main()
+// Time a function, returning the best time in milliseconds over several runs
+template <typename F>
+double timeBest(F fn)
+{
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        const auto start = steady_clock::now();
+        fn();
+        const double ms = duration<double, std::milli>(steady_clock::now() - start).count();
+        if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// Compare the speed of IIRFilter's per-sample feed and block apply
+template <typename F>
+void benchmarkIIRFilter(const char *name, const F &filter)
+{
+    const int numSamples = 4000000;
+    vector<double> input(numSamples), output(numSamples);
+    for (int i = 0; i < numSamples; i++) {
+        input[i] = (i * 37) % 101 - 50;
+    }
+
+    cerr << "Benchmarking IIRFilter: " << name << ", " << numSamples << " samples\n";
+
+    const double feedTime = timeBest([&] {
+        F f(filter);
+        for (int i = 0; i < numSamples; i++) output[i] = f.feed(input[i]);
+    });
+    cerr << "  feed:  " << feedTime << " ms\n";
+
+    const double applyTime = timeBest([&] {
+        F f(filter);
+        f.apply(input.data(), output.data(), numSamples);
+    });
+    cerr << "  apply: " << applyTime << " ms\n";
+}
+
+void benchmarkIIRFilters()
+{
+    benchmarkIIRFilter("boost (33, 1)", f_boost);
+    benchmarkIIRFilter("nrc (17, 1)", f_nrc);
+    benchmarkIIRFilter("audioin (9, 9)", f_audioin);
+    benchmarkIIRFilter("colorlpi (2, 2)", f_colorlpi);
+}
+
+// Compare the speed of the ways of filtering a field of uint16_t samples,
+// using the PAL luma filter as ld-diffdod does
+void benchmarkFIRFilters()
+{
+    static constexpr array<double, 5> lumaCoeffs {0.03283437, 0.23959832, 0.45513461, 0.23959832, 0.03283437};
+    const auto f = makeFIRFilter(lumaCoeffs);
+
+    // 50 PAL fields worth of data
+    const int fieldLength = 1135 * 313;
+    const int numFields = 50;
+    vector<uint16_t> input(fieldLength);
+    for (int i = 0; i < fieldLength; i++) {
+        input[i] = static_cast<uint16_t>(16384 + ((i % 4096) * 7919) % 32768);
+    }
+    vector<uint16_t> data;
+
+    cerr << "Benchmarking FIRFilter: " << numFields << " fields of " << fieldLength << " samples\n";
+
+    // The original approach: filter into a temporary buffer and copy back
+    const double copyTime = timeBest([&] {
+        for (int field = 0; field < numFields; field++) {
+            data = input;
+            vector<uint16_t> tmp(data.size());
+            f.apply(data.data(), tmp.data(), data.size());
+            std::copy(tmp.begin(), tmp.end(), data.begin());
+        }
+    });
+    cerr << "  apply + copy:         " << copyTime << " ms\n";
+
+    const double scalarTime = timeBest([&] {
+        for (int field = 0; field < numFields; field++) {
+            data = input;
+            f.applyInPlace(data.data(), data.size(), false);
+        }
+    });
+    cerr << "  applyInPlace, scalar: " << scalarTime << " ms\n";
+
+    const double simdTime = timeBest([&] {
+        for (int field = 0; field < numFields; field++) {
+            data = input;
+            f.applyInPlace(data.data(), data.size(), true);
+        }
+    });
+    cerr << "  applyInPlace, SIMD:   " << simdTime << " ms\n";
+}
+
+int main(int argc, char *argv[])
 {
     testIIRFilters();
     testFIRFilters();
 
+    // The benchmarks are only run if requested
+    if (argc > 1 && string(argv[1]) == "--benchmark") {
+        benchmarkIIRFilters();
+        benchmarkFIRFilters();
+    }
+
     return 0;
 }
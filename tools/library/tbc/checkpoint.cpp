@@ -0,0 +1,187 @@
+/************************************************************************
+
+    checkpoint.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "checkpoint.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Sidecar checkpoint file identification
+static const quint32 CHECKPOINT_MAGIC = 0x434B5054; // "CKPT"
+static const quint32 CHECKPOINT_VERSION = 2;
+
+// Interval between checkpoints
+static const qint64 CHECKPOINT_INTERVAL_MSECS = 10000;
+
+Checkpoint::Checkpoint()
+    : enabled(false)
+{
+}
+
+void Checkpoint::enable(const QString &outputFileName, const QByteArray &_runKey)
+{
+    checkpointFileName = outputFileName + ".checkpoint";
+    runKey = _runKey;
+    enabled = true;
+}
+
+bool Checkpoint::isEnabled() const
+{
+    return enabled;
+}
+
+bool Checkpoint::read(qint32 &lastFrame, qint64 &outputBytes) const
+{
+    QFile checkpointFile(checkpointFileName);
+    if (!checkpointFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Cannot resume - checkpoint file" << checkpointFileName << "could not be opened";
+        return false;
+    }
+
+    QDataStream stream(&checkpointFile);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    QByteArray key;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION) {
+        qCritical() << "Cannot resume - checkpoint file" << checkpointFileName << "is not valid";
+        return false;
+    }
+
+    stream >> key;
+    if (key != runKey) {
+        qCritical() << "Cannot resume - checkpoint file" << checkpointFileName << "was written with different input or options";
+        return false;
+    }
+
+    stream >> lastFrame >> outputBytes;
+    if (stream.status() != QDataStream::Ok || lastFrame < 0 || outputBytes < 0) {
+        qCritical() << "Cannot resume - checkpoint file" << checkpointFileName << "is corrupt";
+        return false;
+    }
+
+    return true;
+}
+
+void Checkpoint::start()
+{
+    intervalTimer.start();
+}
+
+bool Checkpoint::isDue() const
+{
+    return enabled && intervalTimer.hasExpired(CHECKPOINT_INTERVAL_MSECS);
+}
+
+bool Checkpoint::write(QFile &outputFile, qint32 lastFrame, qint64 outputBytes)
+{
+    intervalTimer.start();
+
+    // Make sure the output up to this point is on disk before the checkpoint
+    // says it is. QFile::flush() only passes the data to the OS, so it could
+    // still be lost in a crash or power failure after the checkpoint is saved.
+    if (!outputFile.flush() || !syncToDisk(outputFile)) {
+        qWarning() << "Could not sync output file" << outputFile.fileName() << "for checkpoint";
+        return false;
+    }
+
+    // Write to a temporary file which then replaces the old checkpoint, so
+    // there's always a complete checkpoint even if we're interrupted here
+    QSaveFile checkpointFile(checkpointFileName);
+    if (!checkpointFile.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not open checkpoint file" << checkpointFileName;
+        return false;
+    }
+
+    QDataStream stream(&checkpointFile);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << CHECKPOINT_MAGIC << CHECKPOINT_VERSION << runKey;
+    stream << lastFrame << outputBytes;
+
+    if (stream.status() != QDataStream::Ok || !checkpointFile.commit()) {
+        qWarning() << "Could not write checkpoint file" << checkpointFileName;
+        return false;
+    }
+
+    qDebug() << "Checkpoint::write(): Wrote checkpoint at frame" << lastFrame << "with" << outputBytes << "bytes of output";
+    return true;
+}
+
+// Wait for the OS to write a file's data to disk
+bool Checkpoint::syncToDisk(QFile &file)
+{
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+void Checkpoint::remove()
+{
+    if (enabled) {
+        QFile::remove(checkpointFileName);
+    }
+}
+
+QByteArray Checkpoint::makeRunKey(const QCommandLineParser &parser, QList<QCommandLineOption> outputOptions)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    // Hash the options in a fixed order, each under its first name, so the
+    // key doesn't depend on how or in what order they were given
+    std::sort(outputOptions.begin(), outputOptions.end(), [](const QCommandLineOption &a, const QCommandLineOption &b) {
+        return a.names().first() < b.names().first();
+    });
+
+    for (const QCommandLineOption &option : outputOptions) {
+        hash.addData(option.names().first().toUtf8());
+        hash.addData(parser.isSet(option) ? "+" : "-", 1);
+        for (const QString &value : parser.values(option)) {
+            hash.addData("=", 1);
+            hash.addData(value.toUtf8());
+        }
+        hash.addData("\n", 1);
+    }
+
+    for (const QString &argument : parser.positionalArguments()) {
+        hash.addData(argument.toUtf8());
+        hash.addData("\n", 1);
+    }
+
+    return hash.result();
+}
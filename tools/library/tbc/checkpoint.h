@@ -0,0 +1,92 @@
+/************************************************************************
+
+    checkpoint.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <QByteArray>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+// Checkpoint for a long-running tool that writes frames to an output file in
+// order (ld-chroma-decoder's DecoderPool and ld-dropout-correct's
+// CorrectorPool).
+//
+// While processing, the pool periodically records the last frame that has
+// been completely written, and the size of the output file at that point, in
+// a sidecar file next to the output. If the run is interrupted, it can be
+// resumed from the frame after that one.
+//
+// The checkpoint is keyed by a hash of the run's settings, so a checkpoint is
+// only used by a run with the same input and options. It is removed once the
+// run completes successfully.
+class Checkpoint
+{
+public:
+    Checkpoint();
+
+    // Enable checkpoints for outputFileName. runKey identifies the settings
+    // for this run (see makeRunKey).
+    void enable(const QString &outputFileName, const QByteArray &runKey);
+    bool isEnabled() const;
+
+    // Read the checkpoint, returning the last frame written and the size of
+    // the output file at that point.
+    // Returns true on success; on failure, prints a message and returns false.
+    bool read(qint32 &lastFrame, qint64 &outputBytes) const;
+
+    // Start the interval timer. A checkpoint is due once the interval has
+    // elapsed since start() or the last write().
+    void start();
+    bool isDue() const;
+
+    // Write a checkpoint, replacing the previous one. outputFile is flushed
+    // and synced to disk first, so the checkpoint isn't saved until the
+    // output it describes has been.
+    // Returns true on success; on failure, prints a message and returns false.
+    bool write(QFile &outputFile, qint32 lastFrame, qint64 outputBytes);
+
+    // Remove the checkpoint, once the run is complete
+    void remove();
+
+    // Make a run key from the values of outputOptions and the positional
+    // arguments given on the command line. outputOptions should list every
+    // option that affects the output; options that don't (such as the number
+    // of threads, logging and statistics) can change between runs.
+    static QByteArray makeRunKey(const QCommandLineParser &parser, QList<QCommandLineOption> outputOptions);
+
+private:
+    bool enabled;
+    QString checkpointFileName;
+    QByteArray runKey;
+    QElapsedTimer intervalTimer;
+
+    static bool syncToDisk(QFile &file);
+};
+
+#endif // CHECKPOINT_H
@@ -54,14 +54,7 @@ static constexpr auto ntscLumaFilter = makeFIRFilter(ntscLumaFilterCoeffs);
 // the same array
 void Filters::palLumaFirFilter(quint16 *data, qint32 dataPoints)
 {
-    // Filter into a temporary buffer
-    QVector<quint16> tmp(dataPoints);
-    palLumaFilter.apply(data, tmp.data(), dataPoints);
-
-    // Copy the result over the original array
-    for (qint32 i = 0; i < dataPoints; i++) {
-        data[i] = tmp[i];
-    }
+    palLumaFilter.applyInPlace(data, dataPoints);
 }
 
 // Apply a FIR filter to remove PAL chroma leaving just luma
@@ -77,14 +70,7 @@ void Filters::palLumaFirFilter(QVector<qint32> &data)
 // the same array
 void Filters::ntscLumaFirFilter(quint16 *data, qint32 dataPoints)
 {
-    // Filter into a temporary buffer
-    QVector<quint16> tmp(dataPoints);
-    ntscLumaFilter.apply(data, tmp.data(), dataPoints);
-
-    // Copy the result over the original array
-    for (qint32 i = 0; i < dataPoints; i++) {
-        data[i] = tmp[i];
-    }
+    ntscLumaFilter.applyInPlace(data, dataPoints);
 }
 
 // Apply a FIR filter to remove NTSC chroma leaving just luma
@@ -0,0 +1,217 @@
+/************************************************************************
+
+    poolstatistics.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "poolstatistics.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Interval between JSON lines
+static const qint64 JSON_INTERVAL_NSECS = 1000000000;
+
+// Names for the stages, used as JSON keys
+static const char *const STAGE_NAMES[PoolStatistics::numStages] = {
+    "inputWait", "read", "process", "outputWait", "write"
+};
+
+// Descriptions for the stages, used in the summary
+static const char *const STAGE_DESCRIPTIONS[PoolStatistics::numStages] = {
+    "Waiting for input lock", "Reading input", "Processing", "Waiting for output lock", "Writing output"
+};
+
+// Define the standard statistics command line options
+static QCommandLineOption showStatisticsOption(QStringList() << "stats",
+                                               QCoreApplication::translate("main", "Show timing statistics for each stage of processing"));
+static QCommandLineOption statisticsJsonOption(QStringList() << "stats-json",
+                                               QCoreApplication::translate("main", "Write timing statistics to a file as JSON lines while processing (implies --stats)"),
+                                               QCoreApplication::translate("main", "filename"));
+
+PoolStatistics::PoolStatistics()
+    : enabled(false), numThreads(1), lastJsonNsecs(0), itemsWritten(0), outputSamples(0),
+      totalPendingItems(0), currentPendingItems(0), maxPendingItems(0)
+{
+}
+
+bool PoolStatistics::enable(const QString &jsonFileName)
+{
+    if (!jsonFileName.isEmpty()) {
+        jsonFile.setFileName(jsonFileName);
+        if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qCritical() << "Could not open" << jsonFileName << "for statistics output";
+            return false;
+        }
+    }
+
+    enabled = true;
+    return true;
+}
+
+bool PoolStatistics::isEnabled() const
+{
+    return enabled;
+}
+
+void PoolStatistics::start(qint32 _numThreads)
+{
+    numThreads = _numThreads;
+
+    for (qint32 stage = 0; stage < numStages; stage++) {
+        stageNsecs[stage].store(0);
+    }
+    itemsWritten = 0;
+    outputSamples = 0;
+    totalPendingItems = 0;
+    currentPendingItems = 0;
+    maxPendingItems = 0;
+
+    lastJsonNsecs = 0;
+    totalTimer.start();
+}
+
+void PoolStatistics::finish(const char *itemName)
+{
+    if (!enabled) {
+        return;
+    }
+
+    if (jsonFile.isOpen()) {
+        writeJsonLine();
+        jsonFile.close();
+    }
+
+    // Express each stage as a fraction of the total time available to the
+    // threads, so it's easy to see where it went
+    const qint64 totalNsecs = totalTimer.nsecsElapsed();
+    const double threadNsecs = static_cast<double>(totalNsecs) * numThreads;
+
+    qInfo().nospace() << "Timing statistics for " << itemsWritten << " " << itemName << " using "
+                      << numThreads << " threads in " << totalNsecs / 1.0e9 << " seconds:";
+    for (qint32 stage = 0; stage < numStages; stage++) {
+        const qint64 nsecs = stageNsecs[stage].load();
+        qInfo().nospace() << "  " << STAGE_DESCRIPTIONS[stage] << ": " << nsecs / 1.0e9 << " thread-seconds ("
+                          << (100.0 * nsecs) / threadNsecs << "%)";
+    }
+    if (outputSamples > 0) {
+        qInfo().nospace() << "  Reorder buffer: mean " << static_cast<double>(totalPendingItems) / outputSamples
+                          << ", max " << maxPendingItems << " " << itemName << " pending";
+    }
+}
+
+void PoolStatistics::addTime(Stage stage, qint64 nsecs)
+{
+    stageNsecs[stage].fetchAndAddRelaxed(nsecs);
+}
+
+void PoolStatistics::recordOutput(qint32 _itemsWritten, qint32 pendingItems)
+{
+    if (!enabled) {
+        return;
+    }
+
+    itemsWritten += _itemsWritten;
+    outputSamples++;
+    totalPendingItems += pendingItems;
+    currentPendingItems = pendingItems;
+    maxPendingItems = qMax(maxPendingItems, pendingItems);
+
+    // The caller holds the output mutex, so we can write the JSON file here
+    // without any further locking
+    if (jsonFile.isOpen() && totalTimer.nsecsElapsed() - lastJsonNsecs >= JSON_INTERVAL_NSECS) {
+        writeJsonLine();
+    }
+}
+
+// Write the statistics so far to the JSON file, as a single line
+void PoolStatistics::writeJsonLine()
+{
+    lastJsonNsecs = totalTimer.nsecsElapsed();
+    const double elapsedSecs = lastJsonNsecs / 1.0e9;
+
+    QJsonObject stageSecs;
+    for (qint32 stage = 0; stage < numStages; stage++) {
+        stageSecs[STAGE_NAMES[stage]] = stageNsecs[stage].load() / 1.0e9;
+    }
+
+    QJsonObject reorderBuffer;
+    reorderBuffer["current"] = currentPendingItems;
+    reorderBuffer["mean"] = (outputSamples > 0) ? static_cast<double>(totalPendingItems) / outputSamples : 0.0;
+    reorderBuffer["max"] = maxPendingItems;
+
+    QJsonObject line;
+    line["elapsedSecs"] = elapsedSecs;
+    line["threads"] = numThreads;
+    line["items"] = itemsWritten;
+    line["itemsPerSec"] = (elapsedSecs > 0.0) ? itemsWritten / elapsedSecs : 0.0;
+    line["stageSecs"] = stageSecs;
+    line["reorderBuffer"] = reorderBuffer;
+
+    jsonFile.write(QJsonDocument(line).toJson(QJsonDocument::Compact));
+    jsonFile.write("\n");
+    jsonFile.flush();
+}
+
+PoolStatistics::Timer::Timer(PoolStatistics &_statistics, Stage _stage)
+    : statistics(_statistics), stage(_stage)
+{
+    if (statistics.isEnabled()) {
+        timer.start();
+    }
+}
+
+PoolStatistics::Timer::~Timer()
+{
+    stop();
+}
+
+void PoolStatistics::Timer::stop()
+{
+    if (timer.isValid()) {
+        statistics.addTime(stage, timer.nsecsElapsed());
+        timer.invalidate();
+    }
+}
+
+// Method to add the standard statistics options to the command line parser
+void addStandardStatisticsOptions(QCommandLineParser &parser)
+{
+    // Option to show timing statistics (--stats)
+    parser.addOption(showStatisticsOption);
+
+    // Option to write statistics as JSON lines (--stats-json)
+    parser.addOption(statisticsJsonOption);
+}
+
+// Method to process the standard statistics options
+bool processStandardStatisticsOptions(QCommandLineParser &parser, PoolStatistics &statistics)
+{
+    if (parser.isSet(statisticsJsonOption)) {
+        return statistics.enable(parser.value(statisticsJsonOption));
+    } else if (parser.isSet(showStatisticsOption)) {
+        return statistics.enable();
+    }
+
+    return true;
+}
@@ -0,0 +1,121 @@
+/************************************************************************
+
+    poolstatistics.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef POOLSTATISTICS_H
+#define POOLSTATISTICS_H
+
+#include <QAtomicInteger>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+
+// Timing statistics for the worker pools (ld-chroma-decoder's DecoderPool,
+// ld-dropout-correct's CorrectorPool, and ld-process-vbi's DecoderPool).
+//
+// The pool and its workers add up the time they spend in each stage of
+// processing, summed across all the threads, and the pool records how many
+// items are waiting in its reorder buffer each time it writes output. At the
+// end of processing, a summary is printed; optionally, the statistics so far
+// can also be written as a line of JSON to a file every second.
+//
+// Collection is disabled by default, in which case the only cost is checking
+// a flag in each Timer.
+class PoolStatistics
+{
+public:
+    enum Stage {
+        inputWaitStage = 0,     // Waiting to acquire the input mutex
+        readStage,              // Reading input data
+        processStage,           // Processing (in the worker threads)
+        outputWaitStage,        // Waiting to acquire the output mutex
+        writeStage,             // Writing output data
+        numStages
+    };
+
+    PoolStatistics();
+
+    // Enable collection. If jsonFileName is not empty, JSON lines will be
+    // written to it while processing.
+    // Returns true on success; on failure, prints a message and returns false.
+    bool enable(const QString &jsonFileName = QString());
+    bool isEnabled() const;
+
+    // For the pool: reset the statistics at the start of processing
+    void start(qint32 numThreads);
+
+    // For the pool: print a summary at the end of processing, describing
+    // items as itemName (e.g. "frames")
+    void finish(const char *itemName);
+
+    // Add time spent in a stage. This may be called from any thread.
+    void addTime(Stage stage, qint64 nsecs);
+
+    // For the pool: record that itemsWritten items have been written, leaving
+    // pendingItems waiting in the reorder buffer. This must be called with the
+    // pool's output mutex held.
+    void recordOutput(qint32 itemsWritten, qint32 pendingItems);
+
+    // Time a stage, from construction until stop() is called or the Timer is
+    // destroyed
+    class Timer {
+    public:
+        Timer(PoolStatistics &statistics, Stage stage);
+        ~Timer();
+        void stop();
+
+    private:
+        PoolStatistics &statistics;
+        Stage stage;
+        QElapsedTimer timer;
+    };
+
+private:
+    void writeJsonLine();
+
+    bool enabled;
+    QFile jsonFile;
+    qint32 numThreads;
+    QElapsedTimer totalTimer;
+    qint64 lastJsonNsecs;
+
+    // Per-stage totals, updated by all threads
+    QAtomicInteger<qint64> stageNsecs[numStages];
+
+    // Reorder buffer statistics (guarded by the pool's output mutex)
+    qint64 itemsWritten;
+    qint64 outputSamples;
+    qint64 totalPendingItems;
+    qint32 currentPendingItems;
+    qint32 maxPendingItems;
+};
+
+// Add the standard statistics options to the command line parser
+void addStandardStatisticsOptions(QCommandLineParser &parser);
+
+// Process the standard statistics options, enabling statistics if requested.
+// Returns true on success; on failure, prints a message and returns false.
+bool processStandardStatisticsOptions(QCommandLineParser &parser, PoolStatistics &statistics);
+
+#endif // POOLSTATISTICS_H
@@ -0,0 +1,119 @@
+/************************************************************************
+
+    sidecarcache.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "sidecarcache.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+
+SidecarCache::SidecarCache(quint32 _magic, quint32 _version)
+    : magic(_magic), version(_version)
+{
+}
+
+QByteArray SidecarCache::hashFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) return QByteArray();
+
+    return hash.result();
+}
+
+QByteArray SidecarCache::makeKey(const QByteArray &metadataHash, const QByteArray &settings)
+{
+    if (metadataHash.isEmpty()) return QByteArray();
+
+    return metadataHash + settings;
+}
+
+bool SidecarCache::openRead(const QString &cacheFileName, const QByteArray &key)
+{
+    if (key.isEmpty()) return false;
+
+    cacheFile.setFileName(cacheFileName);
+    if (!cacheFile.open(QIODevice::ReadOnly)) return false;
+
+    dataStream.setDevice(&cacheFile);
+    dataStream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 fileMagic, fileVersion;
+    QByteArray fileKey;
+    dataStream >> fileMagic >> fileVersion;
+    if (dataStream.status() != QDataStream::Ok || fileMagic != magic || fileVersion != version) {
+        cacheFile.close();
+        return false;
+    }
+
+    dataStream >> fileKey;
+    if (fileKey != key) {
+        qDebug() << "SidecarCache::openRead(): Cache" << cacheFileName << "is out of date";
+        cacheFile.close();
+        return false;
+    }
+
+    return true;
+}
+
+bool SidecarCache::finishRead(bool contentsValid)
+{
+    const bool success = contentsValid && dataStream.status() == QDataStream::Ok;
+    if (!success) {
+        qDebug() << "SidecarCache::finishRead(): Cache" << cacheFile.fileName() << "is corrupt";
+    }
+
+    dataStream.setDevice(nullptr);
+    cacheFile.close();
+    return success;
+}
+
+bool SidecarCache::openWrite(const QString &cacheFileName, const QByteArray &key)
+{
+    if (key.isEmpty()) return false;
+
+    cacheFile.setFileName(cacheFileName);
+    if (!cacheFile.open(QIODevice::WriteOnly)) return false;
+
+    dataStream.setDevice(&cacheFile);
+    dataStream.setVersion(QDataStream::Qt_5_0);
+
+    dataStream << magic << version << key;
+    return true;
+}
+
+bool SidecarCache::finishWrite()
+{
+    const bool success = dataStream.status() == QDataStream::Ok;
+
+    dataStream.setDevice(nullptr);
+    cacheFile.close();
+    return success && cacheFile.error() == QFileDevice::NoError;
+}
+
+QDataStream &SidecarCache::stream()
+{
+    return dataStream;
+}
@@ -0,0 +1,80 @@
+/************************************************************************
+
+    sidecarcache.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef SIDECARCACHE_H
+#define SIDECARCACHE_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QString>
+
+// A cache file of data derived from a JSON metadata file, stored next to it
+// (used by VbiFrameIndex and ld-analyse's TbcSource).
+//
+// The file starts with a magic number and version identifying the kind of
+// cache, followed by a key; the cached data follows as a QDataStream. The key
+// is normally made with makeKey from a hash of the metadata (see hashFile),
+// so the cache is rebuilt automatically if the metadata changes.
+class SidecarCache
+{
+public:
+    SidecarCache(quint32 magic, quint32 version);
+
+    // Hash the contents of a file. Returns an empty hash if the file can't be
+    // read. Callers opening several caches for the same metadata should hash
+    // it once and reuse the result.
+    static QByteArray hashFile(const QString &fileName);
+
+    // Make a key from a metadata hash and any other settings the cached data
+    // depends on. Returns an empty key if the hash is empty.
+    static QByteArray makeKey(const QByteArray &metadataHash, const QByteArray &settings);
+
+    // Open a cache file for reading, and check its header and key.
+    // Returns false if the file doesn't exist, isn't this kind of cache, or is
+    // out of date.
+    bool openRead(const QString &cacheFileName, const QByteArray &key);
+
+    // Finish reading. contentsValid is the caller's check of the data it read.
+    // Returns false (and reports the cache as corrupt) if reading failed.
+    bool finishRead(bool contentsValid = true);
+
+    // Create a cache file and write its header.
+    // Returns false if the file can't be written.
+    bool openWrite(const QString &cacheFileName, const QByteArray &key);
+
+    // Finish writing. Returns false if writing failed.
+    bool finishWrite();
+
+    // The stream to read or write the cached data with, once opened
+    QDataStream &stream();
+
+private:
+    quint32 magic;
+    quint32 version;
+    QFile cacheFile;
+    QDataStream dataStream;
+};
+
+#endif // SIDECARCACHE_H
@@ -98,6 +98,43 @@ bool SourceVideo::open(QString filename, qint32 _fieldLength, qint32 _fieldLineL
     return true;
 }
 
+// Use a set of fields held in memory (e.g. generated test data) as the
+// source video, rather than reading a file. The fields must all be the same
+// length. Returns true on success.
+bool SourceVideo::open(const QVector<Data> &_memoryFields, qint32 _fieldLineLength)
+{
+    if (isSourceVideoOpen) {
+        qInfo() << "A source video input file is already open, cannot open a new one";
+        return false;
+    }
+
+    if (_memoryFields.isEmpty()) {
+        qWarning() << "Cannot open an empty set of fields as source video";
+        return false;
+    }
+
+    for (const Data &field : _memoryFields) {
+        if (field.size() != _memoryFields[0].size()) {
+            qWarning() << "Cannot open fields of different lengths as source video";
+            return false;
+        }
+    }
+
+    memoryFields = _memoryFields;
+    fieldLength = memoryFields[0].size();
+    fieldByteLength = fieldLength * 2;
+    if (_fieldLineLength != -1) {
+        fieldLineLength = _fieldLineLength * 2;
+    } else fieldLineLength = -1;
+    availableFields = memoryFields.size();
+    qDebug() << "SourceVideo::open(): Using" << availableFields << "fields from memory";
+
+    isSourceVideoOpen = true;
+    inputFilePos = -1;
+
+    return true;
+}
+
 // Close an input video data file
 void SourceVideo::close()
 {
@@ -108,6 +145,7 @@ void SourceVideo::close()
 
     qDebug() << "SourceVideo::close(): Called, closing the source video file and emptying the frame cache";
     inputFile.close();
+    memoryFields.clear();
     isSourceVideoOpen = false;
     inputFilePos = -1;
 
@@ -145,6 +183,25 @@ SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFie
     // Ensure source video is open
     if (!isSourceVideoOpen) qFatal("Application requested TBC field before opening TBC file - Fatal error");
 
+    // Fields held in memory can be returned directly (sharing their data)
+    if (!memoryFields.isEmpty()) {
+        if (fieldNumber < 0 || fieldNumber >= memoryFields.size()) {
+            qFatal("Application requested field that exceeds the boundaries of the input TBC data");
+        }
+        if (startFieldLine == -1 && endFieldLine == -1) return memoryFields[fieldNumber];
+
+        // Verify the required range, as for a file
+        if (fieldLineLength == -1) qFatal("Application did not set field line length when opening TBC file");
+        const qint32 fieldLineSamples = fieldLineLength / 2;
+        if (startFieldLine < 1) qFatal("Application requested out-of-bounds field line");
+        if (static_cast<qint64>(endFieldLine) * fieldLineSamples > fieldLength) {
+            qFatal("Application requested field line range that exceeds the boundaries of the input TBC data");
+        }
+
+        return memoryFields[fieldNumber].mid((startFieldLine - 1) * fieldLineSamples,
+                                             (endFieldLine - startFieldLine + 1) * fieldLineSamples);
+    }
+
     // Calculate the position of the require field line data
     qint64 requiredStartPosition = static_cast<qint64>(fieldByteLength) * static_cast<qint64>(fieldNumber);
     qint64 requiredReadLength;
@@ -171,6 +228,13 @@ SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFie
 
         requiredStartPosition += static_cast<qint64>(fieldLineLength) * static_cast<qint64>(startFieldLine);
         requiredReadLength = static_cast<qint64>(endFieldLine - startFieldLine + 1) * static_cast<qint64>(fieldLineLength);
+
+        // If the whole field is in the cache, take the lines from there instead
+        if (fieldCache.contains(fieldNumber)) {
+            const qint32 fieldLineSamples = fieldLineLength / 2;
+            return fieldCache.object(fieldNumber)->mid(startFieldLine * fieldLineSamples,
+                                                       (endFieldLine - startFieldLine + 1) * fieldLineSamples);
+        }
     }
 
     // Check the requested field and lines are valid
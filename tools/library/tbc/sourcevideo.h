@@ -48,6 +48,7 @@ public:
 
     // File handling methods
     bool open(QString filename, qint32 _fieldLength, qint32 _fieldLineLength = -1);
+    bool open(const QVector<Data> &_memoryFields, qint32 _fieldLineLength = -1);
     void close(void);
 
     // Field handling methods
@@ -70,6 +71,9 @@ private:
 
     Data outputFieldData;
 
+    // Fields held in memory, rather than read from inputFile
+    QVector<Data> memoryFields;
+
     // Field caching
     QCache<qint32, Data> fieldCache;
 };
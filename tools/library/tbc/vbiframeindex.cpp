@@ -0,0 +1,353 @@
+/************************************************************************
+
+    vbiframeindex.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "vbiframeindex.h"
+#include "vbidecoder.h"
+#include "sidecarcache.h"
+
+// Sidecar cache file identification
+static const quint32 CACHE_MAGIC = 0x56424958; // "VBIX"
+static const quint32 CACHE_VERSION = 2;
+
+VbiFrameIndex::VbiFrameIndex()
+{
+    clear();
+}
+
+// Build the index for the source described by ldDecodeMetaData.
+//
+// If jsonFileName is specified, the index is read from the sidecar cache for
+// that metadata file if it is up to date; otherwise the VBI is decoded and the
+// cache is written for next time. If the caller has already hashed the
+// metadata file with SidecarCache::hashFile, it can pass the hash as
+// metadataHash to save hashing it again.
+//
+// Returns false if the source has no valid CAV picture numbers or CLV time-codes.
+bool VbiFrameIndex::build(LdDecodeMetaData &ldDecodeMetaData, const QString &jsonFileName,
+                          const QByteArray &metadataHash)
+{
+    clear();
+    isFirstFieldFirst = ldDecodeMetaData.getIsFirstFieldFirst();
+
+    QByteArray cacheKey;
+    if (!jsonFileName.isEmpty()) {
+        cacheKey = getCacheKey(metadataHash.isEmpty() ? SidecarCache::hashFile(jsonFileName) : metadataHash);
+    }
+
+    if (!cacheKey.isEmpty() && readCache(jsonFileName + ".vbiindex", cacheKey)
+            && pictureNumbers.size() == ldDecodeMetaData.getNumberOfFrames()) {
+        qDebug() << "VbiFrameIndex::build(): Using cached VBI frame index for" << jsonFileName;
+    } else {
+        qDebug() << "VbiFrameIndex::build(): Decoding VBI for" << ldDecodeMetaData.getNumberOfFrames() << "frames";
+        decodeFrames(ldDecodeMetaData);
+
+        if (!cacheKey.isEmpty() && !writeCache(jsonFileName + ".vbiindex", cacheKey)) {
+            qDebug() << "VbiFrameIndex::build(): Could not write VBI frame index cache for" << jsonFileName;
+        }
+    }
+
+    buildTables();
+
+    qDebug() << "VbiFrameIndex::build(): Got" << cavCount << "CAV picture codes and" << clvCount << "CLV timecodes";
+    return isValid();
+}
+
+// Write the index to the sidecar cache for a metadata file.
+// This is used to keep the cache valid when a tool rewrites the metadata
+// without changing the VBI (e.g. to update the dropouts).
+bool VbiFrameIndex::saveCache(const QString &jsonFileName)
+{
+    QByteArray cacheKey = getCacheKey(SidecarCache::hashFile(jsonFileName));
+    if (cacheKey.isEmpty()) return false;
+
+    return writeCache(jsonFileName + ".vbiindex", cacheKey);
+}
+
+// Reset the index to empty
+void VbiFrameIndex::clear()
+{
+    pictureNumbers.clear();
+    clvFrameNumbers.clear();
+    chapterNumbers.clear();
+    frameFlags.clear();
+
+    cavCount = 0;
+    clvCount = 0;
+    discCav = false;
+    minimumVbiFrameNumber = -1;
+    maximumVbiFrameNumber = -1;
+    vbiFrameNumbers.clear();
+    sequentialFrameNumbers.clear();
+
+    isFirstFieldFirst = true;
+}
+
+// Returns true if the source contains valid CAV picture numbers or CLV time-codes
+bool VbiFrameIndex::isValid() const
+{
+    return cavCount != 0 || clvCount != 0;
+}
+
+// Returns true if the disc type is CAV (false if it is CLV)
+bool VbiFrameIndex::isDiscCav() const
+{
+    return discCav;
+}
+
+// Get the number of frames with a valid CAV picture number
+qint32 VbiFrameIndex::getCavCount() const
+{
+    return cavCount;
+}
+
+// Get the number of frames with a valid CLV time-code
+qint32 VbiFrameIndex::getClvCount() const
+{
+    return clvCount;
+}
+
+qint32 VbiFrameIndex::getNumberOfFrames() const
+{
+    return pictureNumbers.size();
+}
+
+// Get the lowest VBI frame number in the source (-1 if the index is not valid)
+qint32 VbiFrameIndex::getMinimumVbiFrameNumber() const
+{
+    return minimumVbiFrameNumber;
+}
+
+// Get the highest VBI frame number in the source (-1 if the index is not valid)
+qint32 VbiFrameIndex::getMaximumVbiFrameNumber() const
+{
+    return maximumVbiFrameNumber;
+}
+
+// Get the VBI frame number for a sequential frame.
+// Frames without a valid frame number (such as padding) are numbered on from
+// the neighbouring frames. Returns -1 if there is no frame number.
+qint32 VbiFrameIndex::getVbiFrameNumber(qint32 sequentialFrameNumber) const
+{
+    if (sequentialFrameNumber < 1 || sequentialFrameNumber > vbiFrameNumbers.size()) return -1;
+    return vbiFrameNumbers[sequentialFrameNumber - 1];
+}
+
+// Get the sequential frame number for a VBI frame number.
+// Returns -1 if the VBI frame number is outside the range of the source.
+qint32 VbiFrameIndex::getSequentialFrameNumber(qint32 vbiFrameNumber) const
+{
+    if (!isValid() || vbiFrameNumber < minimumVbiFrameNumber || vbiFrameNumber > maximumVbiFrameNumber) return -1;
+    return sequentialFrameNumbers[vbiFrameNumber - minimumVbiFrameNumber];
+}
+
+// Get the decoded CAV picture number for a sequential frame (or -1 if none)
+qint32 VbiFrameIndex::getPictureNumber(qint32 sequentialFrameNumber) const
+{
+    if (sequentialFrameNumber < 1 || sequentialFrameNumber > pictureNumbers.size()) return -1;
+    return pictureNumbers[sequentialFrameNumber - 1];
+}
+
+// Get the decoded CLV time-code for a sequential frame, as a frame number (or -1 if none)
+qint32 VbiFrameIndex::getClvFrameNumber(qint32 sequentialFrameNumber) const
+{
+    if (sequentialFrameNumber < 1 || sequentialFrameNumber > clvFrameNumbers.size()) return -1;
+    return clvFrameNumbers[sequentialFrameNumber - 1];
+}
+
+// Get the decoded chapter number for a sequential frame (or -1 if none)
+qint32 VbiFrameIndex::getChapterNumber(qint32 sequentialFrameNumber) const
+{
+    if (sequentialFrameNumber < 1 || sequentialFrameNumber > chapterNumbers.size()) return -1;
+    return chapterNumbers[sequentialFrameNumber - 1];
+}
+
+// Returns true if the VBI marks a sequential frame as lead-in or lead-out
+bool VbiFrameIndex::isLeadInOrOut(qint32 sequentialFrameNumber) const
+{
+    if (sequentialFrameNumber < 1 || sequentialFrameNumber > frameFlags.size()) return false;
+    return (frameFlags[sequentialFrameNumber - 1] & leadInOrOutFlag) != 0;
+}
+
+// Returns true if both fields of a sequential frame are padding (i.e. missing from the source)
+bool VbiFrameIndex::isPadded(qint32 sequentialFrameNumber) const
+{
+    if (sequentialFrameNumber < 1 || sequentialFrameNumber > frameFlags.size()) return false;
+    return (frameFlags[sequentialFrameNumber - 1] & paddedFlag) != 0;
+}
+
+// Private methods ----------------------------------------------------------------------------------------------------
+
+// Decode the VBI for every frame in the source
+void VbiFrameIndex::decodeFrames(LdDecodeMetaData &ldDecodeMetaData)
+{
+    VbiDecoder vbiDecoder;
+    qint32 numberOfFrames = ldDecodeMetaData.getNumberOfFrames();
+
+    pictureNumbers.resize(numberOfFrames);
+    clvFrameNumbers.resize(numberOfFrames);
+    chapterNumbers.resize(numberOfFrames);
+    frameFlags.resize(numberOfFrames);
+
+    // Using sequential frame numbering starting from 1
+    for (qint32 seqFrame = 1; seqFrame <= numberOfFrames; seqFrame++) {
+        LdDecodeMetaData::Field firstField = ldDecodeMetaData.getField(ldDecodeMetaData.getFirstFieldNumber(seqFrame));
+        LdDecodeMetaData::Field secondField = ldDecodeMetaData.getField(ldDecodeMetaData.getSecondFieldNumber(seqFrame));
+
+        // Decode the VBI (fields without VBI data decode as all invalid)
+        VbiDecoder::Vbi vbi;
+        const QVector<qint32> &vbi1 = firstField.vbi.vbiData;
+        const QVector<qint32> &vbi2 = secondField.vbi.vbiData;
+        if (vbi1.size() >= 3 && vbi2.size() >= 3) {
+            vbi = vbiDecoder.decodeFrame(vbi1[0], vbi1[1], vbi1[2], vbi2[0], vbi2[1], vbi2[2]);
+        }
+
+        LdDecodeMetaData::ClvTimecode timecode;
+        timecode.hours = vbi.clvHr;
+        timecode.minutes = vbi.clvMin;
+        timecode.seconds = vbi.clvSec;
+        timecode.pictureNumber = vbi.clvPicNo;
+
+        pictureNumbers[seqFrame - 1] = vbi.picNo > 0 ? vbi.picNo : -1;
+        clvFrameNumbers[seqFrame - 1] = ldDecodeMetaData.convertClvTimecodeToFrameNumber(timecode);
+        chapterNumbers[seqFrame - 1] = vbi.chNo;
+
+        quint8 flags = 0;
+        if (vbi.leadIn || vbi.leadOut) flags |= leadInOrOutFlag;
+        if (firstField.pad && secondField.pad) flags |= paddedFlag;
+        frameFlags[seqFrame - 1] = flags;
+    }
+}
+
+// Determine the disc type and build the frame number mapping tables from the decoded VBI
+void VbiFrameIndex::buildTables()
+{
+    qint32 numberOfFrames = pictureNumbers.size();
+
+    // Count how many frames are marked as CAV or CLV
+    cavCount = 0;
+    clvCount = 0;
+    for (qint32 i = 0; i < numberOfFrames; i++) {
+        if (pictureNumbers[i] != -1) cavCount++;
+        if (clvFrameNumbers[i] != -1) clvCount++;
+    }
+
+    vbiFrameNumbers.fill(-1, numberOfFrames);
+    sequentialFrameNumbers.clear();
+    minimumVbiFrameNumber = -1;
+    maximumVbiFrameNumber = -1;
+    if (!isValid()) return;
+
+    // Determine disc type, and use the matching frame numbers
+    discCav = cavCount > clvCount;
+    const QVector<qint32> &frameNumbers = discCav ? pictureNumbers : clvFrameNumbers;
+
+    // Find the VBI frame number range
+    for (qint32 i = 0; i < numberOfFrames; i++) {
+        if (frameNumbers[i] == -1) continue;
+        if (minimumVbiFrameNumber == -1 || frameNumbers[i] < minimumVbiFrameNumber) minimumVbiFrameNumber = frameNumbers[i];
+        if (maximumVbiFrameNumber == -1 || frameNumbers[i] > maximumVbiFrameNumber) maximumVbiFrameNumber = frameNumbers[i];
+    }
+
+    // Map the frames with valid VBI both ways (if a VBI frame number appears
+    // more than once, the first occurrence is used)
+    sequentialFrameNumbers.fill(-1, maximumVbiFrameNumber - minimumVbiFrameNumber + 1);
+    for (qint32 i = 0; i < numberOfFrames; i++) {
+        if (frameNumbers[i] == -1) continue;
+        vbiFrameNumbers[i] = frameNumbers[i];
+        if (sequentialFrameNumbers[frameNumbers[i] - minimumVbiFrameNumber] == -1) {
+            sequentialFrameNumbers[frameNumbers[i] - minimumVbiFrameNumber] = i + 1;
+        }
+    }
+
+    // Fill in the gaps by counting on from the previous mapped frame (or back
+    // from the next one, at the start). For a mapped source this makes the
+    // mapping a simple offset, including for any padded frames.
+    qint32 lastKnown = -1;
+    for (qint32 i = 0; i < numberOfFrames; i++) {
+        if (frameNumbers[i] != -1) {
+            if (lastKnown == -1) {
+                for (qint32 j = 0; j < i; j++) vbiFrameNumbers[j] = vbiFrameNumbers[i] - (i - j);
+            }
+            lastKnown = i;
+        } else if (lastKnown != -1) {
+            vbiFrameNumbers[i] = vbiFrameNumbers[lastKnown] + (i - lastKnown);
+        }
+    }
+
+    lastKnown = -1;
+    for (qint32 i = 0; i < sequentialFrameNumbers.size(); i++) {
+        if (sequentialFrameNumbers[i] != -1) {
+            if (lastKnown == -1) {
+                for (qint32 j = 0; j < i; j++) {
+                    qint32 seqFrame = sequentialFrameNumbers[i] - (i - j);
+                    if (seqFrame >= 1) sequentialFrameNumbers[j] = seqFrame;
+                }
+            }
+            lastKnown = i;
+        } else if (lastKnown != -1) {
+            qint32 seqFrame = sequentialFrameNumbers[lastKnown] + (i - lastKnown);
+            if (seqFrame <= numberOfFrames) sequentialFrameNumbers[i] = seqFrame;
+        }
+    }
+}
+
+// Generate the key for the cache of a metadata file from the hash of its
+// contents; the key also includes the field order. Returns an empty key if
+// the metadata file couldn't be read.
+QByteArray VbiFrameIndex::getCacheKey(const QByteArray &metadataHash) const
+{
+    return SidecarCache::makeKey(metadataHash, isFirstFieldFirst ? "1" : "0");
+}
+
+// Read the decoded VBI from a cache file; returns false if the cache doesn't
+// exist, can't be read or is out of date
+bool VbiFrameIndex::readCache(const QString &cacheFileName, const QByteArray &cacheKey)
+{
+    SidecarCache cache(CACHE_MAGIC, CACHE_VERSION);
+    if (!cache.openRead(cacheFileName, cacheKey)) return false;
+
+    cache.stream() >> pictureNumbers >> clvFrameNumbers >> chapterNumbers >> frameFlags;
+    if (!cache.finishRead(clvFrameNumbers.size() == pictureNumbers.size()
+                          && chapterNumbers.size() == pictureNumbers.size()
+                          && frameFlags.size() == pictureNumbers.size())) {
+        pictureNumbers.clear();
+        clvFrameNumbers.clear();
+        chapterNumbers.clear();
+        frameFlags.clear();
+        return false;
+    }
+
+    return true;
+}
+
+// Write the decoded VBI to a cache file
+bool VbiFrameIndex::writeCache(const QString &cacheFileName, const QByteArray &cacheKey) const
+{
+    SidecarCache cache(CACHE_MAGIC, CACHE_VERSION);
+    if (!cache.openWrite(cacheFileName, cacheKey)) return false;
+
+    cache.stream() << pictureNumbers << clvFrameNumbers << chapterNumbers << frameFlags;
+
+    return cache.finishWrite();
+}
@@ -0,0 +1,106 @@
+/************************************************************************
+
+    vbiframeindex.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2020 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef VBIFRAMEINDEX_H
+#define VBIFRAMEINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QDebug>
+
+#include "lddecodemetadata.h"
+
+// Index of the decoded VBI frame numbers for a TBC source.
+//
+// The VBI for every frame is decoded once, the disc type (CAV/CLV) is
+// determined, and a dense table mapping VBI frame numbers to sequential frame
+// numbers (and back) is built. As building the index means decoding the VBI
+// for the whole source, the result is cached in a sidecar file next to the
+// JSON metadata (see SidecarCache); the cache is keyed by a hash of the
+// metadata, so it is rebuilt automatically if the metadata changes.
+//
+// Sequential frame numbers start from 1 (as in LdDecodeMetaData).
+class VbiFrameIndex
+{
+public:
+    VbiFrameIndex();
+
+    bool build(LdDecodeMetaData &ldDecodeMetaData, const QString &jsonFileName = QString(),
+               const QByteArray &metadataHash = QByteArray());
+    bool saveCache(const QString &jsonFileName);
+    void clear();
+
+    // Source information
+    bool isValid() const;
+    bool isDiscCav() const;
+    qint32 getCavCount() const;
+    qint32 getClvCount() const;
+    qint32 getNumberOfFrames() const;
+    qint32 getMinimumVbiFrameNumber() const;
+    qint32 getMaximumVbiFrameNumber() const;
+
+    // Frame number mapping
+    qint32 getVbiFrameNumber(qint32 sequentialFrameNumber) const;
+    qint32 getSequentialFrameNumber(qint32 vbiFrameNumber) const;
+
+    // Decoded VBI for a sequential frame
+    qint32 getPictureNumber(qint32 sequentialFrameNumber) const;
+    qint32 getClvFrameNumber(qint32 sequentialFrameNumber) const;
+    qint32 getChapterNumber(qint32 sequentialFrameNumber) const;
+    bool isLeadInOrOut(qint32 sequentialFrameNumber) const;
+    bool isPadded(qint32 sequentialFrameNumber) const;
+
+private:
+    enum FrameFlags {
+        leadInOrOutFlag = 1,
+        paddedFlag = 2
+    };
+
+    // Decoded VBI for each frame (index is sequential frame number - 1)
+    QVector<qint32> pictureNumbers;
+    QVector<qint32> clvFrameNumbers;
+    QVector<qint32> chapterNumbers;
+    QVector<quint8> frameFlags;
+
+    // Derived information
+    qint32 cavCount;
+    qint32 clvCount;
+    bool discCav;
+    qint32 minimumVbiFrameNumber;
+    qint32 maximumVbiFrameNumber;
+    QVector<qint32> vbiFrameNumbers;
+    QVector<qint32> sequentialFrameNumbers;
+
+    // The field order the index was built for (part of the cache key)
+    bool isFirstFieldFirst;
+
+    void decodeFrames(LdDecodeMetaData &ldDecodeMetaData);
+    void buildTables();
+    QByteArray getCacheKey(const QByteArray &metadataHash) const;
+    bool readCache(const QString &cacheFileName, const QByteArray &cacheKey);
+    bool writeCache(const QString &cacheFileName, const QByteArray &cacheKey) const;
+};
+
+#endif // VBIFRAMEINDEX_H